@@ -1,6 +1,8 @@
 #pragma once
 
 #include <vector>
+#include <algorithm>
+#include <cstdint>
 #include <GLFW/glfw3.h>
 
 // smoothly moves a value from a to b
@@ -12,13 +14,30 @@ float lerp(float start, float end, float t)
 class Animator
 {
 public:
-    Animator() : animating(false), duration(0.4) {}
+    Animator() : animating(false), duration(0.4), end_positions(nullptr), moving_nodes(nullptr), quantized(false), quantum_origin({0.0f, 0.0f}), quantum({0.0f, 0.0f}) {}
 
-    // kicks off the animation, remembers where things start and end
-    void startAnimation(const std::vector<Point> &start_poses, const std::vector<Point> &end_poses)
+    // keeps the start positions in 16 bits a coordinate across the box they span, a quarter
+    // of the floats. they only ever get blended towards the exact ends, so the rounding fades
+    // out as the animation runs, and it starts under a pixel on anything up to 65k pixels wide
+    void setQuantized(bool q) { quantized = q; }
+
+    // kicks off the animation, copies where things start and remembers where they end. if
+    // nodes is given only those get moved. the ends and nodes have to stay alive until the
+    // animation is done, they are the layout's own arrays so that costs nothing
+    void startAnimation(const std::vector<Point> &start_poses, const std::vector<Point> &end_poses, const std::vector<int> *nodes = nullptr)
     {
-        start_positions = start_poses;
-        end_positions = end_poses;
+        if (quantized)
+        {
+            std::vector<Point>().swap(start_positions);
+            quantize(start_poses, nodes);
+        }
+        else
+        {
+            std::vector<uint16_t>().swap(start_quantized);
+            start_positions = start_poses;
+        }
+        end_positions = &end_poses;
+        moving_nodes = nodes;
         startTime = glfwGetTime();
         animating = true;
     }
@@ -43,26 +62,107 @@ public:
         }
 
         // moves each node to its new spot for this frame
-        for (size_t i = 0; i < current_positions.size(); ++i)
+        const std::vector<Point> &end = *end_positions;
+        if (moving_nodes)
+        {
+            for (int i : *moving_nodes)
+            {
+                Point start = startOf(i);
+                current_positions[i].x = lerp(start.x, end[i].x, progress);
+                current_positions[i].y = lerp(start.y, end[i].y, progress);
+            }
+        }
+        else
         {
-            current_positions[i].x = lerp(start_positions[i].x, end_positions[i].x, progress);
-            current_positions[i].y = lerp(start_positions[i].y, end_positions[i].y, progress);
+            for (size_t i = 0; i < current_positions.size(); ++i)
+            {
+                Point start = startOf(i);
+                current_positions[i].x = lerp(start.x, end[i].x, progress);
+                current_positions[i].y = lerp(start.y, end[i].y, progress);
+            }
         }
 
         // snap everything to the final spot after animation is done to be sure
         if (!animating)
         {
-            current_positions = end_positions;
+            if (moving_nodes)
+            {
+                for (int i : *moving_nodes)
+                    current_positions[i] = end[i];
+            }
+            else
+            {
+                current_positions = end;
+            }
         }
     }
 
     // check to see if currently animating
     bool isAnimating() const { return animating; }
 
+    size_t memoryUsage() const
+    {
+        return start_positions.capacity() * sizeof(Point) + start_quantized.capacity() * sizeof(uint16_t);
+    }
+
 private:
+    Point startOf(size_t i) const
+    {
+        if (!quantized)
+            return start_positions[i];
+        return {quantum_origin.x + start_quantized[2 * i] * quantum.x, quantum_origin.y + start_quantized[2 * i + 1] * quantum.y};
+    }
+
+    // the box around the nodes that move, split into 65535 steps each way
+    void quantize(const std::vector<Point> &positions, const std::vector<int> *nodes)
+    {
+        Point low = {0.0f, 0.0f}, high = {0.0f, 0.0f};
+        bool first = true;
+        auto grow = [&](Point p)
+        {
+            low = first ? p : Point{std::min(low.x, p.x), std::min(low.y, p.y)};
+            high = first ? p : Point{std::max(high.x, p.x), std::max(high.y, p.y)};
+            first = false;
+        };
+        if (nodes)
+        {
+            for (int i : *nodes)
+                grow(positions[i]);
+        }
+        else
+        {
+            for (const Point &p : positions)
+                grow(p);
+        }
+        quantum_origin = low;
+        quantum = {(high.x - low.x) / 65535.0f, (high.y - low.y) / 65535.0f};
+        start_quantized.resize(2 * positions.size());
+        auto store = [&](size_t i)
+        {
+            // rounding can land a hair past the last step, which would wrap around to 0
+            start_quantized[2 * i] = quantum.x > 0.0f ? static_cast<uint16_t>(std::min(65535.0f, (positions[i].x - low.x) / quantum.x + 0.5f)) : 0;
+            start_quantized[2 * i + 1] = quantum.y > 0.0f ? static_cast<uint16_t>(std::min(65535.0f, (positions[i].y - low.y) / quantum.y + 0.5f)) : 0;
+        };
+        if (nodes)
+        {
+            for (int i : *nodes)
+                store(i);
+        }
+        else
+        {
+            for (size_t i = 0; i < positions.size(); ++i)
+                store(i);
+        }
+    }
+
     bool animating;
     double startTime;
     double duration;
     std::vector<Point> start_positions;
-    std::vector<Point> end_positions;
+    const std::vector<Point> *end_positions;
+    const std::vector<int> *moving_nodes;
+    bool quantized;
+    // start positions as steps of quantum from quantum_origin, x and y interleaved
+    std::vector<uint16_t> start_quantized;
+    Point quantum_origin, quantum;
 };
\ No newline at end of file
@@ -0,0 +1,241 @@
+#pragma once
+
+#include "imgui.h"
+#include "edgeStream.h"
+#include "tree.h"
+#include "treeBuilder.h"
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <unordered_map>
+#include <unordered_set>
+
+// edge list editor that only builds the rows that are on screen and keeps edits as the
+// edges removed from the tree and the ones added to it, so its memory doesnt grow with the
+// tree. an edit that undoes an earlier one cancels it instead of piling up
+class EdgeListEditor
+{
+public:
+    EdgeListEditor() { deltaBuffer[0] = '\0'; }
+
+    void draw(const Tree &tree)
+    {
+        const auto &edges = tree.getEdges();
+        ImGui::Text("Edges: %d", static_cast<int>(edges.size()));
+
+        // only the visible rows are laid out by the clipper
+        ImGui::BeginChild("##EdgeRows", ImVec2(0.0f, ImGui::GetTextLineHeightWithSpacing() * 8), true);
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(edges.size()));
+        while (clipper.Step())
+        {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
+            {
+                const auto &edge = edges[row];
+                ImGui::PushID(row);
+                if (removed.count(edgeKey(edge.first, edge.second)))
+                {
+                    ImGui::TextDisabled("%d %d (removed)", edge.first, edge.second);
+                    ImGui::SameLine();
+                    if (ImGui::SmallButton("undo"))
+                        addEdge(tree, edge.first, edge.second);
+                }
+                else
+                {
+                    // editing a row turns into a remove plus an add
+                    int values[2] = {edge.first, edge.second};
+                    ImGui::SetNextItemWidth(ImGui::GetTextLineHeight() * 10);
+                    if (ImGui::InputInt2("##Edge", values, ImGuiInputTextFlags_EnterReturnsTrue))
+                    {
+                        if (values[0] != edge.first || values[1] != edge.second)
+                        {
+                            removeEdge(tree, edge.first, edge.second);
+                            addEdge(tree, values[0], values[1]);
+                        }
+                    }
+                    ImGui::SameLine();
+                    if (ImGui::SmallButton("x"))
+                        removeEdge(tree, edge.first, edge.second);
+                }
+                ImGui::PopID();
+            }
+        }
+        clipper.End();
+        ImGui::EndChild();
+
+        // the queued additions get their own list, they arent in the tree's edges yet
+        if (!added.empty())
+        {
+            ImGui::Text("Added: %d", static_cast<int>(added.size()));
+            ImGui::BeginChild("##AddedRows", ImVec2(0.0f, ImGui::GetTextLineHeightWithSpacing() * std::min<size_t>(added.size() + 1, 4)), true);
+            ImGuiListClipper added_clipper;
+            added_clipper.Begin(static_cast<int>(added.size()));
+            int drop = -1;
+            while (added_clipper.Step())
+            {
+                for (int row = added_clipper.DisplayStart; row < added_clipper.DisplayEnd; ++row)
+                {
+                    ImGui::PushID(row);
+                    ImGui::Text("+%d %d", added[row].first, added[row].second);
+                    ImGui::SameLine();
+                    if (ImGui::SmallButton("x"))
+                        drop = row;
+                    ImGui::PopID();
+                }
+            }
+            added_clipper.End();
+            ImGui::EndChild();
+            if (drop != -1)
+                removeEdge(tree, added[drop].first, added[drop].second);
+        }
+
+        // bulk edits go through a small fixed size box, one "+u v" or "-u v" per line
+        ImGui::Text("Add (+u v) / remove (-u v):");
+        ImGui::InputTextMultiline("##Deltas", deltaBuffer, IM_ARRAYSIZE(deltaBuffer), ImVec2(-1.0f, ImGui::GetTextLineHeight() * 3));
+        if (ImGui::Button("Queue Edits"))
+        {
+            parseDeltas(tree, deltaBuffer);
+            deltaBuffer[0] = '\0';
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Discard Edits"))
+        {
+            clear();
+        }
+        ImGui::SameLine();
+        ImGui::TextDisabled("%d pending", static_cast<int>(removed.size() + added.size()));
+    }
+
+    // the edits that are left, removals first and then the additions in the order they came
+    std::vector<EdgeDelta> getDeltas() const
+    {
+        std::vector<EdgeDelta> deltas;
+        deltas.reserve(removed.size() + added.size());
+        for (uint64_t k : removed)
+            deltas.push_back({false, static_cast<int>(k >> 32), static_cast<int>(k & 0xffffffffu)});
+        for (const auto &edge : added)
+            deltas.push_back({true, edge.first, edge.second});
+        return deltas;
+    }
+    void clear()
+    {
+        removed.clear();
+        added.clear();
+        added_index.clear();
+    }
+
+    // builds the edited tree in one pass over the old edges, safe to call off the ui thread.
+    // returns an empty tree and sets error if the result isnt a valid tree
+    static Tree applyDeltas(const Tree &base, int n, const std::vector<EdgeDelta> &deltas, std::string &error)
+    {
+        // later deltas win, so replay them in order into the remove and add sets
+        std::unordered_set<uint64_t> removed_keys, added_keys;
+        for (const auto &delta : deltas)
+        {
+            uint64_t k = edgeKey(delta.u, delta.v);
+            auto &from = delta.add ? removed_keys : added_keys;
+            auto &to = delta.add ? added_keys : removed_keys;
+            from.erase(k);
+            to.insert(k);
+        }
+
+        TreeBuilder builder(n);
+        builder.reserve(base.getEdges().size() + added_keys.size());
+        for (const auto &edge : base.getEdges())
+        {
+            if (!removed_keys.count(edgeKey(edge.first, edge.second)))
+                builder.addEdge(edge.first, edge.second);
+        }
+        // the additions keep the order they came in, an edge added twice only goes in once
+        for (const auto &delta : deltas)
+        {
+            if (delta.add && added_keys.erase(edgeKey(delta.u, delta.v)))
+                builder.addEdge(delta.u, delta.v);
+        }
+
+        Tree tree;
+        if (!builder.build(tree))
+        {
+            error = builder.getErrorMessage();
+            return Tree(0);
+        }
+        return tree;
+    }
+
+private:
+    static uint64_t edgeKey(int u, int v)
+    {
+        uint32_t a = static_cast<uint32_t>(std::min(u, v));
+        uint32_t b = static_cast<uint32_t>(std::max(u, v));
+        return (static_cast<uint64_t>(a) << 32) | b;
+    }
+
+    // looks through the neighbors of the end with fewer of them, so a star's center isnt scanned
+    static bool hasEdge(const Tree &tree, int u, int v)
+    {
+        int n = tree.getNumVertices();
+        if (u < 0 || v < 0 || u >= n || v >= n)
+            return false;
+        if (tree.getNeighbors(u).size() > tree.getNeighbors(v).size())
+            std::swap(u, v);
+        NeighborRange neighbors = tree.getNeighbors(u);
+        return std::find(neighbors.begin(), neighbors.end(), v) != neighbors.end();
+    }
+
+    void addEdge(const Tree &tree, int u, int v)
+    {
+        uint64_t k = edgeKey(u, v);
+        // adding back an edge that was removed just takes the removal back
+        if (removed.erase(k) || hasEdge(tree, u, v))
+            return;
+        if (added_index.emplace(k, added.size()).second)
+            added.emplace_back(u, v);
+    }
+
+    void removeEdge(const Tree &tree, int u, int v)
+    {
+        uint64_t k = edgeKey(u, v);
+        auto it = added_index.find(k);
+        if (it != added_index.end())
+        {
+            // an edge that was only queued is dropped from the queue, the last one fills its slot
+            size_t slot = it->second;
+            added_index.erase(it);
+            if (slot + 1 != added.size())
+            {
+                added[slot] = added.back();
+                added_index[edgeKey(added[slot].first, added[slot].second)] = slot;
+            }
+            added.pop_back();
+            return;
+        }
+        if (hasEdge(tree, u, v))
+            removed.insert(k);
+    }
+
+    // reads "+u v", "-u v" or plain "u v" lines, skipping anything malformed
+    void parseDeltas(const Tree &tree, const char *text)
+    {
+        const char *p = text;
+        const char *end = text + std::char_traits<char>::length(text);
+        while (p < end)
+        {
+            const char *line_end = std::find(p, end, '\n');
+            EdgeDelta delta;
+            if (parseEdgeDelta(p, line_end, delta))
+            {
+                if (delta.add)
+                    addEdge(tree, delta.u, delta.v);
+                else
+                    removeEdge(tree, delta.u, delta.v);
+            }
+            p = line_end + 1;
+        }
+    }
+
+    std::unordered_set<uint64_t> removed; // edges of the tree, by edgeKey
+    std::vector<std::pair<int, int>> added;
+    std::unordered_map<uint64_t, size_t> added_index; // where each queued edge sits in added
+    char deltaBuffer[4096];
+};
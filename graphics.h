@@ -3,24 +3,29 @@
 #include <GLFW/glfw3.h>
 #include <vector>
 #include <cmath>
-
-struct Point
-{
-    float x, y;
-};
+#include <algorithm>
+#include "point.h"
 
 namespace Drawing
 {
     namespace
     {
-        inline std::vector<Point> _generateCircleVertices(Point center, int radius)
+        // the first octant of a midpoint circle only depends on the radius and just a few
+        // radii ever get drawn, so each one is worked out the first time and then kept.
+        // drawing a circle after that doesnt touch the heap
+        inline const std::vector<Point> &_circleOctant(int radius)
         {
-            std::vector<Point> vertices;
-            std::vector<Point> octant1_points;
+            static std::vector<std::vector<Point>> octants;
+            radius = std::max(radius, 0);
+            if (static_cast<size_t>(radius) >= octants.size())
+                octants.resize(radius + 1);
+            std::vector<Point> &octant1_points = octants[radius];
+            if (!octant1_points.empty())
+                return octant1_points;
+
             int x = radius;
             int y = 0;
             int d = 1 - radius;
-
             while (x >= y)
             {
                 octant1_points.push_back({(float)x, (float)y});
@@ -35,44 +40,7 @@ namespace Drawing
                     d += 2 * (y - x) + 1;
                 }
             }
-
-            vertices.reserve(octant1_points.size() * 8);
-
-            // use the points from the first octant to build all 8 octants in order
-            for (const auto &p : octant1_points)
-            {
-                vertices.push_back({center.x + p.x, center.y + p.y});
-            }
-            for (size_t i = octant1_points.size(); i-- > 0;)
-            {
-                vertices.push_back({center.x + octant1_points[i].y, center.y + octant1_points[i].x});
-            }
-            for (const auto &p : octant1_points)
-            {
-                vertices.push_back({center.x - p.y, center.y + p.x});
-            }
-            for (size_t i = octant1_points.size(); i-- > 0;)
-            {
-                vertices.push_back({center.x - octant1_points[i].x, center.y + octant1_points[i].y});
-            }
-            for (const auto &p : octant1_points)
-            {
-                vertices.push_back({center.x - p.x, center.y - p.y});
-            }
-            for (size_t i = octant1_points.size(); i-- > 0;)
-            {
-                vertices.push_back({center.x - octant1_points[i].y, center.y - octant1_points[i].x});
-            }
-            for (const auto &p : octant1_points)
-            {
-                vertices.push_back({center.x + p.y, center.y - p.x});
-            }
-            for (size_t i = octant1_points.size(); i-- > 0;)
-            {
-                vertices.push_back({center.x + octant1_points[i].x, center.y - octant1_points[i].y});
-            }
-
-            return vertices;
+            return octant1_points;
         }
     }
 
@@ -89,7 +57,6 @@ namespace Drawing
         int x = radius;
         int y = 0;
         int d = 1 - x;
-        std::vector<Point> octant1_points;
         while (x >= y)
         {
             // only calculate one octant and then mirror it eight times
@@ -118,20 +85,30 @@ namespace Drawing
     // draws a solid, filled in circle
     inline void drawFilledCircle(Point center, int radius)
     {
-        // generate the vertices needed for this specific circle
-        std::vector<Point> vertices = _generateCircleVertices(center, radius);
+        const std::vector<Point> &octant1_points = _circleOctant(radius);
 
         glBegin(GL_TRIANGLE_FAN);
         glVertex2f(center.x, center.y); // center point of the fan
-        for (const auto &vertex : vertices)
-        {
-            glVertex2f(vertex.x, vertex.y);
-        }
+        // use the points from the first octant to build all 8 octants in order
+        for (const auto &p : octant1_points)
+            glVertex2f(center.x + p.x, center.y + p.y);
+        for (size_t i = octant1_points.size(); i-- > 0;)
+            glVertex2f(center.x + octant1_points[i].y, center.y + octant1_points[i].x);
+        for (const auto &p : octant1_points)
+            glVertex2f(center.x - p.y, center.y + p.x);
+        for (size_t i = octant1_points.size(); i-- > 0;)
+            glVertex2f(center.x - octant1_points[i].x, center.y + octant1_points[i].y);
+        for (const auto &p : octant1_points)
+            glVertex2f(center.x - p.x, center.y - p.y);
+        for (size_t i = octant1_points.size(); i-- > 0;)
+            glVertex2f(center.x - octant1_points[i].y, center.y - octant1_points[i].x);
+        for (const auto &p : octant1_points)
+            glVertex2f(center.x + p.y, center.y - p.x);
+        for (size_t i = octant1_points.size(); i-- > 0;)
+            glVertex2f(center.x + octant1_points[i].x, center.y - octant1_points[i].y);
         // add the first vertex again to close the fan
-        if (!vertices.empty())
-        {
-            glVertex2f(vertices.front().x, vertices.front().y);
-        }
+        if (!octant1_points.empty())
+            glVertex2f(center.x + octant1_points[0].x, center.y + octant1_points[0].y);
         glEnd();
     }
 
@@ -3,27 +3,90 @@
 #include "imgui_impl_opengl3.h"
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
-#include <GL/glut.h>
 #include "tree.h"
 #include "treeLayout.h"
 #include "treeRenderer.h"
+#include "labelRenderer.h"
+#include "layoutWorker.h"
+#include "layoutCache.h"
+#include "treeGenerator.h"
+#include "treeQuery.h"
+#include "commandLine.h"
 #include "animate.h"
+#include "edgeEditor.h"
+#include "edgeStream.h"
+#include "sceneCache.h"
+#include "viewTransform.h"
+#include "allocCounter.h"
+#include "layoutVerifier.h"
 #include <string>
-#include <sstream>
+#include <cstdio>
 #include <iostream>
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
 
-Tree *tree = nullptr;
-TreeLayout *layout = nullptr;
+std::shared_ptr<Tree> tree;
+std::shared_ptr<TreeLayout> layout;
 TreeRenderer *renderer = nullptr;
 std::vector<Point> current_positions;
 Animator *animator = nullptr;
+// a compact layout keeps its positions quantized, so an animation's ends are worked out into
+// this while it runs and let go once it is over
+std::vector<Point> decodedTargets;
+
+const std::vector<Point> &animationTargets()
+{
+    if (!layout->hasQuantizedPositions())
+        return layout->getTargetPositions();
+    layout->decodeTargetPositions(decodedTargets);
+    return decodedTargets;
+}
+LayoutWorker *worker = nullptr;
+LayoutCache *layoutCache = nullptr;
+// a layout found in the cache, picked up by the main loop just like a finished worker result
+std::shared_ptr<LayoutResult> cacheHit;
+int cacheBudgetMB = 256;
+// spacing the user asked for, can run ahead of the layout still being computed
+float spacingDelta = 50.0f;
+// polynomial trig over sibling groups instead of libm, slightly less exact but faster on big trees
+bool fastTrig = false;
+
+TrigMode trigMode()
+{
+    return fastTrig ? TrigMode::FAST : TrigMode::PRECISE;
+}
+// copy the layout of identical subtrees instead of placing each one
+bool shareSubtrees = false;
+// keep only what drawing needs, in narrow types where they fit, so huge trees fit in memory
+bool compactMemory = false;
+// radial wedges, a top down tidy tree or nested balloons
+LayoutStyle layoutStyle = LayoutStyle::RADIAL;
+// lay out in double, for trees so large float angles start to run together
+bool doublePrecision = false;
 
 int hoveredNodeID = -1;
+// shift-click picks the two ends of a path, a single node means the end is still missing
+std::vector<int> selectedPath;
+int selectedPathLca = -1;
+// edge events from --stream, null when the viewer was started without one
+EdgeStream *edgeStream = nullptr;
+// path queries on the current layout, built the first time a path is picked
+TreeQuery *query = nullptr;
 bool isPanning = false;
 double lastMouseX = 0.0, lastMouseY = 0.0;
 float cameraX = 0.0f, cameraY = 0.0f;
+// turns and zooms the drawn layout about its center, which sits in the middle of the window
+// plus the camera pan. none of it needs a new layout
+ViewTransform view;
+// how far out ctrl+scroll can zoom, it stops at 1:1 since the lines are drawn pixel by pixel
+const float MIN_VIEW_SCALE = 0.02f;
+// while spinning, the view's angle and the mouse's angle around the center when it started
+bool isSpinning = false;
+float spinStartAngle = 0.0f, spinGrabAngle = 0.0f;
 
 // manage what the app is doing right now
 enum class AppState
@@ -34,57 +97,222 @@ enum class AppState
 };
 AppState currentState = AppState::IDLE;
 bool showBlueprint = false;
+// node ids next to every node that has room for one
+bool showLabels = false;
+LabelRenderer *labels = nullptr;
 
 // variables for the find center animation timing
 int findCenter_step = 0;
 double findCenter_last_step_time = 0.0;
 const double FIND_CENTER_STEP_DURATION = 0.8;
 
+// the size the window opens at, a startup tree is laid out for it before the window exists
+const int WINDOW_WIDTH = 800, WINDOW_HEIGHT = 600;
+// glfw is up and the worker may wake the loop, before that the first frame picks results up anyway
+std::atomic<bool> windowReady(false);
+
+// a new tree's layout is placed a few rings per frame, this is how long each frame may spend
+const double PROGRESSIVE_BUDGET_MS = 4.0;
+bool progressiveLayout = false;
+
 bool show_tree_window = true;
 
+// frames left to draw before the loop can go to sleep, imgui needs a couple of frames
+// after an input to settle hover states and layout
+int redrawFrames = 3;
+// how long to sleep with nothing going on, it only matters for the blinking text cursor
+const double IDLE_WAIT_SECONDS = 0.5;
+// the last idle frame, so hovering doesnt redraw the whole tree
+SceneCache *sceneCache = nullptr;
+
+// clicks, keys, scrolls and resizes seen so far. a frame without any of them that also
+// didnt pick up new work is steady, and a steady frame isnt supposed to allocate anything
+int inputEvents = 0;
+// heap use of the last frame the ui thread drew, and how many steady frames broke the rule
+AllocCounts frameAllocs = {0, 0, 0};
+// how long the worker took for the layout on screen, 0 when it came from the cache
+double lastLayoutMillis = 0.0;
+int steadyFramesAllocating = 0;
+// filled while the memory section of the panel is open, kept so that doesnt allocate
+std::vector<MemoryItem> memoryReport;
+
+void requestRedraw()
+{
+    redrawFrames = 3;
+}
+
+// a layout asked for while a new tree was on its way. the worker wont take it then, so it is
+// asked for again once that tree is shown
+bool layoutDeferred = false;
+LayoutJobKind deferredKind = LayoutJobKind::SPACING;
+int deferredRoot = -1;
+
+void deferLayout(LayoutJobKind kind, int root)
+{
+    layoutDeferred = true;
+    deferredKind = kind;
+    deferredRoot = root;
+}
+
+// the cache keys layouts by the settings they were made with, so take those from the layout
+void setCacheContext(const Tree &t, const TreeLayout &l)
+{
+    layoutCache->setContext(t.getId(), l.getDelta(), l.getTrigMode(), l.getShareSubtrees(), l.getCompact(), l.getStyle(), l.getDoublePrecision(),
+                            static_cast<int>(l.getHalfWidth()), static_cast<int>(l.getHalfHeight()));
+}
+
+// hands a layout of the current tree to the background worker, unless we still have it cached
+void requestLayout(LayoutJobKind kind, int root, int windowWidth, int windowHeight)
+{
+    // the new tree replaces this one, so neither a cached layout nor a job for it may get in
+    // the way. the settings are picked up again once the new tree is shown
+    if (worker->isLoadingTree())
+    {
+        deferLayout(kind, root);
+        return;
+    }
+    layoutCache->setContext(tree->getId(), spacingDelta, trigMode(), shareSubtrees, compactMemory, layoutStyle, doublePrecision, windowWidth / 2, windowHeight / 2);
+    if (auto cached = layoutCache->find(root))
+    {
+        // whatever the worker is doing was asked for before this, so it is stale
+        worker->cancelPending();
+        cacheHit = std::make_shared<LayoutResult>();
+        cacheHit->kind = kind;
+        cacheHit->root = root;
+        cacheHit->tree = tree;
+        cacheHit->layout = cached;
+        cacheHit->millis = 0.0;
+        return;
+    }
+    cacheHit.reset();
+
+    LayoutJob job;
+    job.kind = kind;
+    job.tree = tree;
+    job.root = root;
+    job.delta = spacingDelta;
+    job.trig_mode = trigMode();
+    job.share_subtrees = shareSubtrees;
+    job.compact = compactMemory;
+    job.style = layoutStyle;
+    job.double_precision = doublePrecision;
+    job.halfwidth = windowWidth / 2;
+    job.halfheight = windowHeight / 2;
+    // whatever is collapsed now stays collapsed in the new layout
+    job.collapsed = layout->getCollapsed();
+    if (!worker->submit(std::move(job)))
+        deferLayout(kind, root);
+}
+
+// collapses or expands a node in a copy of the current layout, nothing else gets moved
+void requestToggleCollapse(int node)
+{
+    const auto &centers = layout->getCenterNodes();
+    LayoutJob job;
+    job.kind = LayoutJobKind::COLLAPSE;
+    job.tree = tree;
+    job.root = centers.size() == 1 ? centers[0] : -1;
+    job.delta = layout->getDelta();
+    job.halfwidth = static_cast<int>(layout->getHalfWidth());
+    job.halfheight = static_cast<int>(layout->getHalfHeight());
+    job.base = layout;
+    job.node = node;
+    // the node belongs to the tree on screen, which a new tree on its way is about to replace.
+    // and while its rings are still being placed this thread writes the layout the worker would copy
+    if (worker->isLoadingTree() || progressiveLayout)
+        return;
+    cacheHit.reset();
+    worker->submit(std::move(job));
+}
+
+// puts the layout center in the middle of a width by height window, moved by the camera pan.
+// a resized window just gets a new anchor, the layout stays as it is
+void updateView(int width, int height)
+{
+    if (layout)
+        view.setCenter({layout->getHalfWidth(), layout->getHalfHeight()});
+    view.setAnchor({width / 2.0f + cameraX, height / 2.0f + cameraY});
+}
+
+// angle of the mouse around the layout center on screen
+float mouseAngle(GLFWwindow *window)
+{
+    double xpos, ypos;
+    int width, height;
+    glfwGetCursorPos(window, &xpos, &ypos);
+    glfwGetFramebufferSize(window, &width, &height);
+    Point anchor = view.getAnchor();
+    return std::atan2(static_cast<float>(height - ypos) - anchor.y, static_cast<float>(xpos) - anchor.x);
+}
+
 // main drawing function
-void display()
+void display(int width, int height)
 {
     glClear(GL_COLOR_BUFFER_BIT);
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
-    // moves the whole scene based on camera panning
-    glTranslatef(cameraX, cameraY, 0.0f);
-    if (tree && layout && renderer)
+    if (!tree || !layout || !renderer)
+        return;
+
+    DrawState state = (currentState == AppState::ANIMATING_FIND_CENTER) ? DrawState::ANIMATING_FIND_CENTER : DrawState::NORMAL;
+    // while nothing moves the tree looks the same every frame, so it only has to be drawn once
+    bool still = currentState == AppState::IDLE && !animator->isAnimating();
+    updateView(width, height);
+    if (still && sceneCache->matches(width, height, view, showBlueprint))
     {
-        DrawState state = (currentState == AppState::ANIMATING_FIND_CENTER) ? DrawState::ANIMATING_FIND_CENTER : DrawState::NORMAL;
-        // draw the tree
+        sceneCache->draw();
+    }
+    else
+    {
+        // pan, turn and zoom all go onto the gl matrix, the positions are drawn as they are
+        view.apply();
+        // fraction of the way into the current pruning step, so pruned nodes fade smoothly
+        float step_fraction = static_cast<float>((glfwGetTime() - findCenter_last_step_time) / FIND_CENTER_STEP_DURATION);
+        float animation_step = findCenter_step + std::min(1.0f, std::max(0.0f, step_fraction));
+        // draw the tree, the hover highlight goes on top separately
         auto start = std::chrono::high_resolution_clock::now();
-        renderer->draw(current_positions, hoveredNodeID, showBlueprint, state, findCenter_step);
+        renderer->draw(current_positions, -1, showBlueprint, state, animation_step, still);
+        glLoadIdentity();
+        // the labels stay upright on screen and go into the cached frame along with the nodes
+        if (showLabels && state == DrawState::NORMAL)
+            renderer->drawLabels(*labels, current_positions, view, width, height);
         auto end = std::chrono::high_resolution_clock::now();
         double millis = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1e6;
         // std::cout << "Draw call took " << millis << " ms" << std::endl;
+        if (still)
+            sceneCache->capture(width, height, view, showBlueprint);
+        else
+            sceneCache->invalidate();
     }
-}
 
-void renderText(float x, float y, const std::string &text)
-{
-    glColor3f(1.0f, 1.0f, 1.0f);
-    std::istringstream iss(text);
-    std::string line;
-    const float lineHeight = 16.0f;
-    float yOffset = 0.0f;
-    // split text into lines and render each line varying y position
-    while (std::getline(iss, line))
+    // the highlights go on top of the cached frame, so they never invalidate it
+    view.apply();
+    // highlight hovered node's subtree
+    if (hoveredNodeID != -1 && state == DrawState::NORMAL)
     {
-        glRasterPos2f(x, y - yOffset);
-        for (char const &c : line)
-        {
-            glutBitmapCharacter(GLUT_BITMAP_9_BY_15, c);
-        }
-        yOffset += lineHeight;
+        renderer->highlightSubtree(hoveredNodeID);
+    }
+    if (!selectedPath.empty() && state == DrawState::NORMAL)
+    {
+        renderer->highlightPath(current_positions, selectedPath);
     }
 }
 
+void renderText(float x, float y, const char *text)
+{
+    labels->addText(x, y, text);
+    labels->flush(1.0f, 1.0f, 1.0f);
+}
+
 void cursor_position_callback(GLFWwindow *window, double xpos, double ypos)
 {
+    // the ui only needs redrawing if the mouse is over it
+    if (ImGui::GetIO().WantCaptureMouse)
+        requestRedraw();
+
     if (isPanning)
     {
+        requestRedraw();
         double dx = xpos - lastMouseX;
         double dy = ypos - lastMouseY;
         cameraX += dx;
@@ -93,6 +321,12 @@ void cursor_position_callback(GLFWwindow *window, double xpos, double ypos)
         lastMouseY = ypos;
     }
 
+    if (isSpinning)
+    {
+        requestRedraw();
+        view.setAngle(spinStartAngle + mouseAngle(window) - spinGrabAngle);
+    }
+
     // if animation is playing, block with hovering
     if (animator->isAnimating() || currentState == AppState::ANIMATING_FIND_CENTER)
     {
@@ -102,16 +336,21 @@ void cursor_position_callback(GLFWwindow *window, double xpos, double ypos)
 
     int width, height;
     glfwGetFramebufferSize(window, &width, &height);
-    // convert screen coordinates to our world coordinates, taking camera pan into account
-    float worldX = static_cast<float>(xpos) - cameraX;
-    float worldY = static_cast<float>(height - ypos) - cameraY;
+    // undo the view transform to get from the screen back to the layout's coordinates
+    updateView(width, height);
+    Point world = view.toLayout({static_cast<float>(xpos), static_cast<float>(height - ypos)});
+    float worldX = world.x;
+    float worldY = world.y;
 
+    int previousHover = hoveredNodeID;
     hoveredNodeID = -1;
     // check if the mouse is close enough to any node to be considered a hover
-    if (tree)
+    if (tree && layout)
     {
-        const float radius = 8.0f;
-        for (size_t i = 0; i < current_positions.size(); ++i)
+        // zoomed far out the nodes get tiny, so keep at least a few pixels to aim at
+        const float radius = std::max(8.0f, 4.0f / view.getScale());
+        // hidden nodes cant be hovered
+        for (int i : layout->getPreorderNodes())
         {
             float dx_node = worldX - current_positions[i].x;
             float dy_node = worldY - current_positions[i].y;
@@ -122,10 +361,15 @@ void cursor_position_callback(GLFWwindow *window, double xpos, double ypos)
             }
         }
     }
+    if (hoveredNodeID != previousHover)
+        requestRedraw();
 }
 
+// the view re-centers the layout on the next frame, nothing gets laid out again
 void framebuffer_size_callback(GLFWwindow *window, int width, int height)
 {
+    requestRedraw();
+    ++inputEvents;
     glViewport(0, 0, width, height);
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
@@ -136,28 +380,40 @@ void framebuffer_size_callback(GLFWwindow *window, int width, int height)
 
 void scroll_callback(GLFWwindow *window, double xoffset, double yoffset)
 {
+    requestRedraw();
+    ++inputEvents;
     const auto &io = ImGui::GetIO();
     // if the ui wants the mouse, we ignore the scroll
     if (io.WantCaptureMouse)
         return;
 
+    // ctrl+scroll zooms the view instead, which leaves the layout alone
+    if (glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_RIGHT_CONTROL) == GLFW_PRESS)
+    {
+        view.setScale(std::min(1.0f, std::max(MIN_VIEW_SCALE, view.getScale() * std::pow(1.15f, static_cast<float>(yoffset)))));
+        return;
+    }
+
     if (tree && layout && animator && !animator->isAnimating() && currentState == AppState::IDLE)
     {
-        float currentDelta = layout->getDelta();
-        float newDelta = currentDelta + yoffset * 2.0f;
+        float newDelta = spacingDelta + yoffset * 2.0f;
         if (newDelta < 5.0f)
             newDelta = 5.0f; // dont let it get too small
+        spacingDelta = newDelta;
 
-        currentState = AppState::ANIMATING_LAYOUT;
-        const auto &start_pos = current_positions;
-        layout->setDelta(newDelta);
-        const auto &end_pos = layout->getTargetPositions();
-        animator->startAnimation(start_pos, end_pos);
+        // keep whatever root the current layout uses
+        const auto &centers = layout->getCenterNodes();
+        int root = centers.size() == 1 ? centers[0] : -1;
+        int width, height;
+        glfwGetWindowSize(window, &width, &height);
+        requestLayout(LayoutJobKind::SPACING, root, width, height);
     }
 }
 
 void mouse_button_callback(GLFWwindow *window, int button, int action, int mods)
 {
+    requestRedraw();
+    ++inputEvents;
     const auto &io = ImGui::GetIO();
     // if the ui wants the mouse, we ignore the click
     if (io.WantCaptureMouse)
@@ -166,6 +422,20 @@ void mouse_button_callback(GLFWwindow *window, int button, int action, int mods)
     if (currentState != AppState::IDLE && !(currentState == AppState::ANIMATING_FIND_CENTER && action == GLFW_PRESS))
         return;
 
+    // the middle button or alt+right drag spins the view around the layout center
+    if (action == GLFW_PRESS && (button == GLFW_MOUSE_BUTTON_MIDDLE || (button == GLFW_MOUSE_BUTTON_RIGHT && (mods & GLFW_MOD_ALT))))
+    {
+        isSpinning = true;
+        spinStartAngle = view.getAngle();
+        spinGrabAngle = mouseAngle(window);
+        return;
+    }
+    if (action == GLFW_RELEASE && isSpinning && button != GLFW_MOUSE_BUTTON_LEFT)
+    {
+        isSpinning = false;
+        return;
+    }
+
     if (button == GLFW_MOUSE_BUTTON_RIGHT)
     {
         if (action == GLFW_PRESS)
@@ -186,15 +456,35 @@ void mouse_button_callback(GLFWwindow *window, int button, int action, int mods)
             const auto &centralNodes = layout->getCenterNodes();
             bool isCentral = (std::find(centralNodes.begin(), centralNodes.end(), hoveredNodeID) != centralNodes.end());
 
+            // shift-click starts a path, the next one finishes it
+            if (mods & GLFW_MOD_SHIFT)
+            {
+                if (selectedPath.size() == 1)
+                {
+                    if (!query)
+                        query = new TreeQuery(*layout);
+                    selectedPathLca = query->lca(selectedPath[0], hoveredNodeID);
+                    selectedPath = query->path(selectedPath[0], hoveredNodeID);
+                }
+                else
+                {
+                    selectedPath.assign(1, hoveredNodeID);
+                    selectedPathLca = -1;
+                }
+            }
+            // ctrl-click hides or shows the node's subtree, the centers always stay open
+            else if (mods & GLFW_MOD_CONTROL)
+            {
+                if (!isCentral)
+                    requestToggleCollapse(hoveredNodeID);
+            }
             // we can only re-root on non central nodes for now
-            if (!isCentral)
+            else if (!isCentral)
             {
-                currentState = AppState::ANIMATING_LAYOUT;
                 std::cout << "re-rooting tree on node " << hoveredNodeID << "." << std::endl;
-                const auto &start_pos = current_positions;
-                layout->calculateLayoutFromRoot(hoveredNodeID);
-                const auto &end_pos = layout->getTargetPositions();
-                animator->startAnimation(start_pos, end_pos);
+                int width, height;
+                glfwGetWindowSize(window, &width, &height);
+                requestLayout(LayoutJobKind::RE_ROOT, hoveredNodeID, width, height);
             }
         }
     }
@@ -202,6 +492,8 @@ void mouse_button_callback(GLFWwindow *window, int button, int action, int mods)
 
 void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods)
 {
+    requestRedraw();
+    ++inputEvents;
     if (action != GLFW_PRESS)
         return;
 
@@ -222,37 +514,101 @@ int main(int argc, char **argv)
 {
     auto full_start = std::chrono::high_resolution_clock::now();
 
-    glutInit(&argc, argv);
+    // command line modes exit here, before any window or gl setup
+    int cli_result = runCommandLine(argc, argv);
+    if (cli_result != -1)
+        return cli_result;
+    const char *streamSource = (argc >= 3 && std::string(argv[1]) == "--stream") ? argv[2] : nullptr;
+
+    // a tree named on the command line is read or generated on the worker while the window, gl
+    // and imgui come up, which need none of it. the worker also finds its center and widths,
+    // then the frame loop places its rings like any new tree's. a big one is often still busy
+    // when the first frame goes out, which then shows the usual progress overlay
+    std::function<Tree(std::string &)> startupBuild;
+    bool startupTree = !streamSource && startupTreeFromArgs(argc, argv, startupBuild);
+    worker = new LayoutWorker();
+    // wake the loop up when a layout finishes, it may be asleep waiting for input
+    worker->setOnPublish([]()
+                         {
+        if (windowReady)
+            glfwPostEmptyEvent(); });
+    if (startupTree)
+    {
+        LayoutJob job;
+        job.kind = LayoutJobKind::NEW_TREE;
+        job.build = std::move(startupBuild);
+        job.root = -1;
+        job.progressive = true;
+        job.delta = spacingDelta;
+        job.trig_mode = trigMode();
+        job.share_subtrees = shareSubtrees;
+        job.compact = compactMemory;
+        job.style = layoutStyle;
+        job.double_precision = doublePrecision;
+        job.halfwidth = WINDOW_WIDTH / 2;
+        job.halfheight = WINDOW_HEIGHT / 2;
+        worker->submit(std::move(job));
+    }
 
     if (!glfwInit())
+    {
+        delete worker;
         return -1;
+    }
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
-    GLFWwindow *window = glfwCreateWindow(800, 600, "R1 Free Tree - Interactive", NULL, NULL);
+    GLFWwindow *window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "R1 Free Tree - Interactive", NULL, NULL);
     if (!window)
     {
+        delete worker;
         glfwTerminate();
         return -1;
     }
+    windowReady = true;
+
+    // start listening before anything else, so a writer waiting on the pipe isnt kept waiting
+    if (streamSource)
+    {
+        edgeStream = new EdgeStream();
+        // wake the loop up when events come in, it may be asleep waiting for input
+        edgeStream->setOnEvents([]()
+                                { glfwPostEmptyEvent(); });
+        std::string error;
+        if (!edgeStream->start(streamSource, &error))
+        {
+            std::cerr << error << std::endl;
+            delete edgeStream;
+            delete worker;
+            glfwDestroyWindow(window);
+            glfwTerminate();
+            return 1;
+        }
+        std::cout << "reading edges from " << streamSource << std::endl;
+    }
 
     int width, height;
     glfwGetWindowSize(window, &width, &height);
 
     // create a random tree
-    const int num_nodes = 20;
-    tree = new Tree(Tree::generateRandom(num_nodes));
-    layout = new TreeLayout(*tree, width / 2, height / 2);
+    // a stream starts from a single node and grows from there, and the startup tree replaces
+    // a single node once the worker is done with it
+    const int num_nodes = (streamSource || startupTree) ? 1 : 20;
+    tree = std::make_shared<Tree>(Tree::generateRandom(num_nodes));
+    layout = std::make_shared<TreeLayout>(*tree, width / 2, height / 2, spacingDelta);
     renderer = new TreeRenderer(*tree, *layout);
     animator = new Animator();
+    layoutCache = new LayoutCache(static_cast<size_t>(cacheBudgetMB) << 20);
 
-    // initial layout calculation
-    layout->calculateTrueCenterLayout();
-    // set up the initial animation
-    const auto &end_pos = layout->getTargetPositions();
+    // initial layout calculation, only the centers are placed now and the rest of the rings
+    // follow over the next frames
+    layout->beginProgressiveLayout();
+    progressiveLayout = true;
+    auto progressive_start = std::chrono::high_resolution_clock::now();
+    layoutCache->setContext(tree->getId(), spacingDelta, trigMode(), shareSubtrees, compactMemory, layoutStyle, doublePrecision, width / 2, height / 2);
 
     // start all nodes from the center of the screen for explode effect
     current_positions.assign(tree->getNumVertices(), {width / 2.0f, height / 2.0f});
-    animator->startAnimation(current_positions, end_pos);
+    animator->startAnimation(current_positions, animationTargets(), &layout->getPlacedNodes());
     currentState = AppState::ANIMATING_LAYOUT;
 
     glfwMakeContextCurrent(window);
@@ -267,7 +623,12 @@ int main(int argc, char **argv)
     glfwSetScrollCallback(window, scroll_callback);
     glfwSetMouseButtonCallback(window, mouse_button_callback);
     glfwSetKeyCallback(window, key_callback);
-    framebuffer_size_callback(window, 800, 600);
+    // the window got uncovered or resized, its contents need drawing again
+    glfwSetWindowRefreshCallback(window, [](GLFWwindow *)
+                                 { requestRedraw(); });
+    sceneCache = new SceneCache();
+    labels = new LabelRenderer();
+    framebuffer_size_callback(window, WINDOW_WIDTH, WINDOW_HEIGHT);
 
     // set a nice dark background color
     glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
@@ -298,55 +659,203 @@ int main(int argc, char **argv)
     const char *glsl_version = "#version 130";
     ImGui_ImplOpenGL3_Init(glsl_version);
 
-    // buffer to hold the tree's edge list for the ui text box
-    char edgeListBuffer[8192 * 16];
+    // virtualized view over the tree's edge list, edits are kept as deltas
+    EdgeListEditor edgeEditor;
     char filenameBuffer[256] = "tree.txt";
-
-    // lambda to keep the edge list text box updated
-    auto updateEdgeListBuffer = [&]()
+    int ui_num_nodes = tree->getNumVertices();
+    // why the last update, load or random tree was rejected, if it was
+    std::string treeError;
+    // what the last verify of the shown layout found, cleared when the layout changes
+    std::string layoutCheck;
+    // the edges the stream has sent so far. events only get folded in here as they arrive,
+    // the worker copies them out and builds the tree, at most one at a time. events the set
+    // couldnt take because the worker was copying wait in streamEvents for the next frame
+    auto liveEdges = std::make_shared<LiveEdgeSet>();
+    std::vector<EdgeDelta> streamEvents;
+    bool streamDirty = false;    // the edges changed since the last tree was sent off
+    bool streamInFlight = false; // a stream tree is with the worker
+    // why the streamed edges dont make a tree yet, if they dont. the last tree they made stays
+    std::string streamStatus;
+    uint64_t streamRateCount = 0;
+    double streamRateTime = 0.0, streamRate = 0.0;
+    // settings for the random tree generator
+    int ui_family = static_cast<int>(TreeFamily::UNIFORM);
+    // every press of Random moves the seed on, so it is a different tree each time. typing a
+    // seed in gets that tree back, the one the shown tree was made with is printed below
+    int ui_seed = static_cast<int>(std::random_device()() & 0x7fffffff);
+    int ui_last_seed = -1;
+    int ui_param = 0;
+    const char *family_names[static_cast<int>(TreeFamily::COUNT)];
+    for (int i = 0; i < static_cast<int>(TreeFamily::COUNT); ++i)
     {
-        std::ostringstream oss;
-        for (const auto &edge : tree->getEdges())
-        {
-            oss << edge.first << " " << edge.second << "\n";
-        }
-        std::string edges_str = oss.str();
-        std::copy(edges_str.begin(), edges_str.end(), edgeListBuffer);
-        edgeListBuffer[edges_str.size()] = '\0';
-    };
-    updateEdgeListBuffer();
+        family_names[i] = TreeGenerator::familyName(static_cast<TreeFamily>(i));
+    }
 
-    // lambda to update the tree, layout, renderer and animator when the tree changes
-    auto updateTree = [&](const Tree &new_tree)
+    // lambda to build a new tree and its layout on the worker, the old one stays on screen meanwhile
+    auto updateTree = [&](std::function<Tree(std::string &)> build)
     {
         int width, height;
         glfwGetWindowSize(window, &width, &height);
 
-        Tree *new_tree_ptr = new Tree(new_tree);
-        TreeLayout *new_layout_ptr = new TreeLayout(*new_tree_ptr, width / 2, height / 2);
-        TreeRenderer *new_renderer_ptr = new TreeRenderer(*new_tree_ptr, *new_layout_ptr);
+        LayoutJob job;
+        job.kind = LayoutJobKind::NEW_TREE;
+        job.build = std::move(build);
+        job.root = -1;
+        job.progressive = true;
+        job.delta = spacingDelta;
+        job.trig_mode = trigMode();
+        job.share_subtrees = shareSubtrees;
+        job.compact = compactMemory;
+        job.style = layoutStyle;
+        job.double_precision = doublePrecision;
+        job.halfwidth = width / 2;
+        job.halfheight = height / 2;
+        worker->submit(std::move(job));
+        // this cancels the startup tree if it is still on the worker
+        startupTree = false;
+    };
 
-        new_layout_ptr->calculateTrueCenterLayout();
-        const auto &end_pos = new_layout_ptr->getTargetPositions();
+    // sends the streamed edges off as a new tree. the worker copies them out and builds it, and
+    // if they arent a tree right now the builder's reason comes back and the last one stays
+    auto submitStreamTree = [&]()
+    {
+        int width, height;
+        glfwGetWindowSize(window, &width, &height);
+        LayoutJob job;
+        job.kind = LayoutJobKind::STREAM;
+        job.build = [edge_set = liveEdges](std::string &error)
+        {
+            std::vector<std::pair<int, int>> edges;
+            int n = edge_set->snapshot(edges);
+            TreeBuilder builder(n, std::move(edges));
+            Tree tree;
+            if (!builder.build(tree))
+            {
+                error = builder.getErrorMessage();
+                return Tree(0);
+            }
+            return tree;
+        };
+        job.root = -1;
+        job.progressive = true;
+        job.delta = spacingDelta;
+        job.trig_mode = trigMode();
+        job.share_subtrees = shareSubtrees;
+        job.compact = compactMemory;
+        job.style = layoutStyle;
+        job.double_precision = doublePrecision;
+        job.halfwidth = width / 2;
+        job.halfheight = height / 2;
+        cacheHit.reset();
+        worker->submit(std::move(job));
+        streamInFlight = true;
+    };
 
-        delete tree;
-        delete layout;
+    // swaps in a layout the worker finished and animates towards it
+    auto applyLayoutResult = [&](LayoutResult &result)
+    {
+        if (result.kind == LayoutJobKind::STREAM)
+        {
+            streamInFlight = false;
+            // the edges are somewhere in between two trees, keep showing the last one
+            streamStatus = result.error;
+            if (!result.error.empty())
+                return;
+        }
+        // the new tree was rejected, keep the old one and say why
+        if (!result.error.empty())
+        {
+            treeError = result.error;
+            return;
+        }
+        treeError.clear();
+        lastLayoutMillis = result.millis;
+        // only the centers of a new tree are placed yet, the frame loop places the rest
+        bool partial = !result.layout->isLayoutComplete();
+        // a new tree throws the old cache out, then remember this layout under its root. a
+        // partial one goes in once it is finished. the cache tells trees apart by id as well,
+        // since a new tree can be built where a freed one was
+        if (result.tree != tree)
+            layoutCache->clear();
+        setCacheContext(*result.tree, *result.layout);
+        // cached layouts were made with the old set of collapsed nodes
+        if (result.kind == LayoutJobKind::COLLAPSE)
+            layoutCache->clear();
+        if (!partial)
+            layoutCache->insert(result.root, result.layout);
+        TreeRenderer *new_renderer_ptr = new TreeRenderer(*result.tree, *result.layout);
+        if (!partial)
+            new_renderer_ptr->prepare();
         delete renderer;
-
-        // swap in the new ones
-        tree = new_tree_ptr;
-        layout = new_layout_ptr;
         renderer = new_renderer_ptr;
+        // the queries point into the old layout
+        delete query;
+        query = nullptr;
+        layout = result.layout;
+        // a path stays the same path under a new root, but not in a new tree or with nodes hidden
+        if (result.kind == LayoutJobKind::NEW_TREE || result.kind == LayoutJobKind::COLLAPSE || result.kind == LayoutJobKind::STREAM)
+        {
+            selectedPath.clear();
+            selectedPathLca = -1;
+        }
+        else if (selectedPath.size() > 1)
+        {
+            // where the ends meet depends on the root though
+            query = new TreeQuery(*layout);
+            selectedPathLca = query->lca(selectedPath.front(), selectedPath.back());
+        }
+        hoveredNodeID = -1;
+        layoutCheck.clear();
+        // the new layout replaces whatever was still being placed
+        progressiveLayout = partial;
+        if (partial)
+            progressive_start = std::chrono::high_resolution_clock::now();
 
-        // create a new animator and start the transition
-        delete animator;
-        animator = new Animator();
-        current_positions.assign(tree->getNumVertices(), {width / 2.0f, height / 2.0f});
-        animator->startAnimation(current_positions, end_pos);
+        if (result.kind == LayoutJobKind::NEW_TREE)
+        {
+            // a root picked in the old tree means nothing in this one
+            deferredRoot = -1;
+            tree = result.tree;
+            // create a new animator and explode the new tree out of the center
+            delete animator;
+            animator = new Animator();
+            current_positions.assign(tree->getNumVertices(), {layout->getHalfWidth(), layout->getHalfHeight()});
+            cameraX = 0.0f;
+            cameraY = 0.0f;
+            view.setAngle(0.0f);
+            view.setScale(1.0f);
+            ui_num_nodes = tree->getNumVertices();
+            edgeEditor.clear();
+        }
+        else if (result.kind == LayoutJobKind::STREAM)
+        {
+            // ids carry over, so everything already on screen moves from where it is and the
+            // new nodes grow out of their parents, no camera reset or explosion
+            tree = result.tree;
+            size_t old_count = current_positions.size();
+            current_positions.resize(tree->getNumVertices(), {layout->getHalfWidth(), layout->getHalfHeight()});
+            const auto &parents = layout->getParentMap();
+            for (int u : layout->getPreorderNodes())
+            {
+                if (static_cast<size_t>(u) >= old_count && parents[u] != -1)
+                    current_positions[u] = current_positions[parents[u]];
+            }
+            ui_num_nodes = tree->getNumVertices();
+            edgeEditor.clear();
+        }
+        else if (result.kind == LayoutJobKind::COLLAPSE)
+        {
+            // newly shown nodes grow out of the node that was expanded
+            int first = layout->getPreorderIndex()[result.node];
+            const auto &order = layout->getPreorderNodes();
+            for (int i = first + 1; i < first + layout->getSubtreeSize(result.node); ++i)
+                current_positions[order[i]] = current_positions[result.node];
+        }
+        // the find center animation would be looking at the old layout
         currentState = AppState::ANIMATING_LAYOUT;
-        hoveredNodeID = -1;
-        cameraX = 0.0f;
-        cameraY = 0.0f;
+        animator->setQuantized(layout->getCompact());
+        // a partial layout moves its rings in as they are placed
+        animator->startAnimation(current_positions, animationTargets(), partial ? &layout->getPlacedNodes() : &layout->getPreorderNodes());
     };
 
     bool firstFrame = true;
@@ -354,12 +863,33 @@ int main(int argc, char **argv)
     // main loop
     while (!glfwWindowShouldClose(window))
     {
+        // everything the ui thread allocates from here to the swap counts for this frame
+        AllocCounts frameStart = threadAllocCounts();
+        int inputsBefore = inputEvents;
+        // set when this frame takes on something that is allowed to allocate, like a new layout
+        bool frameWork = progressiveLayout || firstFrame;
+        // only keep drawing while something on screen is changing, otherwise sleep until
+        // there is input or the worker has something for us
+        bool active = currentState != AppState::IDLE || animator->isAnimating() || worker->isBusy() || worker->hasResult() || cacheHit ||
+                      (edgeStream && edgeStream->hasEvents());
+        if (active || redrawFrames > 0)
+            glfwPollEvents();
+        else
+            glfwWaitEventsTimeout(IDLE_WAIT_SECONDS);
+
         // sleep if minmized
         if (glfwGetWindowAttrib(window, GLFW_ICONIFIED) != 0)
         {
             ImGui_ImplGlfw_Sleep(10);
             continue;
         }
+        // keep the text cursor blinking while typing, but nothing else wakes an idle frame
+        if (ImGui::GetIO().WantTextInput)
+            redrawFrames = std::max(redrawFrames, 1);
+        if (!active && redrawFrames <= 0 && !worker->hasResult())
+            continue;
+        if (redrawFrames > 0)
+            redrawFrames--;
 
         // start a new imgui frame
         ImGui_ImplOpenGL3_NewFrame();
@@ -371,35 +901,45 @@ int main(int argc, char **argv)
             // define our control panel window
             ImGui::Begin("Controls & Editor", &show_tree_window, ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_AlwaysAutoResize);
             ImGui::Text("Edit Tree");
-            static int ui_num_nodes = tree->getNumVertices();
             ImGui::Text("Nodes:");
             ImGui::SameLine();
             ImGui::InputInt("##Nodes", &ui_num_nodes);
-            ImGui::Text("Edges:");
-            ImGui::InputTextMultiline("##Edges", edgeListBuffer, IM_ARRAYSIZE(edgeListBuffer), ImVec2(-1.0f, ImGui::GetTextLineHeight() * 8));
+            edgeEditor.draw(*tree);
 
-            // the update button takes the text from the box and builds a new tree
+            // the update button applies the queued edits to a copy of the tree
             if (ImGui::Button("Update"))
             {
-                Tree *new_tree_ptr = new Tree(ui_num_nodes);
-                std::istringstream iss(edgeListBuffer);
-                std::string line;
-                while (std::getline(iss, line))
-                {
-                    std::istringstream lineStream(line);
-                    int u, v;
-                    if (lineStream >> u >> v)
+                std::shared_ptr<Tree> base = tree;
+                std::vector<EdgeDelta> deltas = edgeEditor.getDeltas();
+                int n = ui_num_nodes;
+                updateTree([base, deltas, n](std::string &error)
+                           { return EdgeListEditor::applyDeltas(*base, n, deltas, error); });
+            }
+
+            ImGui::Separator();
+            ImGui::Text("Random Tree");
+            ImGui::Combo("Family", &ui_family, family_names, IM_ARRAYSIZE(family_names));
+            ImGui::InputInt("Seed", &ui_seed);
+            ImGui::InputInt("Param", &ui_param);
+            ImGui::TextDisabled("Param: k for kary, legs for spider, spine/handle length, 0 = default");
+            if (ImGui::Button("Random"))
+            {
+                GeneratorParams params = {static_cast<TreeFamily>(ui_family), ui_num_nodes, static_cast<unsigned long long>(ui_seed), ui_param};
+                ui_last_seed = ui_seed;
+                ui_seed = ui_seed == 0x7fffffff ? 0 : ui_seed + 1;
+                updateTree([params](std::string &error)
+                           {
+                    if (params.num_nodes < 1)
                     {
-                        new_tree_ptr->addEdge(u, v);
+                        error = "a tree needs at least one node";
+                        return Tree(0);
                     }
-                }
-                updateTree(*new_tree_ptr);
+                    return TreeGenerator::generate(params); });
             }
-            ImGui::SameLine();
-            if (ImGui::Button("Random"))
+            if (ui_last_seed != -1)
             {
-                updateTree(Tree::generateRandom(ui_num_nodes));
-                updateEdgeListBuffer();
+                ImGui::SameLine();
+                ImGui::TextDisabled("last tree: seed %d", ui_last_seed);
             }
 
             ImGui::Separator();
@@ -408,29 +948,152 @@ int main(int argc, char **argv)
             ImGui::SameLine();
             if (ImGui::Button("Load"))
             {
-                Tree new_tree = Tree::loadFromFile(filenameBuffer);
-                if (new_tree.getNumVertices() > 0)
+                std::string filename(filenameBuffer);
+                updateTree([filename](std::string &error)
+                           { return Tree::loadFromFile(filename, &error); });
+            }
+            if (!treeError.empty())
+            {
+                ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "Rejected: %s", treeError.c_str());
+            }
+
+            if (edgeStream)
+            {
+                ImGui::Separator();
+                ImGui::Text("Live Stream: %s", edgeStream->getSource().c_str());
+                // events per second, averaged over the last second or so
+                double now = glfwGetTime();
+                if (now - streamRateTime >= 1.0)
+                {
+                    uint64_t count = edgeStream->getNumReceived();
+                    streamRate = (count - streamRateCount) / (now - streamRateTime);
+                    streamRateCount = count;
+                    streamRateTime = now;
+                }
+                const char *state_names[] = {"waiting for a writer", "connected", "closed", "failed"};
+                ImGui::TextDisabled("%s, %llu events (%.0f/s), %llu malformed", state_names[static_cast<int>(edgeStream->getState())],
+                                    static_cast<unsigned long long>(edgeStream->getNumReceived()), streamRate,
+                                    static_cast<unsigned long long>(edgeStream->getNumMalformed()));
+                ImGui::TextDisabled("%d live edges", static_cast<int>(liveEdges->size()));
+                if (!streamStatus.empty())
                 {
-                    updateTree(new_tree);
-                    ui_num_nodes = tree->getNumVertices();
-                    updateEdgeListBuffer();
+                    ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.3f, 1.0f), "Not a tree yet: %s", streamStatus.c_str());
+                    ImGui::TextDisabled("Showing the last tree, %d nodes", tree->getNumVertices());
                 }
             }
 
             ImGui::Separator();
             ImGui::Text("Visualization");
             ImGui::Checkbox("Show Blueprint", &showBlueprint);
+            ImGui::SameLine();
+            if (ImGui::Checkbox("Show Labels", &showLabels))
+                sceneCache->invalidate();
+            if (showLabels)
+            {
+                ImGui::SameLine();
+                ImGui::TextDisabled("%d shown", labels->getNumNodeLabels());
+            }
+            // the blueprint only shows the wedges, this checks every node against them
+            if (ImGui::Button("Verify Layout") && layout->isLayoutComplete())
+            {
+                // a node collapsed in place leaves its ancestors' shares as they were
+                LayoutCheck check = LayoutVerifier::check(*tree, *layout, layout->getCollapsed().empty());
+                layoutCheck = check.summary();
+                if (!check.problems.empty())
+                    layoutCheck += ", " + check.problems[0];
+                std::cout << "layout check: " << layoutCheck << std::endl;
+            }
+            if (!layoutCheck.empty())
+            {
+                ImGui::SameLine();
+                if (layoutCheck == "ok")
+                    ImGui::TextDisabled("ok");
+                else
+                    ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", layoutCheck.c_str());
+            }
+            // turning and zooming only change the view, nothing gets laid out again
+            float view_angle = view.getAngle();
+            if (ImGui::SliderAngle("Rotation", &view_angle, -180.0f, 180.0f))
+                view.setAngle(view_angle);
+            ImGui::SameLine();
+            if (ImGui::Button("Reset View"))
+            {
+                view.setAngle(0.0f);
+                view.setScale(1.0f);
+                cameraX = 0.0f;
+                cameraY = 0.0f;
+            }
+            ImGui::TextDisabled("Zoom %.0f%%", view.getScale() * 100.0f);
+            bool relayout = ImGui::Checkbox("Fast Trig", &fastTrig);
+            ImGui::SameLine();
+            relayout = ImGui::Checkbox("Share Subtrees", &shareSubtrees) || relayout;
+            ImGui::SameLine();
+            relayout = ImGui::Checkbox("Compact Memory", &compactMemory) || relayout;
+            const char *style_names[] = {"Radial", "Tidy Tree", "Balloon"};
+            int style = static_cast<int>(layoutStyle);
+            if (ImGui::Combo("Layout", &style, style_names, IM_ARRAYSIZE(style_names)))
+            {
+                layoutStyle = static_cast<LayoutStyle>(style);
+                relayout = true;
+            }
+            ImGui::SameLine();
+            relayout = ImGui::Checkbox("Double Precision", &doublePrecision) || relayout;
+            if (relayout)
+            {
+                // lay the current root out again, otherwise the change applies to the next layout.
+                // a tree still loading gets the change once it is shown
+                if (worker->isLoadingTree() || (animator && !animator->isAnimating() && currentState == AppState::IDLE))
+                {
+                    const auto &centers = layout->getCenterNodes();
+                    int root = centers.size() == 1 ? centers[0] : -1;
+                    int width, height;
+                    glfwGetWindowSize(window, &width, &height);
+                    requestLayout(LayoutJobKind::SPACING, root, width, height);
+                }
+            }
+            if (layout->getNumShapes() > 0)
+            {
+                ImGui::TextDisabled("%d distinct subtrees, %d copied", layout->getNumShapes(), static_cast<int>(layout->getSharedSubtrees().size()));
+            }
+            if (ImGui::SliderInt("Layout Cache (MB)", &cacheBudgetMB, 0, 4096))
+            {
+                layoutCache->setBudget(static_cast<size_t>(cacheBudgetMB) << 20);
+            }
+            ImGui::TextDisabled("%d cached layouts, %.1f MB", static_cast<int>(layoutCache->getNumEntries()), layoutCache->getUsage() / (1024.0 * 1024.0));
+            if (ImGui::CollapsingHeader("Memory"))
+            {
+                // the shown layout part by part, then everything else that grows with the tree
+                memoryReport.clear();
+                size_t layout_bytes = layout->memoryUsage(&memoryReport);
+                size_t other_bytes[] = {tree->memoryUsage(), renderer->memoryUsage(), (current_positions.capacity() + decodedTargets.capacity()) * sizeof(Point) + animator->memoryUsage()};
+                memoryReport.push_back({"tree", other_bytes[0]});
+                memoryReport.push_back({"renderer", other_bytes[1]});
+                memoryReport.push_back({"animation", other_bytes[2]});
+                size_t total = layout_bytes + other_bytes[0] + other_bytes[1] + other_bytes[2];
+                for (const auto &item : memoryReport)
+                {
+                    if (item.bytes > 0)
+                        ImGui::TextDisabled("%s: %.1f MB", item.name, item.bytes / (1024.0 * 1024.0));
+                }
+                ImGui::Text("Total %.1f MB, %.1f bytes per node", total / (1024.0 * 1024.0), static_cast<double>(total) / std::max(1, tree->getNumVertices()));
+            }
+            ImGui::TextDisabled("Last layout: %.1f ms", lastLayoutMillis);
+            // last frame's heap use on this thread, the layout worker's isnt in it
+            ImGui::TextDisabled("Frame allocations: %llu (%llu bytes), %llu freed", static_cast<unsigned long long>(frameAllocs.allocations),
+                                static_cast<unsigned long long>(frameAllocs.bytes), static_cast<unsigned long long>(frameAllocs.frees));
+            if (steadyFramesAllocating > 0)
+            {
+                ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%d steady frames allocated", steadyFramesAllocating);
+            }
             if (ImGui::Button("Reset Tree"))
             {
                 if (animator && !animator->isAnimating() && currentState == AppState::IDLE)
                 {
                     // reset the tree to the true center layout
-                    currentState = AppState::ANIMATING_LAYOUT;
                     std::cout << "resetting tree to true center." << std::endl;
-                    const auto &start_pos = current_positions;
-                    layout->calculateTrueCenterLayout();
-                    const auto &end_pos = layout->getTargetPositions();
-                    animator->startAnimation(start_pos, end_pos);
+                    int width, height;
+                    glfwGetWindowSize(window, &width, &height);
+                    requestLayout(LayoutJobKind::RESET, -1, width, height);
                 }
             }
             ImGui::SameLine();
@@ -448,32 +1111,162 @@ int main(int argc, char **argv)
                     {
                         std::cout << "starting findcenter animation..." << std::endl;
                         currentState = AppState::ANIMATING_FIND_CENTER;
-                        layout->prepareFindCenterAnimation();
+                        // the shown layout may sit in the cache or be copied by a collapse job on
+                        // the worker right now, so the pruning steps go into a copy only this
+                        // thread ever sees, which is shown from here on
+                        auto animated = std::make_shared<TreeLayout>(*layout);
+                        animated->prepareFindCenterAnimation();
+                        TreeRenderer *animated_renderer = new TreeRenderer(*tree, *animated);
+                        animated_renderer->prepare();
+                        delete renderer;
+                        renderer = animated_renderer;
+                        delete query;
+                        query = nullptr;
+                        layout = animated;
                         // reset animation step tracking
                         findCenter_step = 0;
                         findCenter_last_step_time = glfwGetTime();
                         // start the animation
-                        animator->startAnimation(current_positions, layout->getTargetPositions());
+                        animator->startAnimation(current_positions, animationTargets(), &layout->getPreorderNodes());
                     }
                 }
             }
+            if (selectedPath.size() == 1)
+            {
+                ImGui::Text("Path from %d, shift-click the other end", selectedPath[0]);
+            }
+            else if (!selectedPath.empty())
+            {
+                ImGui::Text("Path %d to %d: %d edges, meets at %d", selectedPath.front(), selectedPath.back(),
+                            static_cast<int>(selectedPath.size()) - 1, selectedPathLca);
+            }
+            if (!selectedPath.empty())
+            {
+                ImGui::SameLine();
+                if (ImGui::SmallButton("Clear Path"))
+                {
+                    selectedPath.clear();
+                    selectedPathLca = -1;
+                }
+            }
             ImGui::Separator();
             ImGui::Text("Mouse Controls");
             ImGui::TextDisabled("Scroll to change spacing");
             ImGui::TextDisabled("Left-click a node to re-root");
+            ImGui::TextDisabled("Ctrl-click a node to collapse/expand");
+            ImGui::TextDisabled("Shift-click two nodes to show their path");
             ImGui::TextDisabled("Right-click and drag to pan");
+            ImGui::TextDisabled("Middle or alt+right drag to spin");
+            ImGui::TextDisabled("Ctrl+scroll to zoom out");
             ImGui::TextDisabled("Hover over node for info");
             ImGui::Separator();
             ImGui::TextDisabled("Press M to toggle this window");
             ImGui::End();
         }
 
+        // keep drawing the old layout while the worker computes, with a small progress overlay
+        if (worker->isBusy())
+        {
+            ImGui::SetNextWindowPos(ImVec2(10.0f, ImGui::GetIO().DisplaySize.y - 10.0f), ImGuiCond_Always, ImVec2(0.0f, 1.0f));
+            ImGui::SetNextWindowBgAlpha(0.6f);
+            ImGui::Begin("##LayoutProgress", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoInputs | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav);
+            ImGui::Text("Computing layout...");
+            ImGui::ProgressBar(worker->getProgress(), ImVec2(200.0f, 0.0f));
+            ImGui::End();
+        }
+
+        // pick up a finished layout from the worker or the cache, if there is one
+        std::shared_ptr<LayoutResult> result = worker->takeResult();
+        if (!result)
+            result = std::move(cacheHit);
+        if (result)
+        {
+            // the startup tree, nothing else new was asked for since
+            if (startupTree && result->kind == LayoutJobKind::NEW_TREE)
+            {
+                startupTree = false;
+                if (!result->error.empty())
+                    std::cerr << "startup tree rejected: " << result->error << std::endl;
+                else
+                    std::cout << "Startup tree of " << result->tree->getNumVertices() << " nodes built, rings start after "
+                              << std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - full_start).count() / 1e6
+                              << " ms" << std::endl;
+            }
+            applyLayoutResult(*result);
+            frameWork = true;
+        }
+        // the new tree is shown or was rejected, now lay out what was asked for meanwhile
+        if (layoutDeferred && !worker->isLoadingTree())
+        {
+            layoutDeferred = false;
+            int width, height;
+            glfwGetWindowSize(window, &width, &height);
+            requestLayout(deferredKind, deferredRoot < tree->getNumVertices() ? deferredRoot : -1, width, height);
+            frameWork = true;
+        }
+
+        // fold everything the stream sent since the last frame into the edge set as one batch,
+        // then hand at most one tree to the worker. while it is busy the events pile up in the
+        // set, so a slow layout only makes the updates coarser and never backs up the stream
+        if (edgeStream)
+        {
+            // the events stay queued here if the worker holds the set, they go in next frame
+            edgeStream->drain(streamEvents);
+            bool changed = false;
+            if (!streamEvents.empty())
+                frameWork = true;
+            if (!streamEvents.empty() && liveEdges->tryApply(streamEvents, changed))
+            {
+                streamEvents.clear();
+                if (changed)
+                    streamDirty = true;
+            }
+            // a new tree the user asked for cancelled the stream tree, send it again
+            if (streamInFlight && !worker->isBusy() && !worker->hasResult())
+            {
+                streamInFlight = false;
+                streamDirty = true;
+            }
+            // the last stream tree is placed in full before the next one goes out, or a fast
+            // stream would keep restarting it and never show the outer rings
+            if (streamDirty && !worker->isBusy() && !worker->hasResult() && !cacheHit && !progressiveLayout)
+            {
+                frameWork = true;
+                streamDirty = false;
+                submitStreamTree();
+            }
+        }
+
+        // place a few more rings of a new tree's layout
+        if (progressiveLayout)
+        {
+            int placed_depth = layout->getCompletedDepth();
+            bool done = layout->stepProgressiveLayout(PROGRESSIVE_BUDGET_MS);
+            // the finished rings explode out of the center too, the ones already moving keep going
+            if (done || layout->getCompletedDepth() != placed_depth)
+            {
+                const auto &moving = done ? layout->getPreorderNodes() : layout->getPlacedNodes();
+                animator->startAnimation(current_positions, animationTargets(), &moving);
+            }
+            if (done)
+            {
+                progressiveLayout = false;
+                renderer->prepare();
+                // the settings may have changed since it started, it is cached under its own
+                setCacheContext(*tree, *layout);
+                layoutCache->insert(LayoutCache::TRUE_CENTER, layout);
+                auto progressive_end = std::chrono::high_resolution_clock::now();
+                double millis = std::chrono::duration_cast<std::chrono::nanoseconds>(progressive_end - progressive_start).count() / 1e6;
+                std::cout << "Progressive layout took " << millis << " ms" << std::endl;
+            }
+        }
+
         // if we are in an animating state, we update the animator
         if (currentState == AppState::ANIMATING_LAYOUT)
         {
             animator->update(current_positions);
-            // after animation is done, go back to idle
-            if (!animator->isAnimating())
+            // after animation is done, go back to idle, unless there are rings still to come
+            if (!animator->isAnimating() && !progressiveLayout)
             {
                 currentState = AppState::IDLE;
             }
@@ -495,9 +1288,14 @@ int main(int argc, char **argv)
                 }
             }
         }
+        // the ends of a finished animation arent needed anymore
+        if (!decodedTargets.empty() && !animator->isAnimating())
+            std::vector<Point>().swap(decodedTargets);
 
         // display tree
-        display();
+        int fb_width, fb_height;
+        glfwGetFramebufferSize(window, &fb_width, &fb_height);
+        display(fb_width, fb_height);
 
         // render the imgui ui on top
         ImGui::Render();
@@ -510,10 +1308,13 @@ int main(int argc, char **argv)
             const auto &depths = layout->getDepths();
             const auto &widths = layout->getWidths();
 
-            std::stringstream ss;
-            ss << "Node ID: " << hoveredNodeID << "\n"
-               << "Depth: " << depths[hoveredNodeID] << "\n"
-               << "Width: " << widths[hoveredNodeID];
+            // the angle as it looks on screen, counterclockwise from the right
+            PolarPoint polar = layout->getPolarPosition(hoveredNodeID);
+            float degrees = std::fmod((polar.angle + view.getAngle()) * 180.0f / static_cast<float>(M_PI) + 720.0f, 360.0f);
+            char info[128];
+            snprintf(info, sizeof(info), "Node ID: %d\nDepth: %d\nWidth: %d\nRadius: %.0f, angle: %.0f deg%s", hoveredNodeID,
+                     depths[hoveredNodeID], widths[hoveredNodeID], polar.radius, degrees,
+                     layout->isCollapsed(hoveredNodeID) ? "\n(collapsed)" : "");
 
             int width, height;
             glfwGetFramebufferSize(window, &width, &height);
@@ -526,9 +1327,8 @@ int main(int argc, char **argv)
             glPushMatrix();
             glLoadIdentity();
             glOrtho(0, width, 0, height, -1, 1);
-            renderText(positions[hoveredNodeID].x + cameraX + 15,
-                       positions[hoveredNodeID].y + cameraY + 15,
-                       ss.str());
+            Point screen = view.toScreen(positions[hoveredNodeID]);
+            renderText(screen.x + 15, screen.y + 15, info);
             glPopMatrix();
             glMatrixMode(GL_MODELVIEW);
             glPopMatrix();
@@ -536,8 +1336,16 @@ int main(int argc, char **argv)
 
         // swap the back buffer to the front to show what we've drawn
         glfwSwapBuffers(window);
-        // check for any new events like mouse clicks or key presses
-        glfwPollEvents();
+
+        // hovering, panning and animating only reuse buffers that already exist, so a frame
+        // that allocates without a reason means something on the draw path started allocating
+        frameAllocs = threadAllocCounts() - frameStart;
+        if (!frameWork && inputEvents == inputsBefore && frameAllocs.allocations > 0)
+        {
+            if (steadyFramesAllocating++ == 0)
+                std::cerr << "steady frame made " << frameAllocs.allocations << " allocations ("
+                          << frameAllocs.bytes << " bytes), frames like it should make none" << std::endl;
+        }
 
         // print time to first frame
         if (firstFrame)
@@ -549,11 +1357,18 @@ int main(int argc, char **argv)
         }
     }
 
-    // clean up
-    delete tree;
-    delete layout;
+    // clean up, the worker goes first since it may still hold the tree
+    delete edgeStream;
+    delete worker;
     delete renderer;
     delete animator;
+    delete layoutCache;
+    delete sceneCache;
+    delete labels;
+    delete query;
+    cacheHit.reset();
+    layout.reset();
+    tree.reset();
     glfwDestroyWindow(window);
     glfwTerminate();
     return 0;
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <GLFW/glfw3.h>
+#include "viewTransform.h"
+
+// keeps a copy of the last fully drawn tree in a texture, so frames where only the hover
+// highlight changes just paste the texture back instead of redrawing every node.
+// the copy comes straight from the back buffer, which works on plain gl 1.1
+class SceneCache
+{
+public:
+    SceneCache() : texture(0), width(0), height(0), valid(false), framework(false) {}
+
+    ~SceneCache()
+    {
+        if (texture)
+            glDeleteTextures(1, &texture);
+    }
+
+    // true if the texture still shows exactly what drawing the scene again would give
+    bool matches(int w, int h, const ViewTransform &v, bool showFramework) const
+    {
+        return valid && width == w && height == h && view == v && framework == showFramework;
+    }
+
+    // anything that moves nodes or swaps the layout has to call this
+    void invalidate() { valid = false; }
+
+    // copies whatever is in the back buffer right now, call it before anything goes on top
+    void capture(int w, int h, const ViewTransform &v, bool showFramework)
+    {
+        if (w <= 0 || h <= 0)
+            return;
+        if (!texture)
+            glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        if (w != width || h != height)
+        {
+            // only reallocate when the window size changes
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, w, h, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+            width = w;
+            height = h;
+        }
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, w, h);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        view = v;
+        framework = showFramework;
+        valid = true;
+    }
+
+    // draws the cached scene as one screen sized quad
+    void draw() const
+    {
+        glMatrixMode(GL_PROJECTION);
+        glPushMatrix();
+        glLoadIdentity();
+        glOrtho(0, 1, 0, 1, -1, 1);
+        glMatrixMode(GL_MODELVIEW);
+        glPushMatrix();
+        glLoadIdentity();
+
+        glDisable(GL_BLEND);
+        glEnable(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glColor3f(1.0f, 1.0f, 1.0f);
+        glBegin(GL_QUADS);
+        glTexCoord2f(0.0f, 0.0f);
+        glVertex2f(0.0f, 0.0f);
+        glTexCoord2f(1.0f, 0.0f);
+        glVertex2f(1.0f, 0.0f);
+        glTexCoord2f(1.0f, 1.0f);
+        glVertex2f(1.0f, 1.0f);
+        glTexCoord2f(0.0f, 1.0f);
+        glVertex2f(0.0f, 1.0f);
+        glEnd();
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glDisable(GL_TEXTURE_2D);
+        glEnable(GL_BLEND);
+
+        glPopMatrix();
+        glMatrixMode(GL_PROJECTION);
+        glPopMatrix();
+        glMatrixMode(GL_MODELVIEW);
+    }
+
+private:
+    GLuint texture;
+    int width, height;
+    bool valid;
+    // what the texture was drawn with, any change means it is stale
+    ViewTransform view;
+    bool framework;
+};
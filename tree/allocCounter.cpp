@@ -0,0 +1,61 @@
+#include "include/allocCounter.h"
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// plain data, so touching it from operator new never needs a constructor to run first
+static thread_local AllocCounts counts = {0, 0, 0};
+
+AllocCounts threadAllocCounts() { return counts; }
+
+AllocCounts operator-(const AllocCounts &after, const AllocCounts &before)
+{
+    return {after.allocations - before.allocations, after.frees - before.frees, after.bytes - before.bytes};
+}
+
+static void release(void *ptr)
+{
+    if (!ptr)
+        return;
+    ++counts.frees;
+    std::free(ptr);
+}
+
+// what the standard asks of operator new, keep calling the new handler until it gives up
+static void *allocate(size_t size, size_t alignment)
+{
+    // every call has to hand out a distinct pointer, even for zero bytes
+    if (size == 0)
+        size = 1;
+    while (true)
+    {
+        void *ptr = nullptr;
+        if (alignment <= alignof(std::max_align_t))
+            ptr = std::malloc(size);
+        else if (posix_memalign(&ptr, alignment, size) != 0)
+            ptr = nullptr;
+        if (ptr)
+        {
+            ++counts.allocations;
+            counts.bytes += size;
+            return ptr;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+// the array and nothrow versions forward to these by default
+void *operator new(size_t size) { return allocate(size, 0); }
+
+void *operator new(size_t size, std::align_val_t alignment) { return allocate(size, static_cast<size_t>(alignment)); }
+
+void operator delete(void *ptr) noexcept { release(ptr); }
+
+void operator delete(void *ptr, std::align_val_t) noexcept { release(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { release(ptr); }
+
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept { release(ptr); }
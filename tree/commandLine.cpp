@@ -0,0 +1,900 @@
+#include "include/commandLine.h"
+#include "include/treeGenerator.h"
+#include "include/treeLayout.h"
+#include "include/treeQuery.h"
+#include "include/threadPool.h"
+#include "include/outOfCoreLayout.h"
+#include "include/fastTrig.h"
+#include "include/allocCounter.h"
+#include "include/layoutVerifier.h"
+#include "include/radialLayout.h"
+#include "include/layoutEngine.h"
+#include "include/forestLayout.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <set>
+#include <string>
+
+static void printUsage()
+{
+    std::cout << "usage:\n"
+              << "  FreeTreeDrawing                                   start the interactive viewer\n"
+              << "  FreeTreeDrawing <tree file>                       start the viewer on a tree from a file\n"
+              << "  FreeTreeDrawing --view <family> <nodes> [seed] [param]  start the viewer on a generated tree\n"
+              << "  FreeTreeDrawing --stream <- | pipe | unix:socket>  start the viewer on a live stream of edges\n"
+              << "  FreeTreeDrawing --generate <family> <nodes> <file> [seed] [param]\n"
+              << "  FreeTreeDrawing --bench <family> <nodes> [seed] [param]\n"
+              << "  FreeTreeDrawing --memory <family> <nodes> [seed] [param]  what a layout holds, full and compact\n"
+              << "  FreeTreeDrawing --query <tree file> [root]          reads \"u v\" lines, prints \"lca distance\"\n"
+              << "  FreeTreeDrawing --batch <dir or list file> <out dir> [--csv] [--threads n] [--fast-trig]\n"
+              << "  FreeTreeDrawing --out-of-core <tree file> <out file> [scratch dir] [--fast-trig]\n"
+              << "  FreeTreeDrawing --forest <forest file> <out file> [--csv] [--threads n] [--fast-trig]\n"
+              << "  FreeTreeDrawing --trig-check [samples]              fast trig against libm and the bounds\n"
+              << "  FreeTreeDrawing --verify [nodes] [seed]             every layout engine against the rules and the reference\n"
+              << "families:";
+    for (int i = 0; i < static_cast<int>(TreeFamily::COUNT); ++i)
+    {
+        std::cout << " " << TreeGenerator::familyName(static_cast<TreeFamily>(i));
+    }
+    std::cout << std::endl;
+}
+
+// reads "<family> <nodes> ... [seed] [param]" starting at argv[first]
+static bool parseGeneratorParams(int argc, char **argv, int first, int optional_at, GeneratorParams &params)
+{
+    if (argc <= first + 1 || !TreeGenerator::parseFamily(argv[first], params.family))
+        return false;
+    params.num_nodes = std::atoi(argv[first + 1]);
+    params.seed = argc > optional_at ? std::strtoull(argv[optional_at], nullptr, 10) : 1;
+    params.param = argc > optional_at + 1 ? std::atoi(argv[optional_at + 1]) : 0;
+    return params.num_nodes > 0;
+}
+
+static double millisSince(std::chrono::high_resolution_clock::time_point start)
+{
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1e6;
+}
+
+static int runGenerate(int argc, char **argv)
+{
+    GeneratorParams params;
+    if (argc < 5 || !parseGeneratorParams(argc, argv, 2, 5, params))
+    {
+        printUsage();
+        return 1;
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    std::string error;
+    if (!TreeGenerator::writeToFile(params, argv[4], &error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    std::cout << "wrote " << TreeGenerator::familyName(params.family) << " tree with " << params.num_nodes
+              << " nodes to " << argv[4] << " in " << millisSince(start) << " ms" << std::endl;
+    return 0;
+}
+
+// largest distance between where two layouts of the same tree put a node
+static double maxDrift(const TreeLayout &a, const TreeLayout &b)
+{
+    double drift = 0.0;
+    const auto &pa = a.getTargetPositions();
+    const auto &pb = b.getTargetPositions();
+    for (size_t i = 0; i < pa.size() && i < pb.size(); ++i)
+        drift = std::max(drift, std::hypot(static_cast<double>(pa[i].x) - pb[i].x, static_cast<double>(pa[i].y) - pb[i].y));
+    return drift;
+}
+
+static int runBench(int argc, char **argv)
+{
+    GeneratorParams params;
+    if (!parseGeneratorParams(argc, argv, 2, 4, params))
+    {
+        printUsage();
+        return 1;
+    }
+    Tree tree = TreeGenerator::generate(params);
+    if (tree.getNumVertices() == 0)
+        return 1;
+
+    TreeLayout layout(tree, 0, 0);
+    AllocCounts allocs_before = threadAllocCounts();
+    auto start = std::chrono::high_resolution_clock::now();
+    layout.calculateTrueCenterLayout();
+    double center_millis = millisSince(start);
+    AllocCounts center_allocs = threadAllocCounts() - allocs_before;
+
+    TreeLayout fast(tree, 0, 0);
+    fast.setTrigMode(TrigMode::FAST);
+    start = std::chrono::high_resolution_clock::now();
+    fast.calculateTrueCenterLayout();
+    double fast_millis = millisSince(start);
+    double drift = maxDrift(layout, fast);
+
+    TreeLayout shared(tree, 0, 0);
+    shared.setShareSubtrees(true);
+    start = std::chrono::high_resolution_clock::now();
+    shared.calculateTrueCenterLayout();
+    double shared_millis = millisSince(start);
+    size_t copied_nodes = 0;
+    for (const auto &copy : shared.getSharedSubtrees())
+        copied_nodes += shared.getSubtreeSize(copy.root);
+    double shared_drift = maxDrift(layout, shared);
+
+    TreeLayout precise(tree, 0, 0);
+    precise.setDoublePrecision(true);
+    start = std::chrono::high_resolution_clock::now();
+    precise.calculateTrueCenterLayout();
+    double double_millis = millisSince(start);
+    double double_drift = maxDrift(layout, precise);
+
+    // the other styles draw something else, so only their time is comparable
+    double style_millis[2];
+    const LayoutStyle other_styles[2] = {LayoutStyle::TIDY, LayoutStyle::BALLOON};
+    for (int i = 0; i < 2; ++i)
+    {
+        TreeLayout styled(tree, 0, 0);
+        styled.setStyle(other_styles[i]);
+        start = std::chrono::high_resolution_clock::now();
+        styled.calculateTrueCenterLayout();
+        style_millis[i] = millisSince(start);
+    }
+
+    // the second layout on the same object should mostly reuse the buffers of the first
+    allocs_before = threadAllocCounts();
+    start = std::chrono::high_resolution_clock::now();
+    layout.calculateLayoutFromRoot(tree.getNumVertices() - 1);
+    double reroot_millis = millisSince(start);
+    AllocCounts reroot_allocs = threadAllocCounts() - allocs_before;
+
+    std::cout << TreeGenerator::familyName(params.family) << " n=" << tree.getNumVertices()
+              << " max_depth=" << layout.getMaxDepth()
+              << " true_center_layout=" << center_millis << "ms"
+              << " fast_trig_layout=" << fast_millis << "ms"
+              << " reroot_layout=" << reroot_millis << "ms"
+              << " fast_trig_drift=" << drift
+              << " shared_layout=" << shared_millis << "ms"
+              << " shapes=" << shared.getNumShapes()
+              << " copied_nodes=" << copied_nodes
+              << " shared_drift=" << shared_drift
+              << " double_layout=" << double_millis << "ms"
+              << " double_drift=" << double_drift
+              << " true_center_allocs=" << center_allocs.allocations
+              << " (" << center_allocs.bytes / (1024.0 * 1024.0) << "MB)"
+              << " reroot_allocs=" << reroot_allocs.allocations
+              << " (" << reroot_allocs.bytes / (1024.0 * 1024.0) << "MB)";
+    for (int i = 0; i < 2; ++i)
+        std::cout << " " << layoutStyleName(other_styles[i]) << "_layout=" << style_millis[i] << "ms";
+    std::cout << std::endl;
+    // these repeat the same fan-out all over, sharing that finds nothing there is broken
+    bool repeats = params.family == TreeFamily::KARY || params.family == TreeFamily::SPIDER;
+    if (repeats && tree.getNumVertices() >= 1000 && copied_nodes == 0)
+    {
+        std::cerr << "sharing copied no subtrees of a " << TreeGenerator::familyName(params.family) << " tree" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// one layout of each kind, with what every part of it holds
+static int runMemory(int argc, char **argv)
+{
+    GeneratorParams params;
+    if (!parseGeneratorParams(argc, argv, 2, 4, params))
+    {
+        printUsage();
+        return 1;
+    }
+    Tree tree = TreeGenerator::generate(params);
+    if (tree.getNumVertices() == 0)
+        return 1;
+    double n = tree.getNumVertices();
+    std::cout << TreeGenerator::familyName(params.family) << " n=" << tree.getNumVertices() << " tree "
+              << tree.memoryUsage() / (1024.0 * 1024.0) << " MB (" << tree.memoryUsage() / n << " bytes per node)" << std::endl;
+
+    std::vector<Point> full_positions;
+    for (bool compact : {false, true})
+    {
+        // only one layout alive at a time, so a huge tree only has to fit once
+        TreeLayout layout(tree, 0, 0);
+        layout.setCompact(compact);
+        auto start = std::chrono::high_resolution_clock::now();
+        layout.calculateTrueCenterLayout();
+        double millis = millisSince(start);
+        std::vector<MemoryItem> report;
+        size_t total = layout.memoryUsage(&report);
+        std::cout << (compact ? "compact" : "full") << " layout=" << millis << "ms " << total / (1024.0 * 1024.0)
+                  << " MB (" << total / n << " bytes per node)";
+        // compact only drops what can be worked out again, and rounds the positions
+        if (compact)
+        {
+            std::vector<Point> positions;
+            layout.decodeTargetPositions(positions);
+            double drift = 0.0;
+            for (size_t i = 0; i < positions.size() && i < full_positions.size(); ++i)
+                drift = std::max(drift, std::hypot(static_cast<double>(positions[i].x) - full_positions[i].x, static_cast<double>(positions[i].y) - full_positions[i].y));
+            std::cout << " positions within " << drift << " px";
+        }
+        else
+        {
+            full_positions = layout.getTargetPositions();
+        }
+        std::cout << std::endl;
+        for (const auto &item : report)
+        {
+            if (item.bytes > 0)
+                std::cout << "  " << item.name << " " << item.bytes / (1024.0 * 1024.0) << " MB" << std::endl;
+        }
+    }
+    return 0;
+}
+
+// prints the worst error of one fast kernel next to its bound
+static bool reportTrigError(const char *name, double max_error, float bound)
+{
+    bool ok = max_error <= bound;
+    std::cout << name << " max error " << max_error << " (bound " << bound << ")" << (ok ? "" : "  FAILED") << std::endl;
+    return ok;
+}
+
+// the fast trig kernels against double precision libm, then both trig modes against each
+// other on every generator family. fails only if a kernel is outside its documented bound
+static int runTrigCheck(int argc, char **argv)
+{
+    size_t samples = argc > 2 ? static_cast<size_t>(std::max(1, std::atoi(argv[2]))) : 1000000;
+    std::mt19937 rng(1);
+    std::vector<float> x(samples), y(samples), out1(samples), out2(samples);
+
+    std::uniform_real_distribution<float> angle(-FAST_SINCOS_RANGE, FAST_SINCOS_RANGE);
+    for (auto &value : x)
+        value = angle(rng);
+    fastSinCos(x.data(), out1.data(), out2.data(), samples);
+    double sincos_error = 0.0;
+    for (size_t i = 0; i < samples; ++i)
+    {
+        sincos_error = std::max(sincos_error, std::fabs(out1[i] - std::sin(static_cast<double>(x[i]))));
+        sincos_error = std::max(sincos_error, std::fabs(out2[i] - std::cos(static_cast<double>(x[i]))));
+    }
+
+    // the ends and the switch between the two acos branches are where it would go wrong
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    for (auto &value : x)
+        value = unit(rng);
+    const float acos_edges[] = {-1.0f, 1.0f, 0.0f, 0.5f, -0.5f, std::nextafter(0.5f, 1.0f), std::nextafter(1.0f, 0.0f)};
+    for (size_t i = 0; i < std::size(acos_edges) && i < samples; ++i)
+        x[i] = acos_edges[i];
+    fastAcos(x.data(), out1.data(), samples);
+    double acos_error = 0.0;
+    for (size_t i = 0; i < samples; ++i)
+        acos_error = std::max(acos_error, std::fabs(out1[i] - std::acos(static_cast<double>(x[i]))));
+
+    // directions all around the circle at radii from tiny to huge, plus the axes and the origin
+    std::uniform_real_distribution<float> log_radius(-30.0f, 30.0f);
+    for (size_t i = 0; i < samples; ++i)
+    {
+        float r = std::exp(log_radius(rng)), a = angle(rng);
+        x[i] = r * std::cos(a);
+        y[i] = r * std::sin(a);
+    }
+    const float axes[][2] = {{0.0f, 0.0f}, {1.0f, 0.0f}, {0.0f, 1.0f}, {-1.0f, 0.0f}, {0.0f, -1.0f}, {1.0f, 1.0f}, {-1.0f, -1.0f}};
+    for (size_t i = 0; i < std::size(axes) && i < samples; ++i)
+    {
+        x[i] = axes[i][0];
+        y[i] = axes[i][1];
+    }
+    fastAtan2(y.data(), x.data(), out1.data(), samples);
+    double atan2_error = 0.0;
+    for (size_t i = 0; i < samples; ++i)
+        atan2_error = std::max(atan2_error, std::fabs(out1[i] - std::atan2(static_cast<double>(y[i]), static_cast<double>(x[i]))));
+
+    bool ok = reportTrigError("sincos", sincos_error, FAST_SINCOS_MAX_ERROR);
+    ok = reportTrigError("acos  ", acos_error, FAST_ACOS_MAX_ERROR) && ok;
+    ok = reportTrigError("atan2 ", atan2_error, FAST_ATAN2_MAX_ERROR) && ok;
+
+    // the small errors add up along every path, so how far apart the nodes end up depends on depth
+    for (int i = 0; i < static_cast<int>(TreeFamily::COUNT); ++i)
+    {
+        GeneratorParams params;
+        params.family = static_cast<TreeFamily>(i);
+        params.num_nodes = 100000;
+        Tree tree = TreeGenerator::generate(params);
+        TreeLayout precise(tree, 0, 0), fast(tree, 0, 0);
+        fast.setTrigMode(TrigMode::FAST);
+        auto start = std::chrono::high_resolution_clock::now();
+        precise.calculateTrueCenterLayout();
+        double precise_millis = millisSince(start);
+        start = std::chrono::high_resolution_clock::now();
+        fast.calculateTrueCenterLayout();
+        double fast_millis = millisSince(start);
+        std::cout << TreeGenerator::familyName(params.family) << " max_depth=" << precise.getMaxDepth()
+                  << " precise=" << precise_millis << "ms fast=" << fast_millis << "ms"
+                  << " max_drift=" << maxDrift(precise, fast) << std::endl;
+    }
+    return ok ? 0 : 1;
+}
+
+// another way of getting the reference layout, which the verifier holds to the same rules.
+// run leaves the positions around the origin and returns false to skip a tree it doesnt
+// apply to, with a reason in error if it failed instead
+struct VerifyEngine
+{
+    const char *name;
+    // how far a node may end up from the reference, as a fraction of the layout's radius since
+    // floats get coarser further out. negative means the positions are expected to drift and
+    // only the rules are checked
+    double max_deviation;
+    std::function<bool(const Tree &, const TreeLayout &, std::vector<Point> &, std::string &)> run;
+    // any other style is a different drawing altogether, only checked for crossing edges
+    LayoutStyle style = LayoutStyle::RADIAL;
+    // filled by run for an engine whose rules need more than the positions, like which
+    // subtrees are copies. the positions are checked on their own when it is empty
+    std::shared_ptr<LayoutCheck> own_check = nullptr;
+};
+
+static bool readPositions(const std::string &filename, std::vector<Point> &positions, std::string &error)
+{
+    std::ifstream in(filename, std::ios::binary);
+    char magic[4];
+    uint32_t count = 0;
+    if (!in.read(magic, 4) || std::string(magic, 4) != "RGLP" || !in.read(reinterpret_cast<char *>(&count), sizeof(count)))
+    {
+        error = "cant read " + filename;
+        return false;
+    }
+    positions.resize(count);
+    if (!in.read(reinterpret_cast<char *>(positions.data()), static_cast<std::streamsize>(count) * sizeof(Point)))
+    {
+        error = filename + " is cut short";
+        return false;
+    }
+    return true;
+}
+
+static std::vector<VerifyEngine> verifyEngines()
+{
+    auto fromLayout = [](const TreeLayout &layout, std::vector<Point> &positions)
+    {
+        layout.decodeTargetPositions(positions);
+        return true;
+    };
+    std::vector<VerifyEngine> engines;
+    // the two modes are compared here on every run: each kernel's error bound in fastTrig.h adds
+    // up along a path, which comes to a few 1e-7 of the radius on the generator families
+    engines.push_back({"fast-trig", 1e-5, [=](const Tree &tree, const TreeLayout &, std::vector<Point> &positions, std::string &)
+                       {
+                           TreeLayout layout(tree, 0, 0);
+                           layout.setTrigMode(TrigMode::FAST);
+                           layout.calculateTrueCenterLayout();
+                           return fromLayout(layout, positions);
+                       }});
+    // copies are their source moved as one piece, so they leave the rings and drift. the
+    // verifier holds them to their own rule, which only the layout knows them for
+    auto shared_check = std::make_shared<LayoutCheck>();
+    engines.push_back({"shared", -1.0, [=](const Tree &tree, const TreeLayout &, std::vector<Point> &positions, std::string &)
+                       {
+                           TreeLayout layout(tree, 0, 0);
+                           layout.setShareSubtrees(true);
+                           layout.calculateTrueCenterLayout();
+                           *shared_check = LayoutVerifier::check(tree, layout);
+                           return fromLayout(layout, positions);
+                       },
+                       LayoutStyle::RADIAL, shared_check});
+    engines.push_back({"double", 1e-5, [=](const Tree &tree, const TreeLayout &, std::vector<Point> &positions, std::string &)
+                       {
+                           TreeLayout layout(tree, 0, 0);
+                           layout.setDoublePrecision(true);
+                           layout.calculateTrueCenterLayout();
+                           return fromLayout(layout, positions);
+                       }});
+    for (LayoutStyle style : {LayoutStyle::TIDY, LayoutStyle::BALLOON})
+    {
+        engines.push_back({layoutStyleName(style), -1.0, [=](const Tree &tree, const TreeLayout &, std::vector<Point> &positions, std::string &)
+                           {
+                               TreeLayout layout(tree, 0, 0);
+                               layout.setStyle(style);
+                               layout.calculateTrueCenterLayout();
+                               return fromLayout(layout, positions);
+                           },
+                           style});
+    }
+    engines.push_back({"progressive", 0.0, [=](const Tree &tree, const TreeLayout &, std::vector<Point> &positions, std::string &)
+                       {
+                           TreeLayout layout(tree, 0, 0);
+                           layout.beginProgressiveLayout();
+                           while (!layout.stepProgressiveLayout(1000.0))
+                           {
+                           }
+                           return fromLayout(layout, positions);
+                       }});
+    // the positions come back from edge directions rounded to 32 bits, added up again one edge
+    // at a time. the float error of each edge's length adds up down a path like fast trig's
+    engines.push_back({"compact", 1e-5, [=](const Tree &tree, const TreeLayout &, std::vector<Point> &positions, std::string &)
+                       {
+                           TreeLayout layout(tree, 0, 0);
+                           layout.setCompact(true);
+                           layout.calculateTrueCenterLayout();
+                           return fromLayout(layout, positions);
+                       }});
+    // rooting at the center by hand is the same layout when there is only one
+    engines.push_back({"re-root", 0.0, [=](const Tree &tree, const TreeLayout &reference, std::vector<Point> &positions, std::string &)
+                       {
+                           if (reference.getCenterNodes().size() != 1)
+                               return false;
+                           TreeLayout layout(tree, 0, 0);
+                           layout.calculateTrueCenterLayout();
+                           layout.calculateLayoutFromRoot(reference.getCenterNodes()[0]);
+                           return fromLayout(layout, positions);
+                       }});
+    // the center's first child collapsed and expanded again in place, which only lays out its subtree
+    engines.push_back({"collapse", 0.0, [=](const Tree &tree, const TreeLayout &reference, std::vector<Point> &positions, std::string &)
+                       {
+                           if (reference.getPreorderNodes().size() < 2)
+                               return false;
+                           TreeLayout layout(tree, 0, 0);
+                           layout.calculateTrueCenterLayout();
+                           int u = reference.getPreorderNodes()[1];
+                           layout.toggleCollapsed(u);
+                           layout.toggleCollapsed(u);
+                           return fromLayout(layout, positions);
+                       }});
+    engines.push_back({"workspace", 0.0, [](const Tree &tree, const TreeLayout &, std::vector<Point> &positions, std::string &error)
+                       {
+                           std::vector<int> edges;
+                           edges.reserve(2 * tree.getEdges().size());
+                           for (const auto &edge : tree.getEdges())
+                           {
+                               edges.push_back(edge.first);
+                               edges.push_back(edge.second);
+                           }
+                           positions.resize(tree.getNumVertices());
+                           RadialLayoutWorkspace workspace;
+                           return workspace.layoutEdges(tree.getNumVertices(), edges.data(), RadialLayoutOptions(), &positions[0].x, &error);
+                       }});
+    // goes through files, so the tree is written out first
+    engines.push_back({"out-of-core", 0.0, [](const Tree &tree, const TreeLayout &, std::vector<Point> &positions, std::string &error)
+                       {
+                           std::filesystem::path dir = std::filesystem::temp_directory_path();
+                           std::string base = (dir / ("rgl_verify_" + std::to_string(std::random_device()()))).string();
+                           std::string tree_file = base + ".txt", pos_file = base + ".pos";
+                           std::ofstream out(tree_file);
+                           out << tree.getNumVertices() << "\n";
+                           for (const auto &edge : tree.getEdges())
+                               out << edge.first << " " << edge.second << "\n";
+                           out.close();
+                           OutOfCoreLayout layout;
+                           layout.setScratchDirectory(dir.string());
+                           bool ok = out && layout.run(tree_file, pos_file, &error) && readPositions(pos_file, positions, error);
+                           std::filesystem::remove(tree_file);
+                           std::filesystem::remove(pos_file);
+                           return ok;
+                       }});
+    return engines;
+}
+
+// checks the reference layout of every generator family against the rules in layoutVerifier.h,
+// then every other engine against the rules and against the reference. fails if anything
+// breaks a rule or drifts further than its engine allows
+static int runVerify(int argc, char **argv)
+{
+    int num_nodes = argc > 2 ? std::max(1, std::atoi(argv[2])) : 50000;
+    unsigned long long seed = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1;
+    std::vector<VerifyEngine> engines = verifyEngines();
+    bool ok = true;
+    auto report = [&](const char *family, const char *engine, double millis, const LayoutCheck &check, double deviation, double max_deviation)
+    {
+        bool passed = check.ok() && (max_deviation < 0.0 || deviation <= max_deviation);
+        ok = ok && passed;
+        std::printf("%-13s %-12s %9.2f ms  ring %.2e  wedge %.2e", family, engine, millis, check.max_ring_error, std::max(0.0, check.max_wedge_error));
+        if (deviation >= 0.0)
+            std::printf("  deviation %.3e", deviation);
+        std::printf("  %s%s\n", check.summary().c_str(), passed ? "" : "  FAILED");
+        for (const std::string &problem : check.problems)
+            std::printf("    %s\n", problem.c_str());
+        if (check.ok() && !passed)
+            std::printf("    more than the %g px it may drift\n", max_deviation);
+    };
+
+    for (int i = 0; i < static_cast<int>(TreeFamily::COUNT); ++i)
+    {
+        GeneratorParams params = {static_cast<TreeFamily>(i), num_nodes, seed, 0};
+        const char *family = TreeGenerator::familyName(params.family);
+        Tree tree = TreeGenerator::generate(params);
+        TreeLayout reference(tree, 0, 0);
+        auto start = std::chrono::high_resolution_clock::now();
+        reference.calculateTrueCenterLayout();
+        double millis = millisSince(start);
+        report(family, "reference", millis, LayoutVerifier::check(tree, reference), -1.0, -1.0);
+        const auto &expected = reference.getTargetPositions();
+        double radius = 0.0;
+        for (const Point &p : expected)
+            radius = std::max(radius, std::hypot(static_cast<double>(p.x), static_cast<double>(p.y)));
+
+        std::vector<Point> positions;
+        for (const VerifyEngine &engine : engines)
+        {
+            std::string error;
+            positions.clear();
+            start = std::chrono::high_resolution_clock::now();
+            bool ran = engine.run(tree, reference, positions, error);
+            millis = millisSince(start);
+            if (!ran)
+            {
+                if (!error.empty())
+                {
+                    ok = false;
+                    std::printf("%-13s %-12s failed: %s\n", family, engine.name, error.c_str());
+                }
+                continue;
+            }
+            if (engine.style != LayoutStyle::RADIAL)
+            {
+                report(family, engine.name, millis, LayoutVerifier::checkPlanar(tree, positions, reference.getCenterNodes()), -1.0, -1.0);
+                continue;
+            }
+            LayoutCheck check = engine.own_check ? *engine.own_check : LayoutVerifier::checkPositions(tree, positions, reference.getCenterNodes(), reference.getDelta());
+            double deviation = 0.0;
+            for (size_t u = 0; u < positions.size() && u < expected.size(); ++u)
+                deviation = std::max(deviation, std::hypot(static_cast<double>(positions[u].x) - expected[u].x, static_cast<double>(positions[u].y) - expected[u].y));
+            report(family, engine.name, millis, check, deviation, engine.max_deviation < 0.0 ? -1.0 : engine.max_deviation * radius);
+        }
+    }
+    std::cout << (ok ? "all engines keep the layout's rules" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
+
+// answers lca and distance for every "u v" pair on stdin, rooted like the gui would root it
+static int runQuery(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        printUsage();
+        return 1;
+    }
+    std::string error;
+    Tree tree = Tree::loadFromFile(argv[2], &error);
+    if (tree.getNumVertices() == 0)
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    int root = argc > 3 ? std::atoi(argv[3]) : -1;
+    if (root < -1 || root >= tree.getNumVertices())
+    {
+        std::cerr << "root " << root << " is not a node of the tree" << std::endl;
+        return 1;
+    }
+
+    TreeLayout layout(tree, 0, 0);
+    if (root == -1)
+        layout.calculateTrueCenterLayout();
+    else
+        layout.calculateLayoutFromRoot(root);
+    // timings go to stderr so stdout is only answers
+    auto start = std::chrono::high_resolution_clock::now();
+    TreeQuery query(layout);
+    std::cerr << "built queries in " << millisSince(start) << " ms, " << query.memoryUsage() / (1024.0 * 1024.0) << " MB" << std::endl;
+
+    std::vector<std::pair<int, int>> pairs;
+    int u, v;
+    while (std::cin >> u >> v)
+        pairs.emplace_back(u, v);
+    start = std::chrono::high_resolution_clock::now();
+    std::vector<int> lcas, distances;
+    query.lcaBatch(pairs, lcas);
+    query.distanceBatch(pairs, distances);
+    std::cerr << "answered " << pairs.size() << " queries in " << millisSince(start) << " ms" << std::endl;
+
+    std::string out;
+    for (size_t i = 0; i < pairs.size(); ++i)
+    {
+        out += std::to_string(lcas[i]);
+        out += ' ';
+        out += std::to_string(distances[i]);
+        out += '\n';
+    }
+    std::cout << out;
+    return 0;
+}
+
+// every regular file in a directory, or every non empty line of a list file
+static bool collectBatchInputs(const std::string &input, std::vector<std::string> &files, std::string &error)
+{
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    if (fs::is_directory(input, ec))
+    {
+        for (const auto &entry : fs::directory_iterator(input, ec))
+        {
+            if (entry.is_regular_file(ec))
+                files.push_back(entry.path().string());
+        }
+        // directory order is arbitrary, sorting keeps runs comparable
+        std::sort(files.begin(), files.end());
+    }
+    else
+    {
+        std::ifstream list(input);
+        if (!list)
+        {
+            error = "cannot open " + input;
+            return false;
+        }
+        std::string line;
+        while (std::getline(list, line))
+        {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (!line.empty())
+                files.push_back(line);
+        }
+    }
+    if (ec)
+    {
+        error = input + ": " + ec.message();
+        return false;
+    }
+    return true;
+}
+
+// lays out every tree of a directory or list on a thread pool, one tree per task
+static int runBatch(int argc, char **argv)
+{
+    namespace fs = std::filesystem;
+    if (argc < 4)
+    {
+        printUsage();
+        return 1;
+    }
+    bool csv = false;
+    unsigned num_threads = 0;
+    TrigMode trig_mode = TrigMode::PRECISE;
+    for (int i = 4; i < argc; ++i)
+    {
+        std::string option = argv[i];
+        if (option == "--csv")
+            csv = true;
+        else if (option == "--threads" && i + 1 < argc)
+            num_threads = static_cast<unsigned>(std::max(0, std::atoi(argv[++i])));
+        else if (option == "--fast-trig")
+            trig_mode = TrigMode::FAST;
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    std::vector<std::string> files;
+    std::string error;
+    if (!collectBatchInputs(argv[2], files, error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    std::error_code ec;
+    fs::create_directories(argv[3], ec);
+    if (ec)
+    {
+        std::cerr << "cannot create " << argv[3] << ": " << ec.message() << std::endl;
+        return 1;
+    }
+
+    // name each output after its input, numbering repeats so nothing gets overwritten
+    std::vector<std::string> outputs(files.size());
+    std::set<std::string> taken;
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        std::string name = fs::path(files[i]).stem().string();
+        // a numbered name can be another input's own name, so count on until one is free
+        std::string stem = name;
+        for (size_t k = i; !taken.insert(name).second; ++k)
+            name = stem + "_" + std::to_string(k);
+        outputs[i] = (fs::path(argv[3]) / (name + (csv ? ".csv" : ".pos"))).string();
+    }
+
+    std::atomic<long long> total_nodes(0);
+    std::atomic<int> finished(0);
+    std::mutex print_mutex;
+    auto start = std::chrono::high_resolution_clock::now();
+    ThreadPool pool(num_threads);
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        pool.submit([&, i]()
+                    {
+            // loadFromFile reports its own errors. the pool already keeps every thread busy,
+            // so each file is checked on its own one
+            Tree tree = Tree::loadFromFile(files[i], nullptr, false, false);
+            if (tree.getNumVertices() == 0)
+                return;
+            TreeLayout layout(tree, 0, 0);
+            layout.setTrigMode(trig_mode);
+            layout.calculateTrueCenterLayout();
+            std::string write_error;
+            if (!layout.writePositions(outputs[i], csv, &write_error))
+            {
+                std::lock_guard<std::mutex> lock(print_mutex);
+                std::cerr << write_error << std::endl;
+                return;
+            }
+            total_nodes += tree.getNumVertices();
+            finished++; });
+    }
+    pool.wait();
+    double millis = millisSince(start);
+
+    double seconds = millis / 1000.0;
+    std::cout << "laid out " << finished << " of " << files.size() << " trees (" << total_nodes << " nodes) on "
+              << pool.getNumThreads() << " threads in " << millis << " ms, "
+              << (seconds > 0 ? finished / seconds : 0.0) << " trees/s, "
+              << (seconds > 0 ? total_nodes / seconds / 1e6 : 0.0) << " M nodes/s" << std::endl;
+    return finished == static_cast<int>(files.size()) ? 0 : 1;
+}
+
+// lays out every tree of a file that may hold many, packed side by side into one set of positions
+static int runForest(int argc, char **argv)
+{
+    if (argc < 4)
+    {
+        printUsage();
+        return 1;
+    }
+    bool csv = false;
+    unsigned num_threads = 0;
+    TrigMode trig_mode = TrigMode::PRECISE;
+    for (int i = 4; i < argc; ++i)
+    {
+        std::string option = argv[i];
+        if (option == "--csv")
+            csv = true;
+        else if (option == "--threads" && i + 1 < argc)
+            num_threads = static_cast<unsigned>(std::max(0, std::atoi(argv[++i])));
+        else if (option == "--fast-trig")
+            trig_mode = TrigMode::FAST;
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    // loadFromFile reports its own errors
+    Tree forest = Tree::loadFromFile(argv[2], nullptr, true);
+    if (forest.getNumVertices() == 0)
+        return 1;
+    double load_millis = millisSince(start);
+
+    ForestLayout layout(forest, 0, 0);
+    layout.setTrigMode(trig_mode);
+    layout.setNumThreads(num_threads);
+    start = std::chrono::high_resolution_clock::now();
+    std::string error;
+    if (!layout.calculate(&error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    double millis = millisSince(start);
+    if (!layout.writePositions(argv[3], csv, &error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    const ForestTimings &timings = layout.getTimings();
+    double seconds = millis / 1000.0;
+    std::cout << "laid out " << layout.getComponents().size() << " trees (" << forest.getNumVertices() << " nodes) on "
+              << (num_threads ? num_threads : std::max(1u, std::thread::hardware_concurrency())) << " threads in " << millis << " ms"
+              << " (load " << load_millis << " ms, split " << timings.split_millis << " ms, layout " << timings.layout_millis
+              << " ms, pack " << timings.pack_millis << " ms), "
+              << (seconds > 0 ? forest.getNumVertices() / seconds / 1e6 : 0.0) << " M nodes/s" << std::endl;
+    return 0;
+}
+
+// lays out a tree too big for memory with every array in a mapped scratch file
+static int runOutOfCore(int argc, char **argv)
+{
+    if (argc < 4)
+    {
+        printUsage();
+        return 1;
+    }
+    OutOfCoreLayout layout;
+    for (int i = 4; i < argc; ++i)
+    {
+        std::string option = argv[i];
+        if (option == "--fast-trig")
+            layout.setTrigMode(TrigMode::FAST);
+        else
+            layout.setScratchDirectory(option);
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    std::string error;
+    if (!layout.run(argv[2], argv[3], &error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    std::cout << "laid out " << layout.getNumVertices() << " nodes out of core in " << millisSince(start)
+              << " ms, peak scratch " << layout.getPeakScratchBytes() / (1024.0 * 1024.0) << " MB" << std::endl;
+    return 0;
+}
+
+int runCommandLine(int argc, char **argv)
+{
+    if (argc < 2)
+        return -1;
+    std::string mode = argv[1];
+    if (mode == "--generate")
+        return runGenerate(argc, argv);
+    if (mode == "--bench")
+        return runBench(argc, argv);
+    if (mode == "--memory")
+        return runMemory(argc, argv);
+    if (mode == "--query")
+        return runQuery(argc, argv);
+    if (mode == "--batch")
+        return runBatch(argc, argv);
+    if (mode == "--out-of-core")
+        return runOutOfCore(argc, argv);
+    if (mode == "--forest")
+        return runForest(argc, argv);
+    if (mode == "--trig-check")
+        return runTrigCheck(argc, argv);
+    if (mode == "--verify")
+        return runVerify(argc, argv);
+    // the viewer reads the stream itself, it only needs a source
+    if (mode == "--stream" && argc < 3)
+    {
+        printUsage();
+        return 1;
+    }
+    // and builds its own startup tree, the arguments only have to make sense
+    GeneratorParams params;
+    if (mode == "--view" && !parseGeneratorParams(argc, argv, 2, 4, params))
+    {
+        printUsage();
+        return 1;
+    }
+    if (mode == "--help" || mode == "-h")
+    {
+        printUsage();
+        return 0;
+    }
+    return -1;
+}
+
+bool startupTreeFromArgs(int argc, char **argv, std::function<Tree(std::string &error)> &build)
+{
+    if (argc < 2)
+        return false;
+    std::string mode = argv[1];
+    if (mode == "--view")
+    {
+        GeneratorParams params;
+        if (!parseGeneratorParams(argc, argv, 2, 4, params))
+            return false;
+        build = [params](std::string &)
+        { return TreeGenerator::generate(params); };
+        return true;
+    }
+    // any other option is for something else, a plain argument is a file
+    if (mode.rfind("--", 0) == 0)
+        return false;
+    build = [mode](std::string &error)
+    { return Tree::loadFromFile(mode, &error); };
+    return true;
+}
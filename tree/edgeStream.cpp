@@ -0,0 +1,368 @@
+#include "include/edgeStream.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// how long the reader blocks in poll before it checks whether it should stop
+static const int POLL_TIMEOUT_MS = 100;
+static const size_t READ_BUFFER_SIZE = 1 << 16;
+
+static const char *parseId(const char *p, const char *end, int &out)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+        ++p;
+    auto result = std::from_chars(p, end, out);
+    return result.ec == std::errc() ? result.ptr : nullptr;
+}
+
+bool parseEdgeDelta(const char *begin, const char *end, EdgeDelta &out)
+{
+    const char *p = begin;
+    while (p < end && (*p == ' ' || *p == '\t'))
+        ++p;
+    out.add = true;
+    if (p < end && (*p == '+' || *p == '-'))
+    {
+        out.add = (*p == '+');
+        ++p;
+    }
+    p = parseId(p, end, out.u);
+    if (p)
+        p = parseId(p, end, out.v);
+    return p != nullptr;
+}
+
+EdgeStream::EdgeStream(size_t capacity)
+    : queue(capacity), stopping(false), state(StreamState::WAITING), received(0), malformed(0),
+      kind(Kind::STDIN), listen_fd(-1), created_path(false)
+{
+}
+
+EdgeStream::~EdgeStream() { stop(); }
+
+bool EdgeStream::start(const std::string &source_name, std::string *error)
+{
+    stop();
+    source = source_name;
+    auto fail = [&](const std::string &what)
+    {
+        if (error)
+            *error = what + " " + path + ": " + strerror(errno);
+        if (listen_fd >= 0)
+            ::close(listen_fd);
+        listen_fd = -1;
+        return false;
+    };
+
+    if (source == "-")
+    {
+        kind = Kind::STDIN;
+        path.clear();
+    }
+    else if (source.compare(0, 5, "unix:") == 0)
+    {
+        kind = Kind::SOCKET;
+        path = source.substr(5);
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(address.sun_path))
+        {
+            errno = ENAMETOOLONG;
+            return fail("bad socket path");
+        }
+        memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listen_fd < 0)
+            return fail("cannot create socket");
+        // a socket file left behind by an earlier run would make bind fail
+        unlink(path.c_str());
+        if (bind(listen_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+            return fail("cannot bind");
+        if (listen(listen_fd, 1) != 0)
+            return fail("cannot listen on");
+        created_path = true;
+    }
+    else
+    {
+        kind = Kind::FIFO;
+        path = source;
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0)
+        {
+            if (mkfifo(path.c_str(), 0600) != 0)
+                return fail("cannot create pipe");
+            created_path = true;
+        }
+        else if (!S_ISFIFO(info.st_mode))
+        {
+            if (error)
+                *error = path + " exists but is not a named pipe";
+            return false;
+        }
+    }
+
+    stopping = false;
+    state = StreamState::WAITING;
+    thread = std::thread(&EdgeStream::run, this);
+    return true;
+}
+
+void EdgeStream::stop()
+{
+    stopping = true;
+    if (thread.joinable())
+        thread.join();
+    if (listen_fd >= 0)
+        ::close(listen_fd);
+    listen_fd = -1;
+    if (created_path)
+        unlink(path.c_str());
+    created_path = false;
+}
+
+void EdgeStream::setOnEvents(std::function<void()> callback)
+{
+    on_events = std::move(callback);
+}
+
+size_t EdgeStream::drain(std::vector<EdgeDelta> &out)
+{
+    return queue.popAll(out);
+}
+
+bool EdgeStream::hasEvents() const { return !queue.empty(); }
+
+StreamState EdgeStream::getState() const { return state; }
+
+const std::string &EdgeStream::getSource() const { return source; }
+
+uint64_t EdgeStream::getNumReceived() const { return received; }
+
+uint64_t EdgeStream::getNumMalformed() const { return malformed; }
+
+void EdgeStream::run()
+{
+    if (kind == Kind::STDIN)
+    {
+        state = StreamState::CONNECTED;
+        readFrom(STDIN_FILENO);
+        if (!stopping)
+            state = StreamState::CLOSED;
+        return;
+    }
+
+    while (!stopping)
+    {
+        int fd = -1;
+        if (kind == Kind::FIFO)
+        {
+            // non blocking so the open doesnt wait for a writer, poll does that instead
+            fd = ::open(path.c_str(), O_RDONLY | O_NONBLOCK);
+        }
+        else
+        {
+            pollfd listening = {listen_fd, POLLIN, 0};
+            if (poll(&listening, 1, POLL_TIMEOUT_MS) <= 0)
+                continue;
+            fd = accept(listen_fd, nullptr, nullptr);
+        }
+        if (fd < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            state = StreamState::FAILED;
+            return;
+        }
+        readFrom(fd);
+        ::close(fd);
+        state = StreamState::WAITING;
+    }
+}
+
+// reads until the writer hangs up or the stream gets stopped, one batch per read call
+void EdgeStream::readFrom(int fd)
+{
+    std::vector<char> buffer(READ_BUFFER_SIZE);
+    std::vector<EdgeDelta> batch;
+    size_t carry = 0; // start of a line the last read cut off
+    while (!stopping)
+    {
+        pollfd readable = {fd, POLLIN, 0};
+        int ready = poll(&readable, 1, POLL_TIMEOUT_MS);
+        if (ready < 0 && errno != EINTR)
+            return;
+        if (ready <= 0)
+            continue;
+
+        ssize_t got = read(fd, buffer.data() + carry, buffer.size() - carry);
+        if (got < 0)
+        {
+            if (errno == EINTR || errno == EAGAIN)
+                continue;
+            return;
+        }
+        state = StreamState::CONNECTED;
+        // at the end the last line counts even without a newline
+        size_t filled = carry + static_cast<size_t>(got);
+        const char *p = buffer.data();
+        const char *end = p + filled;
+        while (true)
+        {
+            const char *line_end = std::find(p, end, '\n');
+            if (line_end == end && got > 0)
+                break;
+            const char *first = p;
+            while (first < line_end && (*first == ' ' || *first == '\t' || *first == '\r'))
+                ++first;
+            // blank lines and comments are fine, anything else has to be an edge
+            if (first < line_end && *first != '#')
+            {
+                EdgeDelta delta;
+                if (parseEdgeDelta(first, line_end, delta))
+                    batch.push_back(delta);
+                else
+                    ++malformed;
+            }
+            if (line_end == end)
+            {
+                p = end;
+                break;
+            }
+            p = line_end + 1;
+        }
+        carry = static_cast<size_t>(end - p);
+        if (carry == buffer.size())
+        {
+            // a line longer than the whole buffer, it cant be an edge
+            ++malformed;
+            carry = 0;
+        }
+        memmove(buffer.data(), p, carry);
+        flush(batch);
+        if (got == 0)
+            return;
+    }
+}
+
+// queues the batch, waiting for room if the ui has fallen behind
+void EdgeStream::flush(std::vector<EdgeDelta> &batch)
+{
+    size_t done = 0;
+    while (done < batch.size())
+    {
+        size_t pushed = queue.push(batch.data() + done, batch.size() - done);
+        done += pushed;
+        if (pushed > 0)
+        {
+            received += pushed;
+            if (on_events)
+                on_events();
+        }
+        if (done < batch.size())
+        {
+            if (stopping)
+                break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    batch.clear();
+}
+
+LiveEdgeSet::LiveEdgeSet() : live_count(0), num_removed(0) {}
+
+uint64_t LiveEdgeSet::key(int u, int v)
+{
+    uint32_t a = static_cast<uint32_t>(std::min(u, v));
+    uint32_t b = static_cast<uint32_t>(std::max(u, v));
+    return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+bool LiveEdgeSet::apply(const std::vector<EdgeDelta> &deltas)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return applyLocked(deltas);
+}
+
+bool LiveEdgeSet::tryApply(const std::vector<EdgeDelta> &deltas, bool &changed)
+{
+    std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+    if (!lock.owns_lock())
+        return false;
+    changed = applyLocked(deltas);
+    return true;
+}
+
+bool LiveEdgeSet::applyLocked(const std::vector<EdgeDelta> &deltas)
+{
+    bool changed = false;
+    for (const auto &delta : deltas)
+    {
+        // these could never be part of a tree
+        if (delta.u < 0 || delta.v < 0 || delta.u == delta.v)
+            continue;
+        uint64_t k = key(delta.u, delta.v);
+        if (delta.add)
+        {
+            if (index.emplace(k, edges.size()).second)
+            {
+                edges.emplace_back(delta.u, delta.v);
+                changed = true;
+            }
+        }
+        else
+        {
+            auto it = index.find(k);
+            if (it != index.end())
+            {
+                edges[it->second] = {-1, -1};
+                index.erase(it);
+                ++num_removed;
+                changed = true;
+            }
+        }
+    }
+    if (num_removed > 1024 && num_removed > index.size())
+        compact();
+    live_count = index.size();
+    return changed;
+}
+
+void LiveEdgeSet::compact()
+{
+    size_t kept = 0;
+    for (const auto &edge : edges)
+    {
+        if (edge.first < 0)
+            continue;
+        index[key(edge.first, edge.second)] = kept;
+        edges[kept++] = edge;
+    }
+    edges.resize(kept);
+    num_removed = 0;
+}
+
+int LiveEdgeSet::snapshot(std::vector<std::pair<int, int>> &out) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    out.clear();
+    out.reserve(index.size());
+    int largest = 0;
+    for (const auto &edge : edges)
+    {
+        if (edge.first < 0)
+            continue;
+        out.push_back(edge);
+        largest = std::max(largest, std::max(edge.first, edge.second));
+    }
+    return largest + 1;
+}
+
+size_t LiveEdgeSet::size() const { return live_count; }
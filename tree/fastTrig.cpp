@@ -0,0 +1,242 @@
+#include "include/fastTrig.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FAST_TRIG_SSE2 1
+#endif
+
+static const float PI_F = 3.14159265358979f;
+static const float HALF_PI_F = 1.57079632679490f;
+static const float QUARTER_PI_F = 0.785398163397448f;
+static const float TWO_OVER_PI = 0.636619772367581f;
+// pi / 2 in three parts, the first two with few enough bits that k times them is exact
+static const float PIO2_1 = 1.5703125f;
+static const float PIO2_2 = 4.837512969970703125e-4f;
+static const float PIO2_3 = 7.54978995489188216e-8f;
+// sin and cos on [-pi/4, pi/4]
+static const float SIN_1 = -1.6666654611e-1f, SIN_2 = 8.3321608736e-3f, SIN_3 = -1.9515295891e-4f;
+static const float COS_1 = 4.166664568298827e-2f, COS_2 = -1.388731625493765e-3f, COS_3 = 2.443315711809948e-5f;
+// asin on [0, 0.5]
+static const float ASIN_1 = 1.6666752422e-1f, ASIN_2 = 7.4953002686e-2f, ASIN_3 = 4.5470025998e-2f,
+                   ASIN_4 = 2.4181311049e-2f, ASIN_5 = 4.2163199048e-2f;
+// atan on [-tan(pi/8), tan(pi/8)]
+static const float TAN_PI_8 = 0.414213562373095f;
+static const float ATAN_1 = -3.33329491539e-1f, ATAN_2 = 1.99777106478e-1f, ATAN_3 = -1.38776856032e-1f,
+                   ATAN_4 = 8.05374449538e-2f;
+
+#ifdef FAST_TRIG_SSE2
+
+static inline __m128 select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128 splat(float x) { return _mm_set1_ps(x); }
+
+static void sinCos4(__m128 x, __m128 &s, __m128 &c)
+{
+    // x = k * pi/2 + r with r in [-pi/4, pi/4]
+    __m128i k = _mm_cvtps_epi32(_mm_mul_ps(x, splat(TWO_OVER_PI)));
+    __m128 kf = _mm_cvtepi32_ps(k);
+    __m128 r = _mm_sub_ps(x, _mm_mul_ps(kf, splat(PIO2_1)));
+    r = _mm_sub_ps(r, _mm_mul_ps(kf, splat(PIO2_2)));
+    r = _mm_sub_ps(r, _mm_mul_ps(kf, splat(PIO2_3)));
+    __m128 z = _mm_mul_ps(r, r);
+
+    __m128 ps = _mm_add_ps(_mm_mul_ps(splat(SIN_3), z), splat(SIN_2));
+    ps = _mm_add_ps(_mm_mul_ps(ps, z), splat(SIN_1));
+    __m128 sin_r = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(ps, z), r), r);
+
+    __m128 pc = _mm_add_ps(_mm_mul_ps(splat(COS_3), z), splat(COS_2));
+    pc = _mm_add_ps(_mm_mul_ps(pc, z), splat(COS_1));
+    __m128 cos_r = _mm_add_ps(_mm_sub_ps(splat(1.0f), _mm_mul_ps(splat(0.5f), z)), _mm_mul_ps(_mm_mul_ps(pc, z), z));
+
+    // odd quadrants swap sin and cos, then the quadrant decides the signs
+    __m128i one = _mm_set1_epi32(1), two = _mm_set1_epi32(2);
+    __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(k, one), one));
+    __m128 sin_sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(k, two), 30));
+    __m128 cos_sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(k, one), two), 30));
+    s = _mm_xor_ps(select(swap, cos_r, sin_r), sin_sign);
+    c = _mm_xor_ps(select(swap, sin_r, cos_r), cos_sign);
+}
+
+static __m128 asinSmall4(__m128 t, __m128 z)
+{
+    __m128 p = _mm_add_ps(_mm_mul_ps(splat(ASIN_5), z), splat(ASIN_4));
+    p = _mm_add_ps(_mm_mul_ps(p, z), splat(ASIN_3));
+    p = _mm_add_ps(_mm_mul_ps(p, z), splat(ASIN_2));
+    p = _mm_add_ps(_mm_mul_ps(p, z), splat(ASIN_1));
+    return _mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, z), t), t);
+}
+
+static __m128 acos4(__m128 x)
+{
+    __m128 sign_mask = splat(-0.0f);
+    __m128 a = _mm_andnot_ps(sign_mask, x);
+    // above 0.5 go through acos(a) = 2 asin(sqrt((1 - a) / 2)), which stays accurate near 1
+    __m128 big = _mm_cmpgt_ps(a, splat(0.5f));
+    __m128 z_big = _mm_mul_ps(splat(0.5f), _mm_sub_ps(splat(1.0f), a));
+    __m128 t = select(big, _mm_sqrt_ps(z_big), a);
+    __m128 z = select(big, z_big, _mm_mul_ps(a, a));
+    __m128 p = asinSmall4(t, z);
+    __m128 acos_a = select(big, _mm_add_ps(p, p), _mm_sub_ps(splat(HALF_PI_F), p));
+    __m128 negative = _mm_cmplt_ps(x, _mm_setzero_ps());
+    return select(negative, _mm_sub_ps(splat(PI_F), acos_a), acos_a);
+}
+
+static __m128 atan24(__m128 y, __m128 x)
+{
+    __m128 sign_mask = splat(-0.0f);
+    __m128 ax = _mm_andnot_ps(sign_mask, x);
+    __m128 ay = _mm_andnot_ps(sign_mask, y);
+    __m128 big = _mm_max_ps(ax, ay);
+    // atan of the smaller over the larger stays in [0, 1], and 0 / 0 becomes 0
+    __m128 t = _mm_div_ps(_mm_min_ps(ax, ay), big);
+    t = _mm_andnot_ps(_mm_cmpeq_ps(big, _mm_setzero_ps()), t);
+    __m128 reduce = _mm_cmpgt_ps(t, splat(TAN_PI_8));
+    t = select(reduce, _mm_div_ps(_mm_sub_ps(t, splat(1.0f)), _mm_add_ps(t, splat(1.0f))), t);
+    __m128 z = _mm_mul_ps(t, t);
+    __m128 p = _mm_add_ps(_mm_mul_ps(splat(ATAN_4), z), splat(ATAN_3));
+    p = _mm_add_ps(_mm_mul_ps(p, z), splat(ATAN_2));
+    p = _mm_add_ps(_mm_mul_ps(p, z), splat(ATAN_1));
+    __m128 r = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, z), t), t);
+    r = select(reduce, _mm_add_ps(splat(QUARTER_PI_F), r), r);
+    // back out to the full circle: past 45 degrees, then the left half, then below the axis
+    r = select(_mm_cmpgt_ps(ay, ax), _mm_sub_ps(splat(HALF_PI_F), r), r);
+    r = select(_mm_cmplt_ps(x, _mm_setzero_ps()), _mm_sub_ps(splat(PI_F), r), r);
+    return _mm_or_ps(r, _mm_and_ps(sign_mask, y));
+}
+
+// runs a four lane kernel over an array. the tail is padded into a full vector instead of
+// taking a scalar path, so every element sees exactly the same arithmetic
+template <typename Kernel>
+static void forEachQuad(size_t count, Kernel kernel)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        kernel(i, 4);
+    if (i < count)
+        kernel(i, count - i);
+}
+
+static __m128 load(const float *p, size_t n)
+{
+    if (n == 4)
+        return _mm_loadu_ps(p);
+    float lanes[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    memcpy(lanes, p, n * sizeof(float));
+    return _mm_loadu_ps(lanes);
+}
+
+static void store(float *p, __m128 v, size_t n)
+{
+    if (n == 4)
+    {
+        _mm_storeu_ps(p, v);
+        return;
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, v);
+    memcpy(p, lanes, n * sizeof(float));
+}
+
+void fastSinCos(const float *angles, float *sines, float *cosines, size_t count)
+{
+    forEachQuad(count, [&](size_t i, size_t n)
+                {
+        __m128 s, c;
+        sinCos4(load(angles + i, n), s, c);
+        store(sines + i, s, n);
+        store(cosines + i, c, n); });
+}
+
+void fastAcos(const float *x, float *out, size_t count)
+{
+    forEachQuad(count, [&](size_t i, size_t n)
+                { store(out + i, acos4(load(x + i, n)), n); });
+}
+
+void fastAtan2(const float *y, const float *x, float *out, size_t count)
+{
+    forEachQuad(count, [&](size_t i, size_t n)
+                { store(out + i, atan24(load(y + i, n), load(x + i, n)), n); });
+}
+
+#else
+
+// the same polynomials one value at a time, for targets without sse2
+
+static void sinCos1(float x, float &s, float &c)
+{
+    int k = static_cast<int>(std::nearbyint(x * TWO_OVER_PI));
+    float kf = static_cast<float>(k);
+    float r = x - kf * PIO2_1;
+    r = r - kf * PIO2_2;
+    r = r - kf * PIO2_3;
+    float z = r * r;
+    float sin_r = ((SIN_3 * z + SIN_2) * z + SIN_1) * z * r + r;
+    float cos_r = (1.0f - 0.5f * z) + ((COS_3 * z + COS_2) * z + COS_1) * z * z;
+    s = (k & 1) ? cos_r : sin_r;
+    c = (k & 1) ? sin_r : cos_r;
+    if (k & 2)
+        s = -s;
+    if ((k + 1) & 2)
+        c = -c;
+}
+
+static float asinSmall1(float t, float z)
+{
+    return ((((ASIN_5 * z + ASIN_4) * z + ASIN_3) * z + ASIN_2) * z + ASIN_1) * z * t + t;
+}
+
+static float acos1(float x)
+{
+    float a = std::fabs(x);
+    bool big = a > 0.5f;
+    float z_big = 0.5f * (1.0f - a);
+    float p = big ? asinSmall1(std::sqrt(z_big), z_big) : asinSmall1(a, a * a);
+    float acos_a = big ? p + p : HALF_PI_F - p;
+    return x < 0.0f ? PI_F - acos_a : acos_a;
+}
+
+static float atan21(float y, float x)
+{
+    float ax = std::fabs(x), ay = std::fabs(y);
+    float big = std::max(ax, ay);
+    float t = big == 0.0f ? 0.0f : std::min(ax, ay) / big;
+    bool reduce = t > TAN_PI_8;
+    if (reduce)
+        t = (t - 1.0f) / (t + 1.0f);
+    float z = t * t;
+    float r = (((ATAN_4 * z + ATAN_3) * z + ATAN_2) * z + ATAN_1) * z * t + t;
+    if (reduce)
+        r = QUARTER_PI_F + r;
+    if (ay > ax)
+        r = HALF_PI_F - r;
+    if (x < 0.0f)
+        r = PI_F - r;
+    return std::signbit(y) ? -r : r;
+}
+
+void fastSinCos(const float *angles, float *sines, float *cosines, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        sinCos1(angles[i], sines[i], cosines[i]);
+}
+
+void fastAcos(const float *x, float *out, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        out[i] = acos1(x[i]);
+}
+
+void fastAtan2(const float *y, const float *x, float *out, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        out[i] = atan21(y[i], x[i]);
+}
+
+#endif
@@ -0,0 +1,233 @@
+#include "include/forestLayout.h"
+#include "include/radialLayout.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+// trees smaller than this share a task, so a forest of tiny trees doesnt drown in queueing
+static const int BATCH_NODES = 1 << 14;
+
+static double millisSince(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+ForestLayout::ForestLayout(const Tree &forest, int halfwidth, int halfheight, float delta)
+    : forest_ref(forest), DELTA(delta), halfwidth(halfwidth), halfheight(halfheight), trig_mode(TrigMode::PRECISE), num_threads(0) {}
+
+void ForestLayout::setTrigMode(TrigMode mode) { trig_mode = mode; }
+TrigMode ForestLayout::getTrigMode() const { return trig_mode; }
+void ForestLayout::setNumThreads(unsigned threads) { num_threads = threads; }
+unsigned ForestLayout::getNumThreads() const { return num_threads; }
+
+const std::vector<Point> &ForestLayout::getPositions() const { return positions; }
+const std::vector<ForestComponent> &ForestLayout::getComponents() const { return components; }
+const std::vector<int> &ForestLayout::getComponentNodes() const { return component_nodes; }
+const std::vector<int> &ForestLayout::getComponentOf() const { return component_of; }
+const ForestTimings &ForestLayout::getTimings() const { return timings; }
+
+bool ForestLayout::writePositions(const std::string &filename, bool csv, std::string *error) const
+{
+    return TreeLayout::writePositions(filename, positions, csv, error);
+}
+
+bool ForestLayout::calculate(std::string *error)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    split();
+    timings.split_millis = millisSince(start);
+
+    // biggest trees first so the long ones dont start last, then the small ones in batches
+    std::vector<int> order(components.size());
+    for (size_t c = 0; c < order.size(); ++c)
+        order[c] = static_cast<int>(c);
+    std::sort(order.begin(), order.end(), [this](int a, int b)
+              { return components[a].size > components[b].size; });
+    std::vector<std::vector<int>> batches;
+    int batch_nodes = BATCH_NODES;
+    for (int c : order)
+    {
+        if (batch_nodes >= BATCH_NODES)
+        {
+            batches.emplace_back();
+            batch_nodes = 0;
+        }
+        batches.back().push_back(c);
+        batch_nodes += components[c].size;
+    }
+
+    // no more threads than there are batches to give them
+    unsigned threads = num_threads ? num_threads : std::max(1u, std::thread::hardware_concurrency());
+    ThreadPool pool(std::min(threads, static_cast<unsigned>(std::max<size_t>(1, batches.size()))));
+    start = std::chrono::high_resolution_clock::now();
+    bool laid_out = layoutComponents(pool, batches, error);
+    timings.layout_millis = millisSince(start);
+    if (!laid_out)
+        return false;
+
+    start = std::chrono::high_resolution_clock::now();
+    pack();
+    moveComponents(pool, batches);
+    timings.pack_millis = millisSince(start);
+    return true;
+}
+
+// one breadth first walk per tree. component_nodes doubles as the queue, so each tree's nodes
+// end up next to each other and a node's offset from its tree's first is its id in the tree
+void ForestLayout::split()
+{
+    int n = forest_ref.getNumVertices();
+    components.clear();
+    component_nodes.resize(n);
+    local_parents.resize(n);
+    component_of.assign(n, -1);
+    int tail = 0;
+    for (int s = 0; s < n; ++s)
+    {
+        if (component_of[s] != -1)
+            continue;
+        int c = static_cast<int>(components.size());
+        int first = tail;
+        component_of[s] = c;
+        local_parents[tail] = -1;
+        component_nodes[tail++] = s;
+        for (int head = first; head < tail; ++head)
+        {
+            int u = component_nodes[head];
+            for (int v : forest_ref.getNeighbors(u))
+            {
+                if (component_of[v] != -1)
+                    continue;
+                component_of[v] = c;
+                local_parents[tail] = head - first;
+                component_nodes[tail++] = v;
+            }
+        }
+        components.push_back({first, tail - first, {0.0f, 0.0f}, 0.0f});
+    }
+}
+
+// every batch lays its trees out around the origin and leaves them there until their discs
+// are packed. the batches write disjoint nodes, so they need no locking. the first tree that
+// fails claims failed and writes the reason, the others only stop their batch
+bool ForestLayout::layoutComponents(ThreadPool &pool, const std::vector<std::vector<int>> &batches, std::string *error)
+{
+    positions.assign(forest_ref.getNumVertices(), {0.0f, 0.0f});
+    RadialLayoutOptions options;
+    options.delta = DELTA;
+    options.fast_trig = trig_mode == TrigMode::FAST;
+    std::atomic<int> failed(-1);
+    std::string reason;
+    for (const auto &batch : batches)
+    {
+        pool.submit([this, &batch, &options, &failed, &reason]()
+                    {
+            // one per pool thread, so the buffers carry over from batch to batch and the
+            // biggest tree a thread gets sizes them once
+            thread_local RadialLayoutWorkspace workspace;
+            thread_local std::vector<Point> xy;
+            for (int c : batch)
+            {
+                ForestComponent &component = components[c];
+                const int *nodes = &component_nodes[component.first];
+                double radius = 0.0;
+                // a lone node needs no layout, it just sits in the middle of its disc
+                if (component.size > 1)
+                {
+                    xy.resize(component.size);
+                    // the parents came out of the walk, so they should always make a tree
+                    std::string why;
+                    if (!workspace.layoutParents(component.size, &local_parents[component.first], options, &xy[0].x, &why))
+                    {
+                        int none = -1;
+                        if (failed.compare_exchange_strong(none, c))
+                            reason = why;
+                        return;
+                    }
+                    for (int i = 0; i < component.size; ++i)
+                    {
+                        positions[nodes[i]] = xy[i];
+                        radius = std::max(radius, std::hypot(static_cast<double>(xy[i].x), static_cast<double>(xy[i].y)));
+                    }
+                }
+                component.radius = static_cast<float>(radius + DELTA / 2.0);
+            } });
+    }
+    pool.wait();
+    if (failed < 0)
+        return true;
+    if (error)
+    {
+        const ForestComponent &component = components[failed];
+        *error = "tree " + std::to_string(failed) + " of the forest (" + std::to_string(component.size) + " nodes from node " +
+                 std::to_string(component_nodes[component.first]) + ") couldnt be laid out: " + reason;
+    }
+    return false;
+}
+
+// shelf packing: the discs go left to right in rows as wide as the viewport's shape asks for,
+// biggest first, so each row is as tall as its first disc and the ones after it are about as
+// big. sorting is the only part that isnt linear in the number of trees
+void ForestLayout::pack()
+{
+    std::vector<int> order(components.size());
+    for (size_t c = 0; c < order.size(); ++c)
+        order[c] = static_cast<int>(c);
+    std::sort(order.begin(), order.end(), [this](int a, int b)
+              { return components[a].radius > components[b].radius; });
+    if (order.empty())
+        return;
+
+    double area = 0.0;
+    for (const auto &component : components)
+        area += 4.0 * component.radius * component.radius;
+    double aspect = halfwidth > 0 && halfheight > 0 ? static_cast<double>(halfwidth) / halfheight : 1.0;
+    double row_width = std::max(2.0 * components[order[0]].radius, std::sqrt(area * aspect));
+
+    // rows first, with the discs' centers from the top left corner of the packing
+    std::vector<double> xs(components.size()), ys(components.size());
+    double x = 0.0, y = 0.0, row_height = 0.0, width = 0.0;
+    for (int c : order)
+    {
+        double diameter = 2.0 * components[c].radius;
+        if (x > 0.0 && x + diameter > row_width)
+        {
+            y += row_height;
+            x = 0.0;
+        }
+        if (x == 0.0)
+            row_height = diameter;
+        xs[c] = x + diameter / 2.0;
+        ys[c] = y + row_height / 2.0;
+        x += diameter;
+        width = std::max(width, x);
+    }
+    double height = y + row_height;
+
+    // then the packing is centered on the screen center, a single tree lands right on it
+    for (size_t c = 0; c < components.size(); ++c)
+    {
+        components[c].center = {static_cast<float>(halfwidth + (xs[c] - width / 2.0)), static_cast<float>(halfheight + (ys[c] - height / 2.0))};
+    }
+}
+
+void ForestLayout::moveComponents(ThreadPool &pool, const std::vector<std::vector<int>> &batches)
+{
+    for (const auto &batch : batches)
+    {
+        pool.submit([this, &batch]()
+                    {
+            for (int c : batch)
+            {
+                const ForestComponent &component = components[c];
+                const int *nodes = &component_nodes[component.first];
+                for (int i = 0; i < component.size; ++i)
+                {
+                    positions[nodes[i]].x += component.center.x;
+                    positions[nodes[i]].y += component.center.y;
+                }
+            } });
+    }
+    pool.wait();
+}
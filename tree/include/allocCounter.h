@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+
+// how much a thread has asked the heap for. allocCounter.cpp replaces the global operator
+// new and delete with ones that count here, so every container, string and shared_ptr in
+// the program shows up. plain malloc doesnt, so imgui and the gl driver arent in it
+struct AllocCounts
+{
+    uint64_t allocations;
+    uint64_t frees;
+    uint64_t bytes; // what was asked for, not what malloc rounded it up to
+};
+
+// running totals of the calling thread since it started. take one before and one after a
+// piece of code and subtract them. each thread only ever touches its own, so counting is
+// just an add and a worker allocating in the background never shows up in the ui's numbers
+AllocCounts threadAllocCounts();
+AllocCounts operator-(const AllocCounts &after, const AllocCounts &before);
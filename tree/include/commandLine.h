@@ -0,0 +1,12 @@
+#pragma once
+#include "tree.h"
+#include <functional>
+#include <string>
+
+// runs the non interactive modes (generating, benchmarking), none of them touch glfw or gl.
+// returns the process exit code, or -1 if the arguments ask for the gui
+int runCommandLine(int argc, char **argv);
+
+// the tree the viewer should open with, from "<tree file>" or "--view <family> <nodes> [seed] [param]".
+// false if the arguments dont name one, otherwise build makes it on whatever thread calls it
+bool startupTreeFromArgs(int argc, char **argv, std::function<Tree(std::string &error)> &build);
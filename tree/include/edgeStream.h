@@ -0,0 +1,111 @@
+#pragma once
+#include "spscQueue.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// a single change to the edge list
+struct EdgeDelta
+{
+    bool add;
+    int u, v;
+};
+
+// reads one "+u v", "-u v" or plain "u v" line, false if it isnt one
+bool parseEdgeDelta(const char *begin, const char *end, EdgeDelta &out);
+
+enum class StreamState
+{
+    WAITING,   // nobody is writing to the pipe or socket yet
+    CONNECTED,
+    CLOSED,    // stdin reached its end, nothing more will come
+    FAILED
+};
+
+// reads edge events from stdin, a named pipe or a unix socket on its own thread and hands
+// them to the ui through a lock free queue. when the queue is full the reader stops reading
+// until the ui catches up, so the writer gets slowed down instead of events getting lost.
+// pipes and sockets go back to waiting when the writer hangs up, the next one carries on
+class EdgeStream
+{
+public:
+    explicit EdgeStream(size_t capacity = 1 << 16);
+    ~EdgeStream();
+
+    // "-" is stdin, "unix:<path>" listens on a socket, anything else is a named pipe that
+    // gets created if it doesnt exist yet
+    bool start(const std::string &source, std::string *error = nullptr);
+    void stop();
+    // called on the reader thread whenever it queued something. set it before start
+    void setOnEvents(std::function<void()> callback);
+    // moves every queued event into out, only from the thread that owns the stream
+    size_t drain(std::vector<EdgeDelta> &out);
+    bool hasEvents() const;
+
+    StreamState getState() const;
+    const std::string &getSource() const;
+    uint64_t getNumReceived() const;
+    uint64_t getNumMalformed() const;
+
+private:
+    enum class Kind
+    {
+        STDIN,
+        FIFO,
+        SOCKET
+    };
+
+    void run();
+    void readFrom(int fd);
+    void flush(std::vector<EdgeDelta> &batch);
+
+    SpscQueue<EdgeDelta> queue;
+    std::thread thread;
+    std::atomic<bool> stopping;
+    std::atomic<StreamState> state;
+    std::atomic<uint64_t> received, malformed;
+    std::function<void()> on_events;
+
+    Kind kind;
+    std::string source, path;
+    int listen_fd;
+    bool created_path; // remove the pipe or socket again when done
+};
+
+// the edges a stream has built up so far, in the order they arrived so siblings keep their
+// order. a removed edge leaves a hole that gets squeezed out once there are enough of them.
+// the ui folds the events in and the layout worker copies the edges out, so both take a lock
+class LiveEdgeSet
+{
+public:
+    LiveEdgeSet();
+
+    // replays the events in order, returns false if none of them changed anything
+    bool apply(const std::vector<EdgeDelta> &deltas);
+    // like apply, but returns false straight away without applying anything while another
+    // thread is taking a snapshot, so the ui never waits for the copy. changed is set as apply
+    // would return it
+    bool tryApply(const std::vector<EdgeDelta> &deltas, bool &changed);
+    // copies the edges into out and returns the node count, one more than the largest id
+    int snapshot(std::vector<std::pair<int, int>> &out) const;
+    // doesnt wait for the lock, the panel asks every frame
+    size_t size() const;
+
+private:
+    static uint64_t key(int u, int v);
+    bool applyLocked(const std::vector<EdgeDelta> &deltas);
+    void compact();
+
+    mutable std::mutex mutex;
+    std::atomic<size_t> live_count;
+
+    std::vector<std::pair<int, int>> edges; // removed ones are {-1, -1}
+    std::unordered_map<uint64_t, size_t> index;
+    size_t num_removed;
+};
@@ -0,0 +1,17 @@
+#pragma once
+#include <cstddef>
+
+// polynomial sin, cos, acos and atan2 over whole arrays, four lanes at a time with sse2.
+// the coefficients are the single precision minimax fits from cephes. every element goes
+// through the same instructions wherever it sits in the array, so a value comes out the
+// same computed alone or in a batch, which the incremental collapse relies on.
+//
+// bounds are absolute errors against double precision libm, checked by --trig-check
+static const float FAST_SINCOS_MAX_ERROR = 1.5e-7f; // for |x| <= 1024
+static const float FAST_ACOS_MAX_ERROR = 5e-7f;     // over [-1, 1]
+static const float FAST_ATAN2_MAX_ERROR = 5e-7f;    // everywhere, atan2(0, 0) is 0
+static const float FAST_SINCOS_RANGE = 1024.0f;
+
+void fastSinCos(const float *angles, float *sines, float *cosines, size_t count);
+void fastAcos(const float *x, float *out, size_t count);
+void fastAtan2(const float *y, const float *x, float *out, size_t count);
@@ -0,0 +1,80 @@
+#pragma once
+#include "tree.h"
+#include "treeLayout.h"
+#include "point.h"
+#include "threadPool.h"
+#include <string>
+#include <vector>
+
+// one tree of the forest. its nodes are getComponentNodes()[first, first + size), in the order
+// a breadth first walk from its smallest node found them
+struct ForestComponent
+{
+    int first;
+    int size;
+    Point center; // where its layout center ended up
+    float radius; // of the disc it was packed as, half a delta past its outermost node
+};
+
+// how long each pass of the last calculate took
+struct ForestTimings
+{
+    double split_millis = 0.0;
+    double layout_millis = 0.0;
+    double pack_millis = 0.0; // the discs' places and moving the trees onto them
+};
+
+// lays out a forest, a Tree built with TreeBuilder::setAllowForest, one tree at a time:
+//  - the trees are split apart with one breadth first pass over the adjacency, which also
+//    leaves each one's parent array in its own numbering
+//  - each tree gets the radial layout around its true center from a RadialLayoutWorkspace,
+//    with the trees spread over a thread pool, biggest first and the small ones in batches
+//  - the discs around the trees are packed in shelves, biggest first, into a rectangle the
+//    shape of the viewport, centered on it like a TreeLayout
+// a forest of one tree lands centered like TreeLayout::calculateTrueCenterLayout puts it, though
+// its siblings can come out in another order since the walk numbers the nodes anew
+class ForestLayout
+{
+public:
+    ForestLayout(const Tree &forest, int halfwidth, int halfheight, float delta = 50.0f);
+
+    void setTrigMode(TrigMode mode);
+    TrigMode getTrigMode() const;
+    // 0 means one per hardware thread
+    void setNumThreads(unsigned num_threads);
+    unsigned getNumThreads() const;
+
+    // false if one of the trees couldnt be laid out, error gets which one and why. the split
+    // only makes trees, so that means a bug rather than bad input
+    bool calculate(std::string *error = nullptr);
+
+    const std::vector<Point> &getPositions() const;
+    const std::vector<ForestComponent> &getComponents() const;
+    const std::vector<int> &getComponentNodes() const;
+    // the index into getComponents of every node's tree
+    const std::vector<int> &getComponentOf() const;
+    const ForestTimings &getTimings() const;
+
+    // same formats as TreeLayout::writePositions
+    bool writePositions(const std::string &filename, bool csv, std::string *error = nullptr) const;
+
+private:
+    void split();
+    bool layoutComponents(ThreadPool &pool, const std::vector<std::vector<int>> &batches, std::string *error);
+    void pack();
+    void moveComponents(ThreadPool &pool, const std::vector<std::vector<int>> &batches);
+
+    const Tree &forest_ref;
+    float DELTA;
+    int halfwidth, halfheight;
+    TrigMode trig_mode;
+    unsigned num_threads;
+
+    std::vector<ForestComponent> components;
+    std::vector<int> component_nodes;
+    std::vector<int> component_of;
+    // the parent of component_nodes[i] as an offset into its own tree, -1 for the tree's root
+    std::vector<int> local_parents;
+    std::vector<Point> positions;
+    ForestTimings timings;
+};
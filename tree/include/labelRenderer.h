@@ -0,0 +1,49 @@
+#pragma once
+#include "tree.h"
+#include "treeLayout.h"
+#include "graphics.h"
+#include "viewTransform.h"
+#include <vector>
+
+// text from a small bitmap font baked into one texture the first time it is needed. all the
+// text queued during a frame goes into one vertex array and out in a single draw call, so
+// labelling a hundred thousand nodes costs the same number of gl calls as one tooltip
+class LabelRenderer
+{
+public:
+    LabelRenderer();
+    ~LabelRenderer();
+
+    // queues text whose first line sits on x, y (its bottom left corner), '\n' starts the next
+    // line further down. only printable ascii has glyphs, anything else is left blank
+    void addText(float x, float y, const char *text);
+    // queues the ids of the nodes next to where the view puts them on screen. a label that
+    // would run off the screen box x0..x1, y0..y1 or into one already queued is skipped, and
+    // shallow nodes get their turn first, so only the inner rings get labels on a crowded
+    // screen and every node does once there is room. draw these with no transform set
+    void addNodeLabels(const std::vector<Point> &positions, NeighborRange nodes, const DepthArray &depths,
+                       const ViewTransform &view, float x0, float y0, float x1, float y1);
+    // draws everything queued in one color with one call and empties the queue
+    void flush(float r, float g, float b);
+    // node labels that made it through the last addNodeLabels
+    int getNumNodeLabels() const;
+
+private:
+    struct Vertex
+    {
+        float x, y, u, v;
+    };
+
+    void bakeAtlas();
+    void addGlyph(float x, float y, char c);
+
+    GLuint texture;
+    // kept between frames, they only ever grow so a steady frame doesnt allocate
+    std::vector<Vertex> vertices;
+    std::vector<int> candidates, by_depth, depth_starts;
+    std::vector<Point> corners; // bottom left of each candidate's label on screen
+    // the frame each cell of the screen grid was last taken in, so it never needs clearing
+    std::vector<unsigned> taken;
+    unsigned stamp;
+    int num_node_labels;
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include "tree.h"
+#include "treeLayout.h"
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+// keeps the most recently used layouts of the current tree, keyed by their root, so
+// clicking back to a recent root or resetting to the center needs no layout work at all.
+// layouts never change once the worker hands them over, so entries are shared, not copied
+class LayoutCache
+{
+public:
+    static const int TRUE_CENTER = -1;
+
+    explicit LayoutCache(size_t budget_bytes);
+
+    // drops everything if the tree, spacing, trig mode, subtree sharing, compactness, layout
+    // style, precision or screen center differ from what the entries were built for. the tree
+    // is told apart by its id, a new tree can sit where a freed one was
+    void setContext(unsigned long long tree_id, float delta, TrigMode trig_mode, bool share_subtrees, bool compact, LayoutStyle style, bool double_precision,
+                    int halfwidth, int halfheight);
+
+    // returns null on a miss, a hit becomes the most recently used entry
+    std::shared_ptr<TreeLayout> find(int root);
+    void insert(int root, std::shared_ptr<TreeLayout> layout);
+    void clear();
+
+    void setBudget(size_t budget_bytes);
+    size_t getBudget() const;
+    size_t getUsage() const;
+    size_t getNumEntries() const;
+
+private:
+    struct Entry
+    {
+        int root;
+        std::shared_ptr<TreeLayout> layout;
+        size_t bytes;
+    };
+
+    void evict();
+
+    std::list<Entry> entries; // most recently used first
+    std::unordered_map<int, std::list<Entry>::iterator> index;
+    size_t budget, usage;
+
+    unsigned long long tree_id;
+    float delta;
+    TrigMode trig_mode;
+    bool share_subtrees;
+    bool compact;
+    LayoutStyle style;
+    bool double_precision;
+    int halfwidth, halfheight;
+};
@@ -0,0 +1,481 @@
+#pragma once
+#include "treeLayout.h"
+#include "point.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// everything an engine settles once per layout instead of once per node: the number type its
+// math runs in, whether it starts from one center node or two neighboring ones, and what it
+// keeps for the blueprint. the positions come out as floats either way
+template <typename RealT, int Centers, FrameworkRecording Record>
+struct LayoutPolicy
+{
+    static_assert(Centers == 1 || Centers == 2, "a tree has one center or two neighboring ones");
+    using Real = RealT;
+    static constexpr int centers = Centers;
+    static constexpr bool circles = Record != FrameworkRecording::NONE;
+    static constexpr bool all = Record == FrameworkRecording::ALL;
+};
+
+// the rooted tree every engine starts from, straight out of TreeLayout's width pass. the
+// visible nodes are in pre-order, so every subtree is the range [i, i + size) and a node's
+// children follow it one subtree after the other. with two centers the second one's range
+// starts right after the first one's
+struct LayoutTraversal
+{
+    const int *nodes;     // pre-order
+    const int *sizes;     // subtree sizes, by node
+    const int *widths;    // visible leaves below each node, by node
+    size_t count;
+    size_t second_center; // pre-order index of the second center, count if there is only one
+    float delta;
+};
+
+// where an engine writes. positions are by node and around the origin, each part of the
+// blueprint is only touched by the engines that draw one and when the policy keeps it
+struct EngineOutput
+{
+    Point *positions;
+    std::vector<float> *circles;       // radial, the rings about the center, unsorted
+    std::vector<Wedge> *wedges;        // radial, every child's share of its parent's wedge
+    std::vector<FrameworkRing> *rings; // balloon, the circle each node's children sit on
+};
+
+// calls f with the pre-order index of every child of the node at index i, in neighbor order
+template <typename F>
+inline void forEachChild(const LayoutTraversal &t, size_t i, F f)
+{
+    size_t end = i + t.sizes[t.nodes[i]];
+    for (size_t c = i + 1; c < end; c += t.sizes[t.nodes[c]])
+        f(c);
+}
+
+// Eades' radial layout with the same math as TreeLayout's own pass: every child sits delta
+// from its parent in the middle of its share of the parent's wedge, and a wedge is no wider
+// than the tangents to the ring delta further out. TreeLayout keeps that float pass for fast
+// trig, shared subtrees and placing in steps, this one is what runs it in double
+template <class Policy>
+struct RadialEngine
+{
+    using Real = typename Policy::Real;
+
+    static void run(const LayoutTraversal &t, const EngineOutput &out)
+    {
+        size_t n = t.count;
+        if (n == 0)
+            return;
+        const Real pi = static_cast<Real>(M_PI);
+        const Real delta = t.delta;
+        std::vector<Real> xs(n), ys(n), starts(n), spans(n);
+
+        // where the node at i goes off its parent, then the part of the wedge its children split
+        auto place = [&](size_t i, Real parent_x, Real parent_y, Real alpha1, Real alpha2)
+        {
+            Real middle = (alpha1 + alpha2) / 2;
+            xs[i] = parent_x + delta * std::cos(middle);
+            ys[i] = parent_y + delta * std::sin(middle);
+            Real radius = std::sqrt(xs[i] * xs[i] + ys[i] * ys[i]);
+            Real cosine = radius + delta > 0 ? std::min<Real>(1, radius / (radius + delta)) : 1;
+            Real tau = 2 * std::acos(cosine);
+            Real total = std::abs(alpha2 - alpha1);
+            // only a node on the center may keep a whole circle, see TreeLayout::computeSpans
+            bool capped = total < 2 * pi || cosine > 0;
+            Real span = (capped && tau < total) ? tau : total;
+            starts[i] = std::atan2(ys[i], xs[i]) - span / 2;
+            spans[i] = span;
+        };
+
+        if (Policy::centers == 1)
+        {
+            xs[0] = ys[0] = 0;
+            starts[0] = -pi;
+            spans[0] = 2 * pi;
+        }
+        else
+        {
+            // the first center goes off the second one's spot, then the second off the first
+            place(0, delta / 2, 0, 3 * pi / 2, pi / 2);
+            place(t.second_center, xs[0], ys[0], pi / 2, -pi / 2);
+        }
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            int u = t.nodes[i];
+            Real x = xs[i], y = ys[i];
+            out.positions[u] = {static_cast<float>(x), static_cast<float>(y)};
+            Real ring = std::sqrt(x * x + y * y) + delta;
+            if (Policy::circles)
+                out.circles->push_back(static_cast<float>(ring));
+            // the shares come from the summed widths, like TreeLayout::shareStart
+            double total = t.widths[u], before = 0.0;
+            forEachChild(t, i, [&](size_t c)
+                         {
+                             Real alpha1 = starts[i] + static_cast<Real>(before / total) * spans[i];
+                             before += t.widths[t.nodes[c]];
+                             Real alpha2 = starts[i] + static_cast<Real>(before / total) * spans[i];
+                             if (Policy::all)
+                                 out.wedges->push_back({{static_cast<float>(x), static_cast<float>(y)}, static_cast<float>(ring),
+                                                        static_cast<float>(alpha1), static_cast<float>(alpha2)});
+                             place(c, x, y, alpha1, alpha2); });
+        }
+    }
+};
+
+// the tidy tree of Reingold and Tilford, with Walker's spreading of the small subtrees between
+// two big ones, in the linear time form of Buchheim, Juenger and Leipert. the center is on the
+// origin, every depth is one delta further down and neighbors on a row are at least delta
+// apart. two centers sit next to each other on the top row, under a root that isnt drawn
+template <class Policy>
+struct TidyEngine
+{
+    using Real = typename Policy::Real;
+
+    static void run(const LayoutTraversal &t, const EngineOutput &out)
+    {
+        size_t n = t.count;
+        if (n == 0)
+            return;
+        const int NONE = -1;
+        const Real distance = t.delta;
+        // the nodes go by pre-order index, the root above two centers is index n
+        size_t m = Policy::centers == 2 ? n + 1 : n;
+        int top = Policy::centers == 2 ? static_cast<int>(n) : 0;
+        std::vector<int> parent(m, NONE), first(m, NONE), last(m, NONE), left(m, NONE), right(m, NONE), number(m, 0);
+        std::vector<int> thread(m, NONE), ancestor(m);
+        std::vector<Real> prelim(m, 0), mod(m, 0), shift(m, 0), change(m, 0), middle(m, 0);
+        auto link = [&](int p, int c)
+        {
+            parent[c] = p;
+            if (last[p] == NONE)
+            {
+                first[p] = c;
+            }
+            else
+            {
+                left[c] = last[p];
+                right[last[p]] = c;
+                number[c] = number[last[p]] + 1;
+            }
+            last[p] = c;
+        };
+        for (size_t i = 0; i < n; ++i)
+            forEachChild(t, i, [&](size_t c)
+                         { link(static_cast<int>(i), static_cast<int>(c)); });
+        if (Policy::centers == 2)
+        {
+            link(top, 0);
+            link(top, static_cast<int>(t.second_center));
+        }
+        for (size_t i = 0; i < m; ++i)
+            ancestor[i] = static_cast<int>(i);
+
+        // the contours are followed down the outermost children, or the thread where a
+        // subtree ends before its neighbor does
+        auto nextLeft = [&](int v)
+        { return first[v] != NONE ? first[v] : thread[v]; };
+        auto nextRight = [&](int v)
+        { return last[v] != NONE ? last[v] : thread[v]; };
+        // pushes wp's subtree right, the siblings between wm and wp get their part of it later
+        auto moveSubtree = [&](int wm, int wp, Real amount)
+        {
+            Real subtrees = static_cast<Real>(number[wp] - number[wm]);
+            change[wp] -= amount / subtrees;
+            shift[wp] += amount;
+            change[wm] += amount / subtrees;
+            prelim[wp] += amount;
+            mod[wp] += amount;
+        };
+        // moves v's subtree clear of everything left of it, level by level down both contours
+        auto apportion = [&](int v, int default_ancestor)
+        {
+            int w = left[v];
+            if (w == NONE)
+                return default_ancestor;
+            int inner_right = v, outer_right = v, inner_left = w, outer_left = first[parent[v]];
+            Real sum_inner_right = mod[inner_right], sum_outer_right = mod[outer_right];
+            Real sum_inner_left = mod[inner_left], sum_outer_left = mod[outer_left];
+            while (nextRight(inner_left) != NONE && nextLeft(inner_right) != NONE)
+            {
+                inner_left = nextRight(inner_left);
+                inner_right = nextLeft(inner_right);
+                outer_left = nextLeft(outer_left);
+                outer_right = nextRight(outer_right);
+                ancestor[outer_right] = v;
+                Real gap = (prelim[inner_left] + sum_inner_left) - (prelim[inner_right] + sum_inner_right) + distance;
+                if (gap > 0)
+                {
+                    int a = parent[ancestor[inner_left]] == parent[v] ? ancestor[inner_left] : default_ancestor;
+                    moveSubtree(a, v, gap);
+                    sum_inner_right += gap;
+                    sum_outer_right += gap;
+                }
+                sum_inner_left += mod[inner_left];
+                sum_inner_right += mod[inner_right];
+                sum_outer_left += mod[outer_left];
+                sum_outer_right += mod[outer_right];
+            }
+            if (nextRight(inner_left) != NONE && nextRight(outer_right) == NONE)
+            {
+                thread[outer_right] = nextRight(inner_left);
+                mod[outer_right] += sum_inner_left - sum_outer_right;
+            }
+            if (nextLeft(inner_right) != NONE && nextLeft(outer_left) == NONE)
+            {
+                thread[outer_left] = nextLeft(inner_right);
+                mod[outer_left] += sum_inner_right - sum_outer_left;
+                default_ancestor = v;
+            }
+            return default_ancestor;
+        };
+        // a node's own subtree only depends on what is below it, so the children are lined up
+        // here and the node only learns where it sits among its siblings from its parent
+        auto firstWalk = [&](int v)
+        {
+            if (first[v] == NONE)
+                return;
+            int default_ancestor = first[v];
+            for (int w = first[v]; w != NONE; w = right[w])
+            {
+                if (left[w] == NONE)
+                {
+                    prelim[w] = middle[w];
+                }
+                else
+                {
+                    prelim[w] = prelim[left[w]] + distance;
+                    if (first[w] != NONE)
+                        mod[w] = prelim[w] - middle[w];
+                }
+                default_ancestor = apportion(w, default_ancestor);
+            }
+            Real total_shift = 0, total_change = 0;
+            for (int w = last[v]; w != NONE; w = left[w])
+            {
+                prelim[w] += total_shift;
+                mod[w] += total_shift;
+                total_change += change[w];
+                total_shift += shift[w] + total_change;
+            }
+            middle[v] = (prelim[first[v]] + prelim[last[v]]) / 2;
+        };
+        // reverse pre-order finishes every subtree before its parent
+        for (size_t i = n; i-- > 0;)
+            firstWalk(static_cast<int>(i));
+        if (Policy::centers == 2)
+            firstWalk(top);
+        prelim[top] = middle[top];
+
+        // the mods add up from the top, shift is free again and holds the sum of the ancestors'
+        std::vector<int> depth(m, 0);
+        std::vector<Real> &above = shift;
+        std::fill(above.begin(), above.end(), Real(0));
+        auto secondWalk = [&](int v)
+        {
+            for (int w = first[v]; w != NONE; w = right[w])
+            {
+                above[w] = above[v] + mod[v];
+                depth[w] = depth[v] + 1;
+            }
+        };
+        if (Policy::centers == 2)
+        {
+            secondWalk(top);
+            depth[0] = depth[t.second_center] = 0;
+        }
+        Real origin = prelim[top];
+        for (size_t i = 0; i < n; ++i)
+        {
+            secondWalk(static_cast<int>(i));
+            Real x = prelim[i] + above[i] - origin;
+            out.positions[t.nodes[i]] = {static_cast<float>(x), static_cast<float>(-depth[i] * distance)};
+        }
+    }
+};
+
+// the balloon layout: every subtree is drawn inside a disc, and a node's children sit on a
+// circle around it with their discs side by side, each inside its own angle. the edge to the
+// parent gets a gap of its own among the children, so nothing can cross it. a subtree's disc
+// isnt centered on its root but further out on the line from the parent, a disc around the
+// root would at least double at every node of a long path. finding the circle takes a
+// bisection at nodes with many children, so it is linear with a bigger constant than the others
+template <class Policy>
+struct BalloonEngine
+{
+    using Real = typename Policy::Real;
+
+    static void run(const LayoutTraversal &t, const EngineOutput &out)
+    {
+        size_t n = t.count;
+        if (n == 0)
+            return;
+        const Real pi = static_cast<Real>(M_PI);
+        const Real delta = t.delta;
+        // a leaf's disc, so two leaves are at least delta apart. the gap to the parent is as wide
+        const Real half = delta / 2;
+        // per node: its disc and how far out along the line from the parent the disc's center
+        // is, the circle its children sit on, and its angle off the parent's line
+        std::vector<Real> discs(n, half), offsets(n, 0), rings(n, 0), angles(n, 0);
+        auto hasParent = [&](size_t i)
+        { return Policy::centers == 2 || i != 0; };
+
+        // the angle a disc takes up seen from a circle this far out, the node's own disc
+        // is on that circle's far side of the node by its offset
+        auto angleFor = [&](size_t c, Real ring)
+        { return 2 * std::asin(std::min<Real>(1, discs[c] / (ring + offsets[c]))); };
+        auto gapFor = [&](size_t i, Real ring)
+        { return hasParent(i) ? 2 * std::asin(std::min<Real>(1, half / ring)) : Real(0); };
+
+        // the discs from the leaves up. a node looks away from its parent along angle 0
+        for (size_t i = n; i-- > 0;)
+        {
+            // a leaf keeps the disc it started with
+            if (t.sizes[t.nodes[i]] == 1)
+                continue;
+            // the widest child is meant to face straight away from the parent, so a long path
+            // runs straight instead of curling up and its disc grows by a step, not a factor
+            Real ring = delta, widest = 0;
+            size_t widest_child = 0;
+            forEachChild(t, i, [&](size_t c)
+                         {
+                             ring = std::max(ring, discs[c] - offsets[c] + half);
+                             if (discs[c] > widest)
+                             {
+                                 widest = discs[c];
+                                 widest_child = c;
+                             } });
+            // the angles of the children before and after the widest one in neighbor order. a
+            // hundred thousand of them only add up right in double, like TreeLayout::shareStart
+            double in_front = 0, behind = 0;
+            auto sides = [&](Real r)
+            {
+                in_front = behind = 0;
+                forEachChild(t, i, [&](size_t c)
+                             {
+                                 if (c < widest_child)
+                                     in_front += angleFor(c, r);
+                                 else if (c > widest_child)
+                                     behind += angleFor(c, r); });
+            };
+            // the smallest circle where every disc is clear of the node, all the angles and the
+            // gap make no more than a turn, and each side of the widest child fits in half a
+            // turn. all of those only get easier further out
+            auto fits = [&](Real r)
+            {
+                sides(r);
+                Real gap = gapFor(i, r), middle = angleFor(widest_child, r);
+                if (gap + in_front + middle + behind > 2 * M_PI)
+                    return false;
+                return !hasParent(i) || (gap / 2 + in_front + middle / 2 <= M_PI && gap / 2 + behind + middle / 2 <= M_PI);
+            };
+            if (!fits(ring))
+            {
+                Real low = ring, high = 2 * ring;
+                while (!fits(high))
+                {
+                    low = high;
+                    high *= 2;
+                }
+                for (int step = 0; step < 24; ++step)
+                {
+                    Real middle = (low + high) / 2;
+                    if (fits(middle))
+                        high = middle;
+                    else
+                        low = middle;
+                }
+                ring = high;
+            }
+            rings[i] = ring;
+
+            // the children go round in order from just past the gap to the parent. the angle
+            // left over goes in front of the widest child until it faces away from the parent,
+            // the rest after it. without a parent it is spread evenly
+            sides(ring);
+            size_t before = 0, after = 0, count = 0;
+            forEachChild(t, i, [&](size_t c)
+                         {
+                             before += c < widest_child;
+                             after += c > widest_child;
+                             count++; });
+            Real gap = gapFor(i, ring), middle = angleFor(widest_child, ring);
+            double spare = std::max(0.0, 2 * M_PI - gap - in_front - middle - behind);
+            double extra_before, extra_after, extra_widest = 0, angle;
+            if (hasParent(i))
+            {
+                double lead = std::min(spare, std::max(0.0, M_PI - gap / 2 - in_front - middle / 2));
+                extra_before = before > 0 ? lead / before : 0;
+                extra_after = after > 0 ? (spare - lead) / after : 0;
+                angle = pi + gap / 2 + (before == 0 ? lead : 0);
+            }
+            else
+            {
+                extra_before = extra_after = extra_widest = spare / count;
+                angle = 0;
+            }
+            forEachChild(t, i, [&](size_t c)
+                         {
+                             double share = angleFor(c, ring) + (c < widest_child ? extra_before : c > widest_child ? extra_after : extra_widest);
+                             // kept near 0, far out angles would lose their float precision
+                             angles[c] = static_cast<Real>(std::remainder(angle + share / 2, 2 * M_PI));
+                             angle += share; });
+
+            // the node's own disc sits on the line away from the parent, halfway between the
+            // nearest and furthest points of its children's discs along it
+            Real low = -half, high = half;
+            forEachChild(t, i, [&](size_t c)
+                         {
+                             Real along = (ring + offsets[c]) * std::cos(angles[c]);
+                             low = std::min(low, along - discs[c]);
+                             high = std::max(high, along + discs[c]); });
+            Real offset = (low + high) / 2, disc = std::abs(offset) + half;
+            forEachChild(t, i, [&](size_t c)
+                         {
+                             Real x = (ring + offsets[c]) * std::cos(angles[c]) - offset;
+                             Real y = (ring + offsets[c]) * std::sin(angles[c]);
+                             disc = std::max(disc, std::sqrt(x * x + y * y) + discs[c]); });
+            offsets[i] = offset;
+            discs[i] = disc;
+        }
+
+        // then the positions from the center out, with the direction each node looks away in
+        std::vector<Real> xs(n), ys(n), away(n, 0);
+        if (Policy::centers == 1)
+        {
+            xs[0] = ys[0] = 0;
+        }
+        else
+        {
+            // two centers look away from each other, each disc on its own side of the origin
+            size_t s = t.second_center;
+            Real apart = std::max({half, discs[0] - offsets[0], discs[s] - offsets[s]});
+            xs[0] = -apart;
+            xs[s] = apart;
+            ys[0] = ys[s] = 0;
+            away[0] = pi;
+            away[s] = 0;
+        }
+        for (size_t i = 0; i < n; ++i)
+        {
+            Real x = xs[i], y = ys[i];
+            out.positions[t.nodes[i]] = {static_cast<float>(x), static_cast<float>(y)};
+            if (rings[i] == 0)
+                continue;
+            if (Policy::all)
+                out.rings->push_back({{static_cast<float>(x), static_cast<float>(y)}, static_cast<float>(rings[i])});
+            forEachChild(t, i, [&](size_t c)
+                         {
+                             Real direction = std::remainder(away[i] + angles[c], 2 * pi);
+                             xs[c] = x + rings[i] * std::cos(direction);
+                             ys[c] = y + rings[i] * std::sin(direction);
+                             away[c] = direction; });
+        }
+    }
+};
+
+// runs the engine for style with the policy that fits: float or double, one or two centers
+// going by the traversal, and the recording asked for
+void runLayoutEngine(LayoutStyle style, bool double_precision, FrameworkRecording record, const LayoutTraversal &traversal, const EngineOutput &output);
+// "radial", "tidy" or "balloon"
+const char *layoutStyleName(LayoutStyle style);
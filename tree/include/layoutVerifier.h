@@ -0,0 +1,56 @@
+#pragma once
+#include "tree.h"
+#include "treeLayout.h"
+#include "point.h"
+#include <string>
+#include <vector>
+
+// what a check of a layout found. every count is of nodes or edges that broke the rule
+struct LayoutCheck
+{
+    int nodes_checked = 0;
+    int structure_errors = 0; // positions that are missing or not finite, parents the layout got wrong
+    int width_errors = 0;     // widths that arent the leaves below the node
+    int ring_errors = 0;      // edges that arent delta long or dont lead out to the parent's ring
+    int wedge_errors = 0;     // children outside their share of the parent's wedge
+    // the sweep stops at the first pair of crossing edges, these are their lower ends
+    bool crossing = false;
+    int crossing_a = -1, crossing_b = -1;
+    double max_ring_error = 0.0;  // pixels off the ring or the edge length
+    double max_wedge_error = 0.0; // radians outside the share
+    // the first few problems, readable
+    std::vector<std::string> problems;
+
+    bool ok() const;
+    // one line with the counts, or "ok"
+    std::string summary() const;
+};
+
+// checks the invariants of the radial layout (Eades' wedges, with the edges one delta long):
+//  - every visible node's width is the number of visible leaves below it, 1 for a leaf
+//  - a child is delta away from its parent and between the parent's radius and its ring,
+//    the circle delta further out that the blueprint draws
+//  - a child lies inside its own share of the parent's wedge. the wedge is centered on the
+//    parent's direction from the layout center and no wider than the tangents to the ring,
+//    and the children split it by width in neighbor order. the center's wedge has no
+//    direction, so it is only checked that its children line up in it the same way.
+//    collapsing or expanding a node in place leaves its ancestors' shares as they were, so
+//    for such a layout pass exact_shares = false, which only keeps each child inside the
+//    tangents of its parent's ring and after the sibling before it
+//  - a subtree the layout copied from an identical one instead keeps its edges delta long and
+//    every node inside the cone its root's span makes from the center, see TreeLayout::copySubtree
+//  - no two edges cross, found with a Shamos-Hoey sweep in O(n log n)
+// small float errors are allowed for, growing with the distance from the center.
+// the tidy and balloon layouts have none of the ring and wedge rules, only the rest is checked
+class LayoutVerifier
+{
+public:
+    // a finished TreeLayout, collapsed nodes and its own widths and parents included
+    static LayoutCheck check(const Tree &tree, const TreeLayout &layout, bool exact_shares = true);
+    // positions from any engine, indexed by node. the layout center is the middle of the
+    // center nodes, one node or two neighbors, and nothing is collapsed
+    static LayoutCheck checkPositions(const Tree &tree, const std::vector<Point> &positions, const std::vector<int> &center_nodes, float delta,
+                                      bool exact_shares = true);
+    // positions from any engine with any layout style, only checked for edges that cross
+    static LayoutCheck checkPlanar(const Tree &tree, const std::vector<Point> &positions, const std::vector<int> &center_nodes);
+};
@@ -0,0 +1,104 @@
+#pragma once
+#include "tree.h"
+#include "treeLayout.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// what the gui asked for, so it knows how to animate the result in
+enum class LayoutJobKind
+{
+    NEW_TREE,
+    RE_ROOT,
+    RESET,
+    SPACING,
+    COLLAPSE,
+    STREAM // a new tree from the live edge stream, node ids carry over from the last one
+};
+
+struct LayoutJob
+{
+    LayoutJobKind kind;
+    std::shared_ptr<Tree> tree; // the tree to lay out, or null if build is set
+    // builds a brand new tree on the worker thread, leaves a reason in error if it cant
+    std::function<Tree(std::string &error)> build;
+    int root;                     // -1 means use the true center
+    // only find the centers and widths here and place the centers, the ui places the rest of
+    // the rings a few per frame with TreeLayout::stepProgressiveLayout
+    bool progressive = false;
+    float delta;
+    TrigMode trig_mode = TrigMode::PRECISE;
+    bool share_subtrees = false;
+    bool compact = false;
+    LayoutStyle style = LayoutStyle::RADIAL;
+    bool double_precision = false;
+    int halfwidth, halfheight;
+    std::vector<char> collapsed;  // nodes whose subtrees stay hidden, empty means none
+    // for COLLAPSE, the layout to copy and the node to collapse or expand in it
+    std::shared_ptr<const TreeLayout> base;
+    int node = -1;
+};
+
+struct LayoutResult
+{
+    LayoutJobKind kind;
+    int root;
+    int node; // the node that was collapsed or expanded, -1 for other jobs
+    std::shared_ptr<Tree> tree;
+    std::shared_ptr<TreeLayout> layout;
+    double millis;
+    std::string error; // set instead of tree and layout when the new tree was rejected
+};
+
+// runs tree construction and layout on a background thread so the ui never blocks.
+// the finished layout is handed over by atomically swapping a shared pointer, while
+// the render loop keeps drawing the old one
+class LayoutWorker
+{
+public:
+    LayoutWorker();
+    ~LayoutWorker();
+
+    // queues a job, cancelling whatever the worker is busy with. a job for the current tree
+    // is turned down while a new tree is still on its way, it would only throw that away, and
+    // false comes back
+    bool submit(LayoutJob job);
+    // drops the queued job and cancels the running one, nothing older gets published after this.
+    // a new tree on its way is left alone
+    void cancelPending();
+    // a NEW_TREE or STREAM job is queued, running or finished but not taken yet
+    bool isLoadingTree() const;
+    // returns the newest finished layout once, or null if nothing new is ready
+    std::shared_ptr<LayoutResult> takeResult();
+    // true if takeResult would return something, without taking it
+    bool hasResult() const;
+    // called on the worker thread whenever it runs out of work, published or not, so a
+    // sleeping render loop can be woken up. set it before submitting anything
+    void setOnPublish(std::function<void()> callback);
+
+    bool isBusy() const;
+    float getProgress() const;
+
+private:
+    void run();
+    bool loadingTree() const; // with the mutex held
+    std::shared_ptr<LayoutResult> execute(LayoutJob &job, LayoutProgress &progress);
+
+    std::thread thread;
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    std::unique_ptr<LayoutJob> pending;
+    std::shared_ptr<LayoutProgress> active_progress;
+    LayoutJobKind active_kind;
+    bool stopping;
+    unsigned pending_id;
+
+    std::atomic<unsigned> latest_job;
+    std::atomic<bool> busy;
+    std::atomic<int> total_work;
+    std::function<void()> on_publish;
+    std::shared_ptr<LayoutResult> published; // only touched through std::atomic_* calls
+};
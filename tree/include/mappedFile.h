@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// a fixed size file mapped into memory, so arrays bigger than ram get paged in and out
+// by the os instead of failing to allocate
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // creates or truncates the file and reserves its disk space up front, so running out
+    // shows up here and not as a crash halfway through. a temporary file is unlinked right
+    // away and only lives as long as the mapping
+    bool create(const std::string &filename, size_t bytes, bool temporary, std::string *error = nullptr);
+    void close();
+
+    // hints for how the mapping is about to be walked, so the os can read ahead or not
+    void adviseSequential();
+    void adviseRandom();
+
+    void *data() const;
+    size_t size() const;
+
+private:
+    int fd;
+    void *address;
+    size_t bytes;
+};
+
+// a plain array of T on top of a MappedFile
+template <typename T>
+class MappedArray
+{
+public:
+    MappedArray() : length(0) {}
+
+    bool create(const std::string &filename, size_t count, bool temporary, std::string *error = nullptr)
+    {
+        length = 0;
+        if (!file.create(filename, count * sizeof(T), temporary, error))
+            return false;
+        length = count;
+        return true;
+    }
+    void close()
+    {
+        file.close();
+        length = 0;
+    }
+
+    void adviseSequential() { file.adviseSequential(); }
+    void adviseRandom() { file.adviseRandom(); }
+
+    T *data() { return static_cast<T *>(file.data()); }
+    const T *data() const { return static_cast<const T *>(file.data()); }
+    T &operator[](size_t i) { return data()[i]; }
+    const T &operator[](size_t i) const { return data()[i]; }
+    size_t size() const { return length; }
+    size_t bytes() const { return length * sizeof(T); }
+
+private:
+    MappedFile file;
+    size_t length;
+};
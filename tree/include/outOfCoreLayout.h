@@ -0,0 +1,58 @@
+#pragma once
+#include "mappedFile.h"
+#include "treeLayout.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// lays out a tree straight from its text file without ever holding it in memory. every per
+// node array lives in a memory mapped scratch file, and the nodes get renumbered breadth first
+// from the center so each child list becomes a contiguous range. that renumbering is the only
+// pass that jumps around, the width and placement passes after it sweep the arrays in order.
+// the positions come out the same as calculateTrueCenterLayout, around the origin
+class OutOfCoreLayout
+{
+public:
+    explicit OutOfCoreLayout(float delta = 50.0f);
+
+    // scratch files go next to the output unless a directory is set
+    void setScratchDirectory(const std::string &directory);
+    void setTrigMode(TrigMode mode);
+    // writes the binary format of TreeLayout::writePositions, indexed by the original node ids
+    bool run(const std::string &tree_file, const std::string &out_file, std::string *error = nullptr);
+
+    uint32_t getNumVertices() const;
+    const std::vector<uint32_t> &getCenterNodes() const;
+    // most bytes of scratch files mapped at once
+    uint64_t getPeakScratchBytes() const;
+
+private:
+    bool readAdjacency(const std::string &tree_file, std::string &error);
+    bool findCenter(std::string &error);
+    bool renumberBreadthFirst(std::string &error);
+    bool computeWidths(std::string &error);
+    bool place(Point *out, std::string &error);
+
+    template <typename T>
+    bool openScratch(MappedArray<T> &array, const char *name, size_t count, std::string &error);
+    template <typename T>
+    void closeScratch(MappedArray<T> &array);
+
+    float DELTA;
+    TrigMode trig_mode;
+    std::string scratch_dir, scratch_prefix;
+    uint32_t num_vertices;
+    std::vector<uint32_t> center_nodes;
+    uint64_t scratch_bytes, peak_scratch_bytes;
+
+    // original ids, only until the renumbering is done
+    MappedArray<uint32_t> degree;
+    MappedArray<uint64_t> offsets;
+    MappedArray<uint32_t> adjacency;
+    // breadth first ids from here on. order maps them back to the original ids, and the
+    // children of i are first_child[i] .. first_child[i + 1]
+    MappedArray<uint32_t> order, first_child, widths;
+    MappedArray<Point> positions;
+    // where each node's children start splitting its wedge and how much of it they get
+    MappedArray<float> child_starts, child_spans;
+};
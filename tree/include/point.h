@@ -0,0 +1,7 @@
+#pragma once
+
+// a spot on the layout plane, in pixels
+struct Point
+{
+    float x, y;
+};
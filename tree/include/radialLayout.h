@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// the radial layout for programs that embed it, with no gl or windowing behind it. the tree
+// goes in as plain arrays and the positions come out in the caller's own buffer, two floats
+// per node, x then y, around the origin. nothing handed back points into the workspace.
+// radialLayoutC.h has the same for c
+struct RadialLayoutOptions
+{
+    float delta = 50.0f;    // distance between the rings
+    int root = -1;          // node to put in the middle, -1 for the tree's true center
+    bool fast_trig = false; // polynomial trig instead of libm, see fastTrig.h
+};
+
+// keeps the tree, the layout and their scratch buffers from one call to the next. once it
+// has seen a couple of trees, laying out one no bigger than those doesnt allocate at all.
+// a workspace isnt thread safe, give every thread its own
+class RadialLayoutWorkspace
+{
+public:
+    RadialLayoutWorkspace();
+    ~RadialLayoutWorkspace();
+    RadialLayoutWorkspace(const RadialLayoutWorkspace &) = delete;
+    RadialLayoutWorkspace &operator=(const RadialLayoutWorkspace &) = delete;
+
+    // edges holds num_nodes - 1 pairs, u then v, and xy has room for 2 * num_nodes floats.
+    // the layout is written straight into xy. if num_nodes is negative, the edges dont make
+    // a tree or the root isnt one of its nodes, xy is left alone and error gets the reason
+    bool layoutEdges(int num_nodes, const int *edges, const RadialLayoutOptions &options, float *xy, std::string *error = nullptr);
+    // the same from a parent array, parents[u] is u's parent and -1 for the one root
+    bool layoutParents(int num_nodes, const int *parents, const RadialLayoutOptions &options, float *xy, std::string *error = nullptr);
+
+    // bytes kept between calls
+    size_t memoryUsage() const;
+
+private:
+    struct State;
+    bool run(int num_nodes, const RadialLayoutOptions &options, float *xy, std::string *error);
+
+    std::unique_ptr<State> state;
+};
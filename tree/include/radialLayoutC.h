@@ -0,0 +1,38 @@
+#pragma once
+#include <stddef.h>
+
+// the embeddable layout from radialLayout.h for c and anything with a c ffi. the functions
+// that can fail return 0 on success and leave the reason in rgl_last_error
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct rgl_workspace rgl_workspace;
+
+    typedef struct
+    {
+        float delta;   // distance between the rings
+        int root;      // node to put in the middle, -1 for the tree's true center
+        int fast_trig; // nonzero for polynomial trig instead of libm
+    } rgl_options;
+
+    rgl_options rgl_default_options(void);
+
+    // null if there is no memory for it
+    rgl_workspace *rgl_workspace_create(void);
+    void rgl_workspace_destroy(rgl_workspace *workspace);
+
+    // edges holds num_nodes - 1 pairs, u then v, xy gets x and y of every node. options may
+    // be null for the defaults
+    int rgl_layout_edges(rgl_workspace *workspace, int num_nodes, const int *edges, const rgl_options *options, float *xy);
+    // parents[u] is u's parent, -1 for the one root
+    int rgl_layout_parents(rgl_workspace *workspace, int num_nodes, const int *parents, const rgl_options *options, float *xy);
+
+    // empty after a call that worked, owned by the workspace
+    const char *rgl_last_error(const rgl_workspace *workspace);
+    size_t rgl_workspace_memory(const rgl_workspace *workspace);
+
+#ifdef __cplusplus
+}
+#endif
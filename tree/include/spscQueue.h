@@ -0,0 +1,60 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// fixed size ring buffer for exactly one producer thread and one consumer thread. neither
+// side ever takes a lock, the producer only writes tail and the consumer only writes head,
+// each on its own cache line so they dont keep stealing it from each other
+template <typename T>
+class SpscQueue
+{
+public:
+    // the capacity gets rounded up to a power of two
+    explicit SpscQueue(size_t capacity)
+        : head(0), tail(0)
+    {
+        size_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    // producer side, pushes as many values as fit and returns how many that was
+    size_t push(const T *values, size_t count)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t free = slots.size() - (t - head.load(std::memory_order_acquire));
+        if (count > free)
+            count = free;
+        for (size_t i = 0; i < count; ++i)
+            slots[(t + i) & mask] = values[i];
+        tail.store(t + count, std::memory_order_release);
+        return count;
+    }
+
+    // consumer side, appends everything queued so far to out and returns how many that was
+    size_t popAll(std::vector<T> &out)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t t = tail.load(std::memory_order_acquire);
+        for (size_t i = h; i != t; ++i)
+            out.push_back(slots[i & mask]);
+        head.store(t, std::memory_order_release);
+        return t - h;
+    }
+
+    bool empty() const
+    {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return slots.size(); }
+
+private:
+    std::vector<T> slots;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head; // next slot to read
+    alignas(64) std::atomic<size_t> tail; // next slot to write
+};
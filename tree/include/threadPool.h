@@ -0,0 +1,31 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// fixed set of worker threads pulling tasks off one queue
+class ThreadPool
+{
+public:
+    // 0 threads means one per hardware thread
+    explicit ThreadPool(unsigned num_threads = 0);
+    ~ThreadPool();
+
+    void submit(std::function<void()> task);
+    // blocks until every task submitted so far has finished
+    void wait();
+    unsigned getNumThreads() const;
+
+private:
+    void run();
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable task_ready, all_done;
+    std::deque<std::function<void()>> tasks;
+    int running;
+    bool stopping;
+};
@@ -1,24 +1,50 @@
 #pragma once
 #include <vector>
 #include <string>
-#include "graphics.h"
+#include <cstddef>
+#include "point.h"
 
+// a view over one node's neighbors inside the tree's packed adjacency
+struct NeighborRange
+{
+    const int *first, *last;
+
+    const int *begin() const { return first; }
+    const int *end() const { return last; }
+    size_t size() const { return static_cast<size_t>(last - first); }
+    int operator[](size_t i) const { return first[i]; }
+};
+
+// trees are immutable once built, use TreeBuilder to make one from an edge list
 class Tree
 {
 public:
-    Tree(int num_vertices);
-
-    void addEdge(int u, int v);
+    Tree(int num_vertices = 0);
 
     int getNumVertices() const;
-    const std::vector<std::vector<int>> &getAdjacencyList() const;
-    const std::vector<int> &getNeighbors(int u) const;
-    std::vector<std::pair<int, int>> getEdges() const;
+    NeighborRange getNeighbors(int u) const;
+    const std::vector<std::pair<int, int>> &getEdges() const;
+    int getNumEdges() const;
+    // bytes of the edge list and the packed adjacency
+    size_t memoryUsage() const;
+    // no other tree built in this run has it, unlike the address, which the next tree can get
+    // once this one is freed. copies keep it since they hold the same tree
+    unsigned long long getId() const;
 
-    static Tree loadFromFile(const std::string &filename);
+    // returns an empty tree if the file cant be read or isnt a valid tree. with allow_forest the
+    // file may hold several trees, which only ForestLayout knows how to lay out. callers that
+    // already load files on several threads turn parallel off, it only oversubscribes them
+    static Tree loadFromFile(const std::string &filename, std::string *error = nullptr, bool allow_forest = false, bool parallel = true);
     static Tree generateRandom(int n);
 
 private:
+    friend class TreeBuilder;
+
+    static unsigned long long nextId();
+
+    unsigned long long id;
     int num_vertices;
-    std::vector<std::vector<int>> adj;
-};
\ No newline at end of file
+    std::vector<std::pair<int, int>> edges; // kept as (smaller, larger) in insertion order
+    // n + 1 offsets followed by every node's neighbors, all in a single allocation
+    std::vector<int> adjacency;
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include "tree.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class TreeError
+{
+    NONE,
+    BAD_NODE_COUNT,
+    ID_OUT_OF_RANGE,
+    SELF_LOOP,
+    DUPLICATE_EDGE,
+    CYCLE,
+    DISCONNECTED
+};
+
+// collects an edge list and checks that it really is a tree before anything gets laid out.
+// ids, self loops and duplicates are checked in linear passes, cycles and connectivity
+// with a lock free union find that splits big edge lists across threads
+class TreeBuilder
+{
+public:
+    explicit TreeBuilder(int num_vertices);
+    TreeBuilder(int num_vertices, std::vector<std::pair<int, int>> edges);
+
+    void reserve(size_t num_edges);
+    void addEdge(int u, int v);
+    // starts over on a new edge list, keeping every buffer. a builder that is reset and fed
+    // trees of about the same size over and over stops allocating after the first one
+    void reset(int num_vertices);
+    // big edge lists are checked on several threads unless this is off
+    void setParallel(bool parallel);
+    // accepts edges that leave several trees instead of one, for ForestLayout. cycles are
+    // still rejected
+    void setAllowForest(bool allow_forest);
+
+    // validates the edges and moves them into out, on failure out is left alone. out's old
+    // buffers come back to the builder, so rebuilding the same tree object reuses them
+    bool build(Tree &out);
+
+    TreeError getError() const;
+    // human readable reason, mentions the offending edge when there is one
+    const std::string &getErrorMessage() const;
+    // how many trees the last successful build made, 1 unless forests are allowed
+    int getNumComponents() const;
+    // bytes of the buffers it keeps for the next build
+    size_t memoryUsage() const;
+
+private:
+    bool fail(TreeError error, int u, int v);
+    bool checkIds();
+    void buildAdjacency(std::vector<int> &adjacency) const;
+    bool checkDuplicates(const std::vector<int> &adjacency);
+    bool checkCycles();
+
+    int find(int x);
+    bool unite(int a, int b);
+
+    int num_vertices;
+    std::vector<std::pair<int, int>> edges;
+    std::vector<int> adjacency, last_seen;
+    std::unique_ptr<std::atomic<int>[]> parent;
+    size_t parent_capacity;
+    bool parallel;
+    bool allow_forest;
+    int num_components;
+
+    TreeError error;
+    std::string error_message;
+};
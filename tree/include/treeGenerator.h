@@ -0,0 +1,41 @@
+#pragma once
+#include "tree.h"
+#include <functional>
+#include <string>
+
+// families of synthetic trees, each one stresses a different part of the layout
+enum class TreeFamily
+{
+    UNIFORM,          // uniform random labeled tree from a prufer sequence
+    PATH,             // one long chain, the deepest possible tree
+    CATERPILLAR,      // a spine with legs hanging off it, long center search
+    STAR,             // one hub and n - 1 leaves
+    KARY,             // complete k-ary tree, param is k
+    RANDOM_RECURSIVE, // each node picks a uniformly random earlier parent
+    PREFERENTIAL,     // each node picks a parent proportional to its degree
+    BROOM,            // a path (the handle) ending in a star (the bristles)
+    SPIDER,           // param legs of equal length joined at one center
+    COUNT
+};
+
+struct GeneratorParams
+{
+    TreeFamily family;
+    int num_nodes;
+    unsigned long long seed;
+    int param; // family specific, 0 picks a sensible default
+};
+
+// seeded generators, the same params always give the same tree
+class TreeGenerator
+{
+public:
+    static const char *familyName(TreeFamily family);
+    static bool parseFamily(const std::string &name, TreeFamily &family);
+
+    // calls emit(u, v) once per edge without keeping the edges around
+    static void forEachEdge(const GeneratorParams &params, const std::function<void(int, int)> &emit);
+    static Tree generate(const GeneratorParams &params);
+    // streams the tree to disk in the same format loadFromFile reads
+    static bool writeToFile(const GeneratorParams &params, const std::string &filename, std::string *error = nullptr);
+};
@@ -1,8 +1,11 @@
 #pragma once
 #include "tree.h"
-#include "graphics.h"
+#include "point.h"
 #include <vector>
-#include <set>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <atomic>
 
 #define M_PI 3.14159265358979323846
 
@@ -14,48 +17,396 @@ struct Wedge
     float end_angle;
 };
 
+// where a node sits seen from the layout center, angle in radians from the x axis
+struct PolarPoint
+{
+    float radius, angle;
+};
+
+// the angles a node got from its parent, its own children split this range
+struct AngleRange
+{
+    float alpha1, alpha2;
+};
+
+// a node waiting to be placed. its parent already worked out where it goes and how much of
+// its wedge its own children get, for the whole sibling group at once
+struct LayoutTask
+{
+    int u, p;
+    float alpha1, alpha2;
+    Point pos;
+    float start_alpha, span;
+};
+
+// how the layout evaluates its trig. PRECISE calls libm for every node, FAST runs the
+// polynomial kernels in fastTrig.h over each sibling group, within their error bounds
+enum class TrigMode
+{
+    PRECISE,
+    FAST
+};
+
+// which layout the nodes get. RADIAL is Eades' wedges, TIDY a top down Reingold-Tilford tree
+// and BALLOON nests every subtree in a disc around its root. see layoutEngine.h
+enum class LayoutStyle
+{
+    RADIAL,
+    TIDY,
+    BALLOON
+};
+
+// what a layout keeps for the blueprint. a compact one keeps only the circles about the
+// center, the per node parts would cost as much as the layout itself
+enum class FrameworkRecording
+{
+    NONE,
+    CIRCLES,
+    ALL
+};
+
+// a circle of the balloon blueprint, where one node's children sit
+struct FrameworkRing
+{
+    Point center;
+    float radius;
+};
+
+// a subtree whose layout was copied from an identical one placed earlier, turned about the
+// layout center by angle radians and then moved by offset. the renderer draws these as
+// instances of the source
+struct SharedSubtree
+{
+    int root, source;
+    float angle;
+    Point offset;
+};
+
+// one line of a memory report, what a part of the program holds right now
+struct MemoryItem
+{
+    const char *name;
+    size_t bytes;
+};
+
+// node depths. a compact layout keeps them in 16 bits, and the first node deeper than that
+// widens the whole array to ints on the spot, so nothing has to know the depth up front
+class DepthArray
+{
+public:
+    int operator[](size_t u) const { return narrow.empty() ? wide[u] : narrow[u]; }
+    void set(size_t u, int depth);
+    // n entries, the old values are kept if the size and width already match
+    void reset(size_t n, bool compact);
+    size_t memoryUsage() const;
+
+private:
+    std::vector<uint16_t> narrow;
+    std::vector<int> wide;
+    bool widened = false;
+    bool compact_mode = false; // what the last reset asked for
+};
+
+// shared with a background thread so it can watch the layout and abandon it early
+struct LayoutProgress
+{
+    std::atomic<int> nodes_done{0};
+    std::atomic<bool> cancelled{false};
+};
+
 class TreeLayout
 {
 public:
-    TreeLayout(const Tree &tree, const int halfwidth, const int halfheight);
+    TreeLayout(const Tree &tree, const int halfwidth, const int halfheight, float delta = 50.0f);
 
     void calculateLayoutFromRoot(int rootID);
     void calculateTrueCenterLayout();
+    // the same layout computed breadth first, one depth ring at a time, so it can be spread
+    // over several frames. begin places the centers, each step returns true once it is done.
+    // begin does the two O(n) passes, finding the center and the widths, so it belongs on the
+    // worker while the steps go on the ui thread
+    void beginProgressiveLayout(int rootID = -1);
+    bool stepProgressiveLayout(double budget_ms);
+    bool isLayoutComplete() const;
+    // rings up to this depth are fully placed
+    int getCompletedDepth() const;
+    // nodes in the order they were placed, the first getNumCompletedNodes() are the finished rings.
+    // only kept while a progressive layout is running
+    const std::vector<int> &getPlacedNodes() const;
+    size_t getNumCompletedNodes() const;
+    // fills in the pruning steps. it writes to the layout, so never call it on one another
+    // thread or the layout cache may be reading
     void prepareFindCenterAnimation();
 
+    // takes effect on the next calculation
     void setDelta(float newDelta);
     float getDelta() const;
+    // takes effect on the next calculation
+    void setTrigMode(TrigMode mode);
+    TrigMode getTrigMode() const;
+    // reuses the placement of identical subtrees where the layout is the same up to a turn
+    // about the center, see layoutSubTree. takes effect on the next calculation
+    void setShareSubtrees(bool share);
+    bool getShareSubtrees() const;
+    // takes effect on the next calculation. anything but the float radial layout runs through
+    // the engines in layoutEngine.h, which place the whole tree at once: no fast trig, shared
+    // subtrees or placing in steps there, and collapsing a node lays the tree out again
+    void setStyle(LayoutStyle new_style);
+    LayoutStyle getStyle() const;
+    // works the positions out in double before they are stored as floats, for trees deep
+    // enough that float steps add up. takes effect on the next calculation
+    void setDoublePrecision(bool use_double);
+    bool getDoublePrecision() const;
+
+    void setProgress(LayoutProgress *progress);
+    bool wasCancelled() const;
+
+    // a collapsed node is laid out as a single leaf and nothing below it is visited.
+    // set these before calculating, an empty vector means nothing is collapsed
+    void setCollapsed(std::vector<char> collapsed_nodes);
+    const std::vector<char> &getCollapsed() const;
+    bool isCollapsed(int u) const;
+    // collapses or expands one visible node in place. only its subtree is laid out again,
+    // inside the wedge it already had, so the rest of the layout doesnt move
+    // a cancelled expand leaves the layout as it was, with u still collapsed
+    void toggleCollapsed(int u);
+
+    // keeps only what drawing and hovering need, in narrower types where they fit: depths
+    // in 16 bits, no polar positions (getPolarPosition works them out), no blueprint wedges,
+    // only its circles, and no node wedges, so collapsing lays the whole tree out again.
+    // once the layout is done the subtree sizes go too (getSubtreeSize works them out), and
+    // the radial layout keeps each node as the 32 bit direction of the edge from its parent
+    // instead of a float position. a layout placed in steps or into an outside buffer keeps
+    // its floats. takes effect on the next calculation
+    void setCompact(bool compact);
+    bool getCompact() const;
+    // whether to keep the blueprint circles and wedges at all, on unless nobody draws them.
+    // takes effect on the next calculation
+    void setBlueprint(bool keep);
+    bool getBlueprint() const;
+
+    // bytes held by the per node arrays and the framework, roughly. if report is given it
+    // gets one line per part, the total is what they add up to
+    size_t memoryUsage(std::vector<MemoryItem> *report = nullptr) const;
+
+    // saves the target positions, either as "node,x,y" csv lines or as binary: the four bytes
+    // "RGLP", a uint32 node count, then an x and y float per node in native byte order
+    bool writePositions(const std::string &filename, bool csv, std::string *error = nullptr) const;
+    // the same for any positions indexed by node
+    static bool writePositions(const std::string &filename, const std::vector<Point> &positions, bool csv, std::string *error = nullptr);
+
+    // the per node math every layout pass shares. placeSiblings puts each task's node off the
+    // parent's position at the middle of its wedge, then computeSpans fills in the part of the
+    // wedge its own children split. both take a whole sibling group so the trig runs over arrays
+    static void placeSiblings(Point parent_pos, LayoutTask *tasks, size_t count, float delta, TrigMode mode);
+    static void computeSpans(LayoutTask *tasks, size_t count, float delta, TrigMode mode);
+    static Point positionFromParent(Point parent_pos, AngleRange wedge, float delta, TrigMode mode);
+    // where a child's share of the wedge starts, after the siblings before it took theirs. the
+    // shares have to tile the wedge exactly, so the last one ends where the wedge does. they are
+    // worked out from the summed widths every time, adding float shares up one by one drifts,
+    // and on a star of a hundred thousand it ran past a whole turn onto the first leaves
+    static float shareStart(float start_alpha, float span, double width_before, double total_width)
+    {
+        return start_alpha + static_cast<float>(width_before / total_width) * span;
+    }
 
     float getHalfWidth() const;
     float getHalfHeight() const;
 
+    // where the next calculations put the positions instead of the layout's own array, room
+    // for a point per node of the tree. getTargetPositions is empty while it is set, and
+    // nodes the layout doesnt place are left as they were. nullptr goes back to the own array.
+    // a copy of the layout writes to the same buffer, so copy one that has none
+    void setOutput(Point *positions);
+    // empty once a compact layout quantized its positions, the three after it work either way
     const std::vector<Point> &getTargetPositions() const;
+    // one node's target, added up edge by edge from the center for quantized positions
+    Point getTargetPosition(int u) const;
+    // every target into out, indexed by node. nodes that arent shown get the screen center
+    void decodeTargetPositions(std::vector<Point> &out) const;
+    // calls visit(v, position, parent_position) for u's subtree in pre-order, u gets its own
+    // position as its parent's. stack is scratch for quantized positions, a point per level
+    template <typename Visit>
+    void visitSubtreeTargets(int u, std::vector<Point> &stack, Visit visit) const;
+    bool hasQuantizedPositions() const;
+    // the same positions around the layout center instead of on the screen. turning the
+    // whole layout only adds to the angles, so the view can do that without a new layout
+    // empty for a compact layout, use getPolarPosition there
+    const std::vector<PolarPoint> &getPolarPositions() const;
+    PolarPoint getPolarPosition(int u) const;
     const std::vector<int> &getCenterNodes() const;
-    const std::vector<int> &getDepths() const;
+    const DepthArray &getDepths() const;
     const std::vector<int> &getWidths() const;
     int getMaxDepth() const;
     const std::vector<int> &getParentMap() const;
+    // pre-order numbering, so every subtree is the range [index, index + size).
+    // only visible nodes are numbered, hidden ones have index -1
+    const std::vector<int> &getPreorderIndex() const;
+    const std::vector<int> &getPreorderNodes() const;
+    // empty for a finished compact layout, use getSubtreeSize there
+    const std::vector<int> &getSubtreeSizes() const;
+    // a subtree runs on in pre-order up to the next node no deeper than its root, so without
+    // the sizes this counts its nodes
+    int getSubtreeSize(int u) const;
     const std::vector<std::vector<int>> &getPruningGenerations() const;
-    const std::set<float> &getFrameworkCircles() const;
+    // which pruning round removes each node, filled by prepareFindCenterAnimation
+    const std::vector<int> &getPruneGenerations() const;
+    // sorted, one per distinct radius
+    const std::vector<float> &getFrameworkCircles() const;
     const std::vector<Wedge> &getFrameworkWedges() const;
+    const std::vector<FrameworkRing> &getFrameworkRings() const;
+    // canonical id of every visible node's subtree shape, only filled while sharing subtrees.
+    // two nodes get the same id exactly when their subtrees match with the children in order
+    const std::vector<int> &getShapeIds() const;
+    int getNumShapes() const;
+    const std::vector<SharedSubtree> &getSharedSubtrees() const;
 
 private:
     void findCenter();
     void computeWidthsAndDepths(int u, int p, int d);
+    // places the centers and everything below them, once findCenter or the caller picked them
+    void layoutCenters();
+    bool usesEngine() const;
+    void layoutWithEngine();
+    // the float radial pass. what it records is a template argument, so the per node work
+    // doesnt check it, layoutSubTree and placeNode only pick the instantiation
     void layoutSubTree(int u, int p, float alpha1, float alpha2);
+    void placeNode(const LayoutTask &task, int root, std::vector<LayoutTask> &children);
+    template <FrameworkRecording Record>
+    void layoutSubTreeWith(int u, int p, float alpha1, float alpha2);
+    template <FrameworkRecording Record>
+    void placeNodeWith(const LayoutTask &task, int root, std::vector<LayoutTask> &children);
+    template <FrameworkRecording Record>
+    bool copySubtree(const LayoutTask &task, int source, float source_span);
+    int numberShape(const int *key, size_t length);
+    void resetShapeSources();
+    FrameworkRecording recording() const;
+    // the task a layout pass starts from, a node without a parent keeps its current position
+    LayoutTask rootTask(int u, int p, float alpha1, float alpha2, Point parent_pos) const;
     void resetLayoutState();
     void finalizeLayout();
+    void storePolar(const int *nodes, size_t count);
+    bool checkpoint();
+    std::vector<Point> localPositions() const;
+    Point *targets() { return output_positions ? output_positions : target_positions.data(); }
+    const Point *targets() const { return output_positions ? output_positions : target_positions.data(); }
+    void quantizePositions();
+    Point quantizedTarget(int u, std::vector<Point> &steps) const;
+    // sin of the direction in every top 16 bits, its cosine is the entry a quarter turn on
+    static const float *directionSines();
+    // the bottom 16 bits turn less than 1e-4 radians, where sin is the angle and cos is 1
+    Point edgeStep(int u) const
+    {
+        const float *sines = directionSines();
+        uint32_t q = edge_directions[u];
+        uint16_t high = static_cast<uint16_t>(q >> 16);
+        float sine = sines[high], cosine = sines[static_cast<uint16_t>(high + 16384)];
+        float low = static_cast<float>(q & 0xFFFF) * static_cast<float>(2 * M_PI / 4294967296.0);
+        return {DELTA * (cosine - sine * low), DELTA * (sine + cosine * low)};
+    }
+    void rebuildFramework();
+    void sortFrameworkCircles();
 
     const Tree &tree_ref;
     float DELTA;
     int halfwidth, halfheight;
+    TrigMode trig_mode;
+    bool share_subtrees;
+    bool compact;
+    bool blueprint;
+    LayoutStyle style;
+    bool double_precision;
 
     std::vector<Point> target_positions;
+    Point *output_positions;
+    // a quantized layout's positions, the first node in pre-order keeps its own
+    std::vector<uint32_t> edge_directions;
+    Point root_position;
+    std::vector<PolarPoint> polar_positions;
     std::vector<int> center_nodes, true_center_nodes;
-    std::vector<int> widths, depths;
+    std::vector<int> widths;
+    DepthArray depths;
     int max_depth;
     std::vector<int> parent_map;
+    std::vector<int> preorder_index, preorder_nodes, subtree_sizes;
+    std::vector<AngleRange> node_wedges;
+    std::vector<char> collapsed;
     std::vector<std::vector<int>> pruning_generations;
-    std::set<float> framework_circles;
+    std::vector<int> prune_generation;
+    // a ring per placed node until the layout is done, then sorted without repeats. clearing
+    // keeps the capacity, so laying out again doesnt allocate per node
+    std::vector<float> framework_circles;
     std::vector<Wedge> framework_wedges;
-};
\ No newline at end of file
+    std::vector<FrameworkRing> framework_rings;
+
+    // ahu style shape numbering, a node's key is its children's ids in neighbor order. the
+    // keys lie back to back in shape_keys, shape s from shape_starts[s], and shape_slots is an
+    // open addressing table of ids, so numbering allocates nothing once the buffers have grown
+    std::vector<int> shape_keys, shape_starts, shape_slots;
+    std::vector<int> shape_ids, shape_counts;
+    // the subtree every shape is copied from in the current pass, -1 until one is placed,
+    // and the span it had
+    std::vector<int> shape_sources;
+    std::vector<float> source_spans;
+    int copy_budget;
+    std::vector<SharedSubtree> shared_subtrees;
+
+    // the passes' own stacks, kept so laying out again doesnt allocate
+    struct WidthFrame
+    {
+        int u, p;
+        size_t next;
+        size_t first_shape;
+    };
+    std::vector<WidthFrame> width_stack;
+    // shape ids of the finished children still waiting for their parent, in order
+    std::vector<int> child_shapes_stack;
+    std::vector<LayoutTask> place_stack;
+
+    LayoutProgress *progress;
+    int pending_steps;
+    bool cancelled;
+
+    // breadth first state between beginProgressiveLayout and the last step
+    std::vector<LayoutTask> ring, next_ring;
+    size_t ring_pos;
+    std::vector<int> placed_nodes;
+    size_t completed_nodes;
+    int completed_depth;
+    bool complete;
+};
+
+template <typename Visit>
+void TreeLayout::visitSubtreeTargets(int u, std::vector<Point> &stack, Visit visit) const
+{
+    int first = preorder_index[u];
+    if (first < 0)
+        return;
+    int last = first + getSubtreeSize(u);
+    if (edge_directions.empty())
+    {
+        const Point *positions = targets();
+        visit(u, positions[u], positions[u]);
+        for (int i = first + 1; i < last; ++i)
+        {
+            int v = preorder_nodes[i];
+            visit(v, positions[v], positions[parent_map[v]]);
+        }
+        return;
+    }
+    // a node's parent is the last node seen one level up
+    int base = depths[u];
+    Point start = quantizedTarget(u, stack);
+    stack.assign(1, start);
+    visit(u, stack[0], stack[0]);
+    for (int i = first + 1; i < last; ++i)
+    {
+        int v = preorder_nodes[i];
+        size_t level = depths[v] - base;
+        if (stack.size() <= level)
+            stack.resize(level + 1);
+        Point parent_pos = stack[level - 1], step = edgeStep(v);
+        stack[level] = {parent_pos.x + step.x, parent_pos.y + step.y};
+        visit(v, stack[level], parent_pos);
+    }
+}
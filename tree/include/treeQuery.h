@@ -0,0 +1,48 @@
+#pragma once
+#include "treeLayout.h"
+#include <utility>
+#include <vector>
+
+// answers path questions about a laid out tree, rooted the same way the layout is. with two
+// centers the first one is the root and the second hangs right below it. built once per
+// layout, only visible nodes can be asked about and everything else gets -1
+class TreeQuery
+{
+public:
+    explicit TreeQuery(const TreeLayout &layout);
+
+    int depth(int u) const;
+    // lowest common ancestor and number of edges between u and v, both O(1)
+    int lca(int u, int v) const;
+    int distance(int u, int v) const;
+    // the ancestor k levels above u, 0 is u itself. O(log n)
+    int kthAncestor(int u, int k) const;
+    // every node from u to v, both ends included
+    std::vector<int> path(int u, int v) const;
+
+    // the same queries over a whole list at once, out gets one answer per entry
+    void lcaBatch(const std::vector<std::pair<int, int>> &pairs, std::vector<int> &out) const;
+    void distanceBatch(const std::vector<std::pair<int, int>> &pairs, std::vector<int> &out) const;
+    // each query is (node, k)
+    void kthAncestorBatch(const std::vector<std::pair<int, int>> &queries, std::vector<int> &out) const;
+
+    size_t memoryUsage() const;
+
+private:
+    bool isVisible(int u) const;
+    int parent(int u) const;
+    // takes and returns pre-order positions
+    int shallower(int a, int b) const;
+
+    const TreeLayout &layout_ref;
+    // the second center and where its half starts in pre-order, or -1 and the node count
+    int second_center;
+    int split;
+    // depth of the node at each pre-order position, the second center's half one deeper
+    std::vector<int> pos_depth;
+    // level k holds the position of the shallowest node in each range [i, i + 2^k)
+    std::vector<int> sparse;
+    std::vector<unsigned char> log_table;
+    // pre-order indices grouped by depth, each group is sorted since it was filled in order
+    std::vector<int> by_depth, depth_start;
+};
@@ -2,7 +2,8 @@
 #include "tree.h"
 #include "treeLayout.h"
 #include "graphics.h"
-#include <GL/glut.h>
+#include "labelRenderer.h"
+#include <map>
 #include <vector>
 
 struct Color
@@ -20,13 +21,52 @@ class TreeRenderer
 {
 public:
     TreeRenderer(const Tree &tree, const TreeLayout &layout);
+    ~TreeRenderer();
 
-    void draw(const std::vector<Point> &current_positions, int hoveredNodeID, bool showFramework, DrawState state, int animationStep);
+    // animationStep can be fractional, nodes fade out over the step they get pruned in.
+    // atRest says the positions are the layout's targets, then shared subtrees are drawn as
+    // moved instances of one display list per source and depth instead of node by node
+    void draw(const std::vector<Point> &current_positions, int hoveredNodeID, bool showFramework, DrawState state, float animationStep, bool atRest = false);
+    // builds the highlight buffers, instance table and display lists ahead of time, so after
+    // this drawing and hovering never allocate. a compact layout gets no highlight buffers.
+    // needs the gl context, call it on a new layout
+    void prepare();
+    // draws just the highlight for u's subtree, so it can go on top of a cached frame
+    void highlightSubtree(int u);
+    // draws a path of nodes as one line strip with its nodes on top
+    void highlightPath(const std::vector<Point> &positions, const std::vector<int> &path);
+    // labels the visible nodes that have room on a width by height screen with their ids.
+    // they are drawn in screen coordinates, so the view transform is only used to place them
+    void drawLabels(LabelRenderer &labels, const std::vector<Point> &positions, const ViewTransform &view, int width, int height);
+    // bytes of the highlight buffers and instance table, the display lists live on the gpu
+    size_t memoryUsage() const;
 
 private:
     void drawFramework(const std::vector<Point> &positions);
-    void highlightSubtree(int u, const std::vector<Point> &positions);
+    void drawVisibleEdges(const std::vector<Point> &positions, bool instanced);
+    // depth_shift colors u as if it were that much deeper, for a source drawn as a copy
+    void drawNode(int u, Point pos, int depth_shift = 0) const;
+    NeighborRange visibleNodes() const;
+    void buildHighlightBuffers();
+    void buildInstances();
+    GLuint buildMesh(int source, int depth);
+    void drawInstance(const SharedSubtree &shared);
 
     const Tree &tree_ref;
     const TreeLayout &layout_ref;
+
+    // nodes and the edges to their parents in pre-order, so a subtree is one contiguous range
+    std::vector<Point> highlight_nodes;
+    std::vector<Point> highlight_edges;
+    bool highlight_ready;
+    // reused between frames so drawing a path doesnt allocate
+    std::vector<Point> path_vertices;
+    // a point per level for walking a compact layout's quantized positions
+    std::vector<Point> level_positions;
+    // index into the layout's shared subtrees for nodes drawn as an instance, -1 for the rest
+    std::vector<int> instance_of;
+    bool instances_ready;
+    // display list of each source subtree for every depth a copy of it sits at, built the
+    // first time one of those copies is drawn
+    std::map<std::pair<int, int>, GLuint> meshes;
 };
\ No newline at end of file
@@ -0,0 +1,298 @@
+#include "include/labelRenderer.h"
+#include <algorithm>
+#include <cmath>
+
+// each glyph is 8 pixels wide (one byte per row, top row first) and 12 tall, with the
+// baseline 3 rows from the bottom. rendered from DejaVu Sans Mono at 11 pixels, which is
+// under the bitstream vera license, so the font doesnt need to be found at runtime
+static const int GLYPH_WIDTH = 8;
+static const int GLYPH_HEIGHT = 12;
+static const int GLYPH_ADVANCE = 7;
+static const int LINE_HEIGHT = 14;
+static const int FIRST_GLYPH = 32, LAST_GLYPH = 126;
+static const unsigned char GLYPHS[LAST_GLYPH - FIRST_GLYPH + 1][GLYPH_HEIGHT] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ' '
+    {0x00, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00, 0x10, 0x00, 0x00, 0x00}, // '!'
+    {0x00, 0x28, 0x28, 0x28, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '"'
+    {0x00, 0x14, 0x24, 0x7e, 0x28, 0x28, 0xfc, 0x48, 0x50, 0x00, 0x00, 0x00}, // '#'
+    {0x00, 0x10, 0x3c, 0x50, 0x50, 0x38, 0x14, 0x14, 0x78, 0x10, 0x10, 0x00}, // '$'
+    {0x00, 0xe0, 0xa0, 0xe4, 0x18, 0x20, 0xdc, 0x14, 0x1c, 0x00, 0x00, 0x00}, // '%'
+    {0x00, 0x38, 0x20, 0x20, 0x30, 0x5a, 0x4a, 0x44, 0x3e, 0x00, 0x00, 0x00}, // '&'
+    {0x00, 0x10, 0x10, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '\''
+    {0x10, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x10, 0x00, 0x00}, // '('
+    {0x20, 0x20, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x20, 0x20, 0x00, 0x00}, // ')'
+    {0x00, 0x10, 0x54, 0x38, 0x38, 0x54, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00}, // '*'
+    {0x00, 0x00, 0x00, 0x10, 0x10, 0x7c, 0x10, 0x10, 0x00, 0x00, 0x00, 0x00}, // '+'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x10, 0x20, 0x00, 0x00}, // ','
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x38, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '-'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x10, 0x00, 0x00, 0x00}, // '.'
+    {0x00, 0x04, 0x08, 0x08, 0x10, 0x10, 0x10, 0x20, 0x20, 0x40, 0x00, 0x00}, // '/'
+    {0x00, 0x3c, 0x66, 0x42, 0x4a, 0x42, 0x42, 0x66, 0x3c, 0x00, 0x00, 0x00}, // '0'
+    {0x00, 0x70, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x7c, 0x00, 0x00, 0x00}, // '1'
+    {0x00, 0x3c, 0x42, 0x02, 0x06, 0x0c, 0x18, 0x20, 0x7e, 0x00, 0x00, 0x00}, // '2'
+    {0x00, 0x3c, 0x42, 0x02, 0x3c, 0x06, 0x02, 0x42, 0x3c, 0x00, 0x00, 0x00}, // '3'
+    {0x00, 0x0c, 0x0c, 0x14, 0x24, 0x64, 0x7e, 0x04, 0x04, 0x00, 0x00, 0x00}, // '4'
+    {0x00, 0x7c, 0x40, 0x40, 0x7c, 0x06, 0x02, 0x02, 0x7c, 0x00, 0x00, 0x00}, // '5'
+    {0x00, 0x1e, 0x20, 0x40, 0x5c, 0x62, 0x42, 0x42, 0x3c, 0x00, 0x00, 0x00}, // '6'
+    {0x00, 0x7e, 0x04, 0x04, 0x08, 0x08, 0x10, 0x10, 0x20, 0x00, 0x00, 0x00}, // '7'
+    {0x00, 0x3c, 0x42, 0x42, 0x3c, 0x42, 0x42, 0x42, 0x3c, 0x00, 0x00, 0x00}, // '8'
+    {0x00, 0x3c, 0x42, 0x42, 0x42, 0x3e, 0x02, 0x04, 0x78, 0x00, 0x00, 0x00}, // '9'
+    {0x00, 0x00, 0x00, 0x10, 0x10, 0x00, 0x00, 0x10, 0x10, 0x00, 0x00, 0x00}, // ':'
+    {0x00, 0x00, 0x00, 0x10, 0x10, 0x00, 0x00, 0x10, 0x10, 0x20, 0x00, 0x00}, // ';'
+    {0x00, 0x00, 0x00, 0x02, 0x1c, 0x60, 0x38, 0x06, 0x00, 0x00, 0x00, 0x00}, // '<'
+    {0x00, 0x00, 0x00, 0x00, 0xfc, 0x00, 0xfc, 0x00, 0x00, 0x00, 0x00, 0x00}, // '='
+    {0x00, 0x00, 0x00, 0x40, 0x38, 0x06, 0x1c, 0x60, 0x00, 0x00, 0x00, 0x00}, // '>'
+    {0x00, 0x38, 0x04, 0x0c, 0x18, 0x10, 0x10, 0x00, 0x10, 0x00, 0x00, 0x00}, // '?'
+    {0x00, 0x1c, 0x26, 0x42, 0x4e, 0x52, 0x52, 0x4e, 0x60, 0x20, 0x1c, 0x00}, // '@'
+    {0x00, 0x18, 0x18, 0x18, 0x24, 0x24, 0x3c, 0x42, 0x42, 0x00, 0x00, 0x00}, // 'A'
+    {0x00, 0x7c, 0x42, 0x42, 0x7c, 0x42, 0x42, 0x42, 0x7c, 0x00, 0x00, 0x00}, // 'B'
+    {0x00, 0x1c, 0x22, 0x40, 0x40, 0x40, 0x40, 0x22, 0x1c, 0x00, 0x00, 0x00}, // 'C'
+    {0x00, 0x78, 0x44, 0x42, 0x42, 0x42, 0x42, 0x44, 0x78, 0x00, 0x00, 0x00}, // 'D'
+    {0x00, 0x7e, 0x40, 0x40, 0x7e, 0x40, 0x40, 0x40, 0x7e, 0x00, 0x00, 0x00}, // 'E'
+    {0x00, 0x7e, 0x40, 0x40, 0x7e, 0x40, 0x40, 0x40, 0x40, 0x00, 0x00, 0x00}, // 'F'
+    {0x00, 0x1c, 0x22, 0x40, 0x40, 0x46, 0x42, 0x22, 0x1c, 0x00, 0x00, 0x00}, // 'G'
+    {0x00, 0x42, 0x42, 0x42, 0x7e, 0x42, 0x42, 0x42, 0x42, 0x00, 0x00, 0x00}, // 'H'
+    {0x00, 0x7c, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x7c, 0x00, 0x00, 0x00}, // 'I'
+    {0x00, 0x1c, 0x04, 0x04, 0x04, 0x04, 0x04, 0x44, 0x38, 0x00, 0x00, 0x00}, // 'J'
+    {0x00, 0x44, 0x48, 0x50, 0x60, 0x50, 0x48, 0x44, 0x42, 0x00, 0x00, 0x00}, // 'K'
+    {0x00, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x7e, 0x00, 0x00, 0x00}, // 'L'
+    {0x00, 0x42, 0x66, 0x66, 0x5a, 0x5a, 0x42, 0x42, 0x42, 0x00, 0x00, 0x00}, // 'M'
+    {0x00, 0x42, 0x62, 0x52, 0x52, 0x4a, 0x4a, 0x46, 0x42, 0x00, 0x00, 0x00}, // 'N'
+    {0x00, 0x3c, 0x66, 0x42, 0x42, 0x42, 0x42, 0x66, 0x3c, 0x00, 0x00, 0x00}, // 'O'
+    {0x00, 0x7c, 0x42, 0x42, 0x42, 0x7c, 0x40, 0x40, 0x40, 0x00, 0x00, 0x00}, // 'P'
+    {0x00, 0x3c, 0x66, 0x42, 0x42, 0x42, 0x42, 0x66, 0x3c, 0x06, 0x00, 0x00}, // 'Q'
+    {0x00, 0x7c, 0x42, 0x42, 0x42, 0x7c, 0x44, 0x42, 0x41, 0x00, 0x00, 0x00}, // 'R'
+    {0x00, 0x3c, 0x42, 0x40, 0x78, 0x06, 0x02, 0x42, 0x3c, 0x00, 0x00, 0x00}, // 'S'
+    {0x00, 0xfe, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00, 0x00, 0x00}, // 'T'
+    {0x00, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x3c, 0x00, 0x00, 0x00}, // 'U'
+    {0x00, 0x42, 0x42, 0x24, 0x24, 0x24, 0x18, 0x18, 0x18, 0x00, 0x00, 0x00}, // 'V'
+    {0x00, 0x82, 0x92, 0x92, 0xaa, 0x6c, 0x6c, 0x44, 0x44, 0x00, 0x00, 0x00}, // 'W'
+    {0x00, 0x42, 0x24, 0x24, 0x18, 0x18, 0x24, 0x24, 0x42, 0x00, 0x00, 0x00}, // 'X'
+    {0x00, 0xc6, 0x44, 0x28, 0x38, 0x10, 0x10, 0x10, 0x10, 0x00, 0x00, 0x00}, // 'Y'
+    {0x00, 0x7e, 0x04, 0x04, 0x08, 0x10, 0x30, 0x20, 0x7e, 0x00, 0x00, 0x00}, // 'Z'
+    {0x30, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x30, 0x00, 0x00}, // '['
+    {0x00, 0x40, 0x20, 0x20, 0x10, 0x10, 0x10, 0x08, 0x08, 0x04, 0x00, 0x00}, // '\\'
+    {0x30, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x30, 0x00, 0x00}, // ']'
+    {0x00, 0x30, 0x48, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '^'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xfe}, // '_'
+    {0x10, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '`'
+    {0x00, 0x00, 0x00, 0x78, 0x04, 0x3c, 0x44, 0x44, 0x3c, 0x00, 0x00, 0x00}, // 'a'
+    {0x40, 0x40, 0x40, 0x78, 0x44, 0x44, 0x44, 0x44, 0x78, 0x00, 0x00, 0x00}, // 'b'
+    {0x00, 0x00, 0x00, 0x3c, 0x60, 0x40, 0x40, 0x60, 0x3c, 0x00, 0x00, 0x00}, // 'c'
+    {0x04, 0x04, 0x04, 0x3c, 0x44, 0x44, 0x44, 0x44, 0x3c, 0x00, 0x00, 0x00}, // 'd'
+    {0x00, 0x00, 0x00, 0x38, 0x44, 0x7c, 0x40, 0x40, 0x3c, 0x00, 0x00, 0x00}, // 'e'
+    {0x0c, 0x10, 0x10, 0x7c, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00, 0x00, 0x00}, // 'f'
+    {0x00, 0x00, 0x00, 0x3c, 0x44, 0x44, 0x44, 0x44, 0x3c, 0x04, 0x38, 0x00}, // 'g'
+    {0x40, 0x40, 0x40, 0x58, 0x64, 0x44, 0x44, 0x44, 0x44, 0x00, 0x00, 0x00}, // 'h'
+    {0x10, 0x00, 0x00, 0x70, 0x10, 0x10, 0x10, 0x10, 0x7c, 0x00, 0x00, 0x00}, // 'i'
+    {0x10, 0x00, 0x00, 0x70, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x60, 0x00}, // 'j'
+    {0x40, 0x40, 0x40, 0x48, 0x50, 0x60, 0x50, 0x48, 0x44, 0x00, 0x00, 0x00}, // 'k'
+    {0xe0, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x18, 0x00, 0x00, 0x00}, // 'l'
+    {0x00, 0x00, 0x00, 0x7c, 0x54, 0x54, 0x54, 0x54, 0x54, 0x00, 0x00, 0x00}, // 'm'
+    {0x00, 0x00, 0x00, 0x58, 0x64, 0x44, 0x44, 0x44, 0x44, 0x00, 0x00, 0x00}, // 'n'
+    {0x00, 0x00, 0x00, 0x38, 0x44, 0x44, 0x44, 0x44, 0x38, 0x00, 0x00, 0x00}, // 'o'
+    {0x00, 0x00, 0x00, 0x78, 0x44, 0x44, 0x44, 0x44, 0x78, 0x40, 0x40, 0x00}, // 'p'
+    {0x00, 0x00, 0x00, 0x3c, 0x44, 0x44, 0x44, 0x44, 0x3c, 0x04, 0x04, 0x00}, // 'q'
+    {0x00, 0x00, 0x00, 0x3c, 0x24, 0x20, 0x20, 0x20, 0x20, 0x00, 0x00, 0x00}, // 'r'
+    {0x00, 0x00, 0x00, 0x3c, 0x40, 0x70, 0x0c, 0x04, 0x78, 0x00, 0x00, 0x00}, // 's'
+    {0x00, 0x20, 0x20, 0xf8, 0x20, 0x20, 0x20, 0x20, 0x38, 0x00, 0x00, 0x00}, // 't'
+    {0x00, 0x00, 0x00, 0x44, 0x44, 0x44, 0x44, 0x44, 0x3c, 0x00, 0x00, 0x00}, // 'u'
+    {0x00, 0x00, 0x00, 0x44, 0x44, 0x28, 0x28, 0x28, 0x10, 0x00, 0x00, 0x00}, // 'v'
+    {0x00, 0x00, 0x00, 0x82, 0x82, 0x54, 0x54, 0x28, 0x28, 0x00, 0x00, 0x00}, // 'w'
+    {0x00, 0x00, 0x00, 0x6c, 0x28, 0x10, 0x10, 0x28, 0x6c, 0x00, 0x00, 0x00}, // 'x'
+    {0x00, 0x00, 0x00, 0x44, 0x48, 0x28, 0x28, 0x30, 0x10, 0x20, 0x60, 0x00}, // 'y'
+    {0x00, 0x00, 0x00, 0x7c, 0x08, 0x18, 0x30, 0x20, 0x7c, 0x00, 0x00, 0x00}, // 'z'
+    {0x1c, 0x10, 0x10, 0x10, 0x60, 0x10, 0x10, 0x10, 0x10, 0x1c, 0x00, 0x00}, // '{'
+    {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00}, // '|'
+    {0x70, 0x10, 0x10, 0x10, 0x0c, 0x10, 0x10, 0x10, 0x10, 0x70, 0x00, 0x00}, // '}'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x70, 0x0e, 0x00, 0x00, 0x00, 0x00, 0x00}, // '~'
+};
+
+// 16 glyphs to a row of the atlas, 6 rows of them fit in a 128 square
+static const int ATLAS_SIZE = 128;
+static const int ATLAS_COLUMNS = ATLAS_SIZE / GLYPH_WIDTH;
+// the screen is cut into cells this big, a node label needs all the cells it covers
+static const float CELL_SIZE = 7.0f;
+// where a node's label starts, just to the right of its circle
+static const float LABEL_OFFSET_X = 9.0f, LABEL_OFFSET_Y = 2.0f;
+
+LabelRenderer::LabelRenderer() : texture(0), stamp(0), num_node_labels(0) {}
+
+LabelRenderer::~LabelRenderer()
+{
+    if (texture)
+        glDeleteTextures(1, &texture);
+}
+
+void LabelRenderer::bakeAtlas()
+{
+    std::vector<unsigned char> pixels(ATLAS_SIZE * ATLAS_SIZE, 0);
+    for (int g = 0; g <= LAST_GLYPH - FIRST_GLYPH; ++g)
+    {
+        int left = (g % ATLAS_COLUMNS) * GLYPH_WIDTH;
+        int top = (g / ATLAS_COLUMNS) * GLYPH_HEIGHT;
+        for (int row = 0; row < GLYPH_HEIGHT; ++row)
+        {
+            for (int bit = 0; bit < GLYPH_WIDTH; ++bit)
+            {
+                if (GLYPHS[g][row] & (0x80 >> bit))
+                    pixels[(top + row) * ATLAS_SIZE + left + bit] = 255;
+            }
+        }
+    }
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    // the glyphs are drawn at exactly their size, so nearest keeps them sharp
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, ATLAS_SIZE, ATLAS_SIZE, 0, GL_ALPHA, GL_UNSIGNED_BYTE, pixels.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// one quad with its bottom left corner on x, y
+void LabelRenderer::addGlyph(float x, float y, char c)
+{
+    if (c <= FIRST_GLYPH || c > LAST_GLYPH)
+        return;
+    int g = c - FIRST_GLYPH;
+    float u0 = static_cast<float>((g % ATLAS_COLUMNS) * GLYPH_WIDTH) / ATLAS_SIZE;
+    float u1 = u0 + static_cast<float>(GLYPH_WIDTH) / ATLAS_SIZE;
+    float v0 = static_cast<float>((g / ATLAS_COLUMNS) * GLYPH_HEIGHT) / ATLAS_SIZE;
+    float v1 = v0 + static_cast<float>(GLYPH_HEIGHT) / ATLAS_SIZE;
+    vertices.push_back({x, y, u0, v1});
+    vertices.push_back({x + GLYPH_WIDTH, y, u1, v1});
+    vertices.push_back({x + GLYPH_WIDTH, y + GLYPH_HEIGHT, u1, v0});
+    vertices.push_back({x, y + GLYPH_HEIGHT, u0, v0});
+}
+
+void LabelRenderer::addText(float x, float y, const char *text)
+{
+    // whole pixels, otherwise nearest sampling would cut columns off the glyphs
+    x = std::floor(x);
+    y = std::floor(y);
+    float cx = x;
+    for (const char *c = text; *c; ++c)
+    {
+        if (*c == '\n')
+        {
+            cx = x;
+            y -= LINE_HEIGHT;
+            continue;
+        }
+        addGlyph(cx, y, *c);
+        cx += GLYPH_ADVANCE;
+    }
+}
+
+// writes the id backwards into the end of buffer and returns where it starts
+static const char *formatId(int id, char *end)
+{
+    *--end = '\0';
+    do
+    {
+        *--end = static_cast<char>('0' + id % 10);
+        id /= 10;
+    } while (id > 0);
+    return end;
+}
+
+void LabelRenderer::addNodeLabels(const std::vector<Point> &positions, NeighborRange nodes, const DepthArray &depths,
+                                  const ViewTransform &view, float x0, float y0, float x1, float y1)
+{
+    num_node_labels = 0;
+    int columns = static_cast<int>(std::ceil((x1 - x0) / CELL_SIZE));
+    int rows = static_cast<int>(std::ceil((y1 - y0) / CELL_SIZE));
+    if (columns <= 0 || rows <= 0)
+        return;
+    if (taken.size() < static_cast<size_t>(columns) * rows)
+        taken.resize(static_cast<size_t>(columns) * rows, 0);
+    // a new stamp frees every cell at once, unless it wrapped around to ones still in there
+    if (++stamp == 0)
+    {
+        std::fill(taken.begin(), taken.end(), 0u);
+        stamp = 1;
+    }
+
+    // only labels that fit on screen take part, bucketed by depth with a counting sort
+    candidates.clear();
+    corners.clear();
+    int max_depth = 0;
+    for (int u : nodes)
+    {
+        // the labels stay upright and unscaled whatever the view does to the tree
+        Point screen = view.toScreen(positions[u]);
+        float x = std::floor(screen.x + LABEL_OFFSET_X), y = std::floor(screen.y + LABEL_OFFSET_Y);
+        int length = 1;
+        for (int id = u; id >= 10; id /= 10)
+            ++length;
+        if (x < x0 || y < y0 || x + length * GLYPH_ADVANCE > x1 || y + GLYPH_HEIGHT > y1)
+            continue;
+        candidates.push_back(u);
+        corners.push_back({x, y});
+        max_depth = std::max(max_depth, depths[u]);
+    }
+    depth_starts.assign(max_depth + 2, 0);
+    for (int u : candidates)
+        ++depth_starts[depths[u] + 1];
+    for (int d = 1; d <= max_depth + 1; ++d)
+        depth_starts[d] += depth_starts[d - 1];
+    by_depth.resize(candidates.size());
+    for (size_t k = 0; k < candidates.size(); ++k)
+        by_depth[depth_starts[depths[candidates[k]]]++] = static_cast<int>(k);
+
+    char buffer[16];
+    for (int k : by_depth)
+    {
+        float x = corners[k].x, y = corners[k].y;
+        const char *text = formatId(candidates[k], buffer + sizeof(buffer));
+        int length = static_cast<int>(buffer + sizeof(buffer) - 1 - text);
+        int c0 = static_cast<int>((x - x0) / CELL_SIZE);
+        int c1 = std::min(columns - 1, static_cast<int>((x + length * GLYPH_ADVANCE - 1 - x0) / CELL_SIZE));
+        int r0 = static_cast<int>((y - y0) / CELL_SIZE);
+        int r1 = std::min(rows - 1, static_cast<int>((y + GLYPH_HEIGHT - 1 - y0) / CELL_SIZE));
+        bool free = true;
+        for (int r = r0; r <= r1 && free; ++r)
+        {
+            for (int c = c0; c <= c1; ++c)
+            {
+                if (taken[r * columns + c] == stamp)
+                {
+                    free = false;
+                    break;
+                }
+            }
+        }
+        if (!free)
+            continue;
+        for (int r = r0; r <= r1; ++r)
+            std::fill(taken.begin() + r * columns + c0, taken.begin() + r * columns + c1 + 1, stamp);
+        for (const char *c = text; *c; ++c, x += GLYPH_ADVANCE)
+            addGlyph(x, y, *c);
+        ++num_node_labels;
+    }
+}
+
+void LabelRenderer::flush(float r, float g, float b)
+{
+    if (vertices.empty())
+        return;
+    if (!texture)
+        bakeAtlas();
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    // the atlas is alpha only, so the color comes from here and the shape from the glyph
+    glColor3f(r, g, b);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(2, GL_FLOAT, sizeof(Vertex), &vertices[0].x);
+    glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), &vertices[0].u);
+    glDrawArrays(GL_QUADS, 0, static_cast<GLsizei>(vertices.size()));
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_TEXTURE_2D);
+    vertices.clear();
+}
+
+int LabelRenderer::getNumNodeLabels() const { return num_node_labels; }
@@ -0,0 +1,77 @@
+#include "include/layoutCache.h"
+
+LayoutCache::LayoutCache(size_t budget_bytes)
+    : budget(budget_bytes), usage(0), tree_id(0), delta(0.0f), trig_mode(TrigMode::PRECISE), share_subtrees(false), compact(false), style(LayoutStyle::RADIAL),
+      double_precision(false), halfwidth(0), halfheight(0) {}
+
+void LayoutCache::setContext(unsigned long long new_tree_id, float new_delta, TrigMode new_trig_mode, bool new_share_subtrees, bool new_compact, LayoutStyle new_style,
+                             bool new_double_precision, int new_halfwidth, int new_halfheight)
+{
+    if (new_tree_id == tree_id && new_delta == delta && new_trig_mode == trig_mode && new_share_subtrees == share_subtrees && new_compact == compact &&
+        new_style == style && new_double_precision == double_precision && new_halfwidth == halfwidth && new_halfheight == halfheight)
+        return;
+    clear();
+    tree_id = new_tree_id;
+    delta = new_delta;
+    trig_mode = new_trig_mode;
+    share_subtrees = new_share_subtrees;
+    compact = new_compact;
+    style = new_style;
+    double_precision = new_double_precision;
+    halfwidth = new_halfwidth;
+    halfheight = new_halfheight;
+}
+
+std::shared_ptr<TreeLayout> LayoutCache::find(int root)
+{
+    auto it = index.find(root);
+    if (it == index.end())
+        return nullptr;
+    // move it to the front, list splicing keeps the iterators valid
+    entries.splice(entries.begin(), entries, it->second);
+    return it->second->layout;
+}
+
+void LayoutCache::insert(int root, std::shared_ptr<TreeLayout> layout)
+{
+    auto it = index.find(root);
+    if (it != index.end())
+    {
+        usage -= it->second->bytes;
+        entries.erase(it->second);
+        index.erase(it);
+    }
+    size_t bytes = layout->memoryUsage();
+    entries.push_front({root, std::move(layout), bytes});
+    index[root] = entries.begin();
+    usage += bytes;
+    evict();
+}
+
+void LayoutCache::clear()
+{
+    entries.clear();
+    index.clear();
+    usage = 0;
+}
+
+// throws out the least recently used layouts until we fit, but always keeps the newest one
+void LayoutCache::evict()
+{
+    while (usage > budget && entries.size() > 1)
+    {
+        usage -= entries.back().bytes;
+        index.erase(entries.back().root);
+        entries.pop_back();
+    }
+}
+
+void LayoutCache::setBudget(size_t budget_bytes)
+{
+    budget = budget_bytes;
+    evict();
+}
+
+size_t LayoutCache::getBudget() const { return budget; }
+size_t LayoutCache::getUsage() const { return usage; }
+size_t LayoutCache::getNumEntries() const { return entries.size(); }
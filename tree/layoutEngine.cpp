@@ -0,0 +1,70 @@
+#include "include/layoutEngine.h"
+
+// every combination the layout can ask for gets its own instantiation, so the engines' loops
+// never test any of it
+template <template <class> class Engine, typename Real, int Centers>
+static void runWith(FrameworkRecording record, const LayoutTraversal &traversal, const EngineOutput &output)
+{
+    switch (record)
+    {
+    case FrameworkRecording::NONE:
+        Engine<LayoutPolicy<Real, Centers, FrameworkRecording::NONE>>::run(traversal, output);
+        break;
+    case FrameworkRecording::CIRCLES:
+        Engine<LayoutPolicy<Real, Centers, FrameworkRecording::CIRCLES>>::run(traversal, output);
+        break;
+    case FrameworkRecording::ALL:
+        Engine<LayoutPolicy<Real, Centers, FrameworkRecording::ALL>>::run(traversal, output);
+        break;
+    }
+}
+
+template <template <class> class Engine>
+static void runWith(bool double_precision, FrameworkRecording record, const LayoutTraversal &traversal, const EngineOutput &output)
+{
+    bool two_centers = traversal.second_center < traversal.count;
+    if (double_precision)
+    {
+        if (two_centers)
+            runWith<Engine, double, 2>(record, traversal, output);
+        else
+            runWith<Engine, double, 1>(record, traversal, output);
+    }
+    else
+    {
+        if (two_centers)
+            runWith<Engine, float, 2>(record, traversal, output);
+        else
+            runWith<Engine, float, 1>(record, traversal, output);
+    }
+}
+
+void runLayoutEngine(LayoutStyle style, bool double_precision, FrameworkRecording record, const LayoutTraversal &traversal, const EngineOutput &output)
+{
+    switch (style)
+    {
+    case LayoutStyle::RADIAL:
+        runWith<RadialEngine>(double_precision, record, traversal, output);
+        break;
+    case LayoutStyle::TIDY:
+        runWith<TidyEngine>(double_precision, record, traversal, output);
+        break;
+    case LayoutStyle::BALLOON:
+        runWith<BalloonEngine>(double_precision, record, traversal, output);
+        break;
+    }
+}
+
+const char *layoutStyleName(LayoutStyle style)
+{
+    switch (style)
+    {
+    case LayoutStyle::RADIAL:
+        return "radial";
+    case LayoutStyle::TIDY:
+        return "tidy";
+    case LayoutStyle::BALLOON:
+        return "balloon";
+    }
+    return "unknown";
+}
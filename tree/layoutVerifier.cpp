@@ -0,0 +1,447 @@
+#include "include/layoutVerifier.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iterator>
+#include <set>
+
+static const double TWO_PI = 2.0 * M_PI;
+static const size_t MAX_PROBLEMS = 8;
+
+bool LayoutCheck::ok() const
+{
+    return structure_errors == 0 && width_errors == 0 && ring_errors == 0 && wedge_errors == 0 && !crossing;
+}
+
+std::string LayoutCheck::summary() const
+{
+    if (ok())
+        return "ok";
+    std::string s;
+    auto add = [&](int count, const char *what)
+    {
+        if (count == 0)
+            return;
+        if (!s.empty())
+            s += ", ";
+        s += std::to_string(count) + " " + what;
+    };
+    add(structure_errors, "structure");
+    add(width_errors, "width");
+    add(ring_errors, "ring");
+    add(wedge_errors, "wedge");
+    if (crossing)
+        add(1, "crossing");
+    return s;
+}
+
+static void addProblem(LayoutCheck &check, const std::string &problem)
+{
+    if (check.problems.size() < MAX_PROBLEMS)
+        check.problems.push_back(problem);
+}
+
+// the part of the wedge a node with this much of its parent's wedge keeps for its children,
+// the same rule computeSpans follows
+static double spanFor(double assigned, double radius, double delta)
+{
+    double tau = 2.0 * std::acos(std::min(1.0, radius / (radius + delta)));
+    return ((assigned < TWO_PI || radius > 0.0) && tau < assigned) ? tau : assigned;
+}
+
+// an edge for the sweep, p is the end further left (or lower, if it is vertical)
+struct SweepSegment
+{
+    double px, py, qx, qy;
+    int a, b; // the nodes at its ends
+
+    double yAt(double x) const
+    {
+        // the ends come back exactly, so edges meeting at a node tie there
+        if (x <= px || qx == px)
+            return py;
+        if (x >= qx)
+            return qy;
+        return py + (qy - py) * (x - px) / (qx - px);
+    }
+};
+
+static int orientation(double ax, double ay, double bx, double by, double cx, double cy)
+{
+    double cross = (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+    return (cross > 0.0) - (cross < 0.0);
+}
+
+static bool onSegment(double ax, double ay, double bx, double by, double cx, double cy)
+{
+    return std::min(ax, bx) <= cx && cx <= std::max(ax, bx) && std::min(ay, by) <= cy && cy <= std::max(ay, by);
+}
+
+// edges of a tree meet at the node they share and nowhere else, so those pairs never count
+static bool segmentsCross(const SweepSegment &s, const SweepSegment &t)
+{
+    if (s.a == t.a || s.a == t.b || s.b == t.a || s.b == t.b)
+        return false;
+    int o1 = orientation(s.px, s.py, s.qx, s.qy, t.px, t.py);
+    int o2 = orientation(s.px, s.py, s.qx, s.qy, t.qx, t.qy);
+    int o3 = orientation(t.px, t.py, t.qx, t.qy, s.px, s.py);
+    int o4 = orientation(t.px, t.py, t.qx, t.qy, s.qx, s.qy);
+    if (o1 != o2 && o3 != o4)
+        return true;
+    // touching or overlapping in a line
+    return (o1 == 0 && onSegment(s.px, s.py, s.qx, s.qy, t.px, t.py)) || (o2 == 0 && onSegment(s.px, s.py, s.qx, s.qy, t.qx, t.qy)) ||
+           (o3 == 0 && onSegment(t.px, t.py, t.qx, t.qy, s.px, s.py)) || (o4 == 0 && onSegment(t.px, t.py, t.qx, t.qy, s.qx, s.qy));
+}
+
+// Shamos-Hoey: sweep a vertical line left to right keeping the edges it cuts in order from the
+// bottom. two edges that cross are neighbors in that order just before they do, so only new
+// neighbors need testing. the order is only consistent while nothing has crossed yet, which is
+// why this stops at the first crossing. returns the index of the two edges, or -1
+static std::pair<int, int> findCrossing(const std::vector<SweepSegment> &segments)
+{
+    // compared where both exist, at the later of the left ends. edges starting at the same
+    // point are told apart at the earlier of the right ends
+    auto below = [&segments](int i, int j)
+    {
+        const SweepSegment &s = segments[i], &t = segments[j];
+        double x = std::max(s.px, t.px);
+        double ys = s.yAt(x), yt = t.yAt(x);
+        if (ys != yt)
+            return ys < yt;
+        x = std::min(s.qx, t.qx);
+        ys = s.yAt(x);
+        yt = t.yAt(x);
+        if (ys != yt)
+            return ys < yt;
+        return i < j;
+    };
+    std::set<int, decltype(below)> active(below);
+    std::vector<std::set<int, decltype(below)>::iterator> where(segments.size(), active.end());
+
+    // left ends before right ends at the same x, so edges that only touch there still meet
+    struct Event
+    {
+        double x;
+        int leaving;
+        int segment;
+    };
+    std::vector<Event> events;
+    events.reserve(2 * segments.size());
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        events.push_back({segments[i].px, 0, static_cast<int>(i)});
+        events.push_back({segments[i].qx, 1, static_cast<int>(i)});
+    }
+    std::sort(events.begin(), events.end(), [](const Event &a, const Event &b)
+              { return a.x != b.x ? a.x < b.x : a.leaving < b.leaving; });
+
+    for (const Event &event : events)
+    {
+        int i = event.segment;
+        if (!event.leaving)
+        {
+            auto next = active.lower_bound(i);
+            if (next != active.end() && segmentsCross(segments[*next], segments[i]))
+                return {*next, i};
+            if (next != active.begin() && segmentsCross(segments[*std::prev(next)], segments[i]))
+                return {*std::prev(next), i};
+            where[i] = active.insert(next, i);
+        }
+        else
+        {
+            auto it = where[i];
+            auto next = std::next(it);
+            if (it != active.begin() && next != active.end() && segmentsCross(segments[*std::prev(it)], segments[*next]))
+                return {*std::prev(it), *next};
+            active.erase(it);
+        }
+    }
+    return {-1, -1};
+}
+
+static LayoutCheck verify(const Tree &tree, const std::vector<Point> &positions, const std::vector<int> &centers, float delta_f,
+                          const std::vector<char> &collapsed, bool exact_shares, bool radial, const TreeLayout *layout)
+{
+    LayoutCheck check;
+    int n = tree.getNumVertices();
+    double delta = delta_f;
+    if (static_cast<int>(positions.size()) < n)
+    {
+        check.structure_errors++;
+        addProblem(check, "positions for " + std::to_string(positions.size()) + " of " + std::to_string(n) + " nodes");
+        return check;
+    }
+    bool pair = centers.size() == 2;
+    bool centers_ok = centers.size() == 1 || pair;
+    for (int c : centers)
+        centers_ok = centers_ok && c >= 0 && c < n;
+    if (centers_ok && pair)
+    {
+        NeighborRange neighbors = tree.getNeighbors(centers[0]);
+        centers_ok = std::find(neighbors.begin(), neighbors.end(), centers[1]) != neighbors.end();
+    }
+    if (!centers_ok)
+    {
+        check.structure_errors++;
+        addProblem(check, "the center has to be one node or two neighbors");
+        return check;
+    }
+
+    // the visible nodes breadth first from the center, and everyone's parent. -2 is hidden
+    std::vector<int> parent(n, -2), order;
+    order.reserve(n);
+    for (int c : centers)
+    {
+        parent[c] = pair ? centers[c == centers[0] ? 1 : 0] : -1;
+        order.push_back(c);
+    }
+    auto isCenter = [&](int u)
+    { return u == centers[0] || (pair && u == centers[1]); };
+    auto expanded = [&](int u)
+    { return isCenter(u) || collapsed.empty() || !collapsed[u]; };
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        int u = order[i];
+        if (!expanded(u))
+            continue;
+        for (int v : tree.getNeighbors(u))
+        {
+            if (v == parent[u])
+                continue;
+            parent[v] = u;
+            order.push_back(v);
+        }
+    }
+    check.nodes_checked = static_cast<int>(order.size());
+
+    // widths bottom up, the two centers dont add into each other
+    std::vector<int> widths(n, 0);
+    for (size_t i = order.size(); i-- > 0;)
+    {
+        int u = order[i];
+        if (widths[u] == 0)
+            widths[u] = 1;
+        if (!isCenter(u))
+            widths[parent[u]] += widths[u];
+    }
+    for (int u : order)
+    {
+        if (!std::isfinite(positions[u].x) || !std::isfinite(positions[u].y))
+        {
+            check.structure_errors++;
+            addProblem(check, "node " + std::to_string(u) + " has no finite position");
+        }
+        if (!layout)
+            continue;
+        if (layout->getParentMap()[u] != parent[u])
+        {
+            check.structure_errors++;
+            addProblem(check, "node " + std::to_string(u) + " has parent " + std::to_string(layout->getParentMap()[u]) + ", not " + std::to_string(parent[u]));
+        }
+        if (layout->getWidths()[u] != widths[u])
+        {
+            check.width_errors++;
+            addProblem(check, "node " + std::to_string(u) + " has width " + std::to_string(layout->getWidths()[u]) + ", its leaves make " + std::to_string(widths[u]));
+        }
+    }
+    // the geometry means nothing with holes in it
+    if (check.structure_errors > 0)
+        return check;
+
+    double ox = 0.0, oy = 0.0;
+    for (int c : centers)
+    {
+        ox += positions[c].x / static_cast<double>(centers.size());
+        oy += positions[c].y / static_cast<double>(centers.size());
+    }
+    auto radiusOf = [&](int u)
+    { return std::hypot(positions[u].x - ox, positions[u].y - oy); };
+
+    // floats lose a few ulps per step, at the radius of the node in question
+    auto ringTolerance = [&](double radius)
+    { return 1e-4 * delta + 8.0 * FLT_EPSILON * (radius + delta); };
+    auto wedgeTolerance = [&](double radius, double half_share)
+    { return 1e-5 + 1e-4 * half_share + 8.0 * FLT_EPSILON * (radius + delta) / delta; };
+
+    // the root of the copy every node strictly inside a shared subtree belongs to. a copy is its
+    // source moved as one piece, so it keeps the edge lengths and its own order but not the rings
+    std::vector<int> copy_root;
+    if (radial && layout && !layout->getSharedSubtrees().empty())
+    {
+        copy_root.assign(n, -1);
+        const auto &index = layout->getPreorderIndex();
+        const auto &nodes = layout->getPreorderNodes();
+        for (const SharedSubtree &copy : layout->getSharedSubtrees())
+        {
+            for (int i = index[copy.root] + 1; i < index[copy.root] + layout->getSubtreeSize(copy.root); ++i)
+                copy_root[nodes[i]] = copy.root;
+        }
+    }
+
+    std::vector<double> spans(n, 0.0);
+    if (radial && pair)
+    {
+        double gap = std::hypot(positions[centers[0]].x - positions[centers[1]].x, positions[centers[0]].y - positions[centers[1]].y);
+        double error = std::fabs(gap - delta);
+        check.max_ring_error = std::max(check.max_ring_error, error);
+        if (error > ringTolerance(delta))
+        {
+            check.ring_errors++;
+            addProblem(check, "the centers are " + std::to_string(gap) + " apart, not " + std::to_string(delta));
+        }
+        // each center gets the half plane away from the other
+        for (int c : centers)
+            spans[c] = spanFor(M_PI, radiusOf(c), delta);
+    }
+    else
+    {
+        spans[centers[0]] = TWO_PI;
+    }
+
+    for (int u : order)
+    {
+        if (!radial || !expanded(u) || widths[u] == 0)
+            continue;
+        double ru = radiusOf(u);
+        double span = spans[u];
+        double total = 0.0;
+        for (int v : tree.getNeighbors(u))
+        {
+            if (v != parent[u])
+                total += widths[v];
+        }
+        if (total == 0.0)
+            continue;
+
+        // the wedge is centered on u's direction from the center. the center itself has none,
+        // so its first child says where the wedge starts
+        double start = 0.0;
+        if (!pair && u == centers[0])
+        {
+            for (int v : tree.getNeighbors(u))
+            {
+                if (v == parent[u])
+                    continue;
+                // without exact shares only the order is checked, so the wedge starts just before
+                // the first child. its stale share could put the start past the child otherwise
+                double share = exact_shares ? widths[v] / total * span : 2e-6;
+                start = std::atan2(positions[v].y - positions[u].y, positions[v].x - positions[u].x) - share / 2.0;
+                break;
+            }
+        }
+        else
+        {
+            start = std::atan2(positions[u].y - oy, positions[u].x - ox) - span / 2.0;
+        }
+
+        double before = 0.0, last_along = -DBL_MAX;
+        for (int v : tree.getNeighbors(u))
+        {
+            if (v == parent[u])
+                continue;
+            double share = widths[v] / total * span;
+            double middle = start + (before + widths[v] / 2.0) / total * span;
+            before += widths[v];
+            double rv = radiusOf(v);
+            // without the shares v's own can only be bounded by the tangents
+            spans[v] = spanFor(exact_shares ? share : M_PI, rv, delta);
+
+            double dx = positions[v].x - positions[u].x, dy = positions[v].y - positions[u].y;
+            double length = std::hypot(dx, dy);
+            if (!copy_root.empty() && copy_root[v] != -1)
+            {
+                // delta from its parent and inside the cone the copy's root has from the center
+                int r = copy_root[v];
+                double ring_error = std::fabs(length - delta);
+                check.max_ring_error = std::max(check.max_ring_error, ring_error);
+                if (ring_error > ringTolerance(rv))
+                {
+                    check.ring_errors++;
+                    addProblem(check, "edge " + std::to_string(u) + "-" + std::to_string(v) + " of the copy at " + std::to_string(r) + " is " +
+                                          std::to_string(length) + " long");
+                }
+                double direction = std::atan2(positions[r].y - oy, positions[r].x - ox);
+                double off = std::fabs(std::remainder(std::atan2(positions[v].y - oy, positions[v].x - ox) - direction, TWO_PI)) - spans[r] / 2.0;
+                check.max_wedge_error = std::max(check.max_wedge_error, off);
+                if (off > wedgeTolerance(rv, spans[r] / 2.0))
+                {
+                    check.wedge_errors++;
+                    addProblem(check, "node " + std::to_string(v) + " is " + std::to_string(off) + " rad outside the cone of the copy at " + std::to_string(r));
+                }
+                continue;
+            }
+            double ring_error = std::max({std::fabs(length - delta), ru - rv, rv - (ru + delta)});
+            check.max_ring_error = std::max(check.max_ring_error, ring_error);
+            if (ring_error > ringTolerance(rv))
+            {
+                check.ring_errors++;
+                addProblem(check, "edge " + std::to_string(u) + "-" + std::to_string(v) + " is " + std::to_string(length) + " long at radius " +
+                                      std::to_string(rv) + ", its parent's ring is at " + std::to_string(ru + delta));
+            }
+
+            // inside the wedge and after the sibling before it
+            double angle = std::atan2(dy, dx);
+            double along = std::remainder(angle - start - span / 2.0, TWO_PI) + span / 2.0;
+            double off = std::max({-along, along - span, last_along - along});
+            last_along = std::max(last_along, along);
+            if (exact_shares)
+                off = std::max(off, std::fabs(std::remainder(angle - middle, TWO_PI)) - share / 2.0);
+            check.max_wedge_error = std::max(check.max_wedge_error, off);
+            if (off > wedgeTolerance(rv, (exact_shares ? share : span) / 2.0))
+            {
+                check.wedge_errors++;
+                addProblem(check, "node " + std::to_string(v) + " is " + std::to_string(off) + " rad outside its " + (exact_shares ? "share of " : "place in ") +
+                                      std::to_string(u) + "'s wedge");
+            }
+        }
+    }
+
+    std::vector<SweepSegment> segments;
+    segments.reserve(order.size());
+    for (int v : order)
+    {
+        int u = parent[v];
+        // the edge between two centers only once
+        if (u < 0 || (pair && v == centers[0]))
+            continue;
+        double ax = positions[u].x, ay = positions[u].y, bx = positions[v].x, by = positions[v].y;
+        if (bx < ax || (bx == ax && by < ay))
+            segments.push_back({bx, by, ax, ay, v, u});
+        else
+            segments.push_back({ax, ay, bx, by, u, v});
+    }
+    std::pair<int, int> crossing = findCrossing(segments);
+    if (crossing.first != -1)
+    {
+        const SweepSegment &s = segments[crossing.first], &t = segments[crossing.second];
+        check.crossing = true;
+        check.crossing_a = parent[s.a] == s.b ? s.a : s.b;
+        check.crossing_b = parent[t.a] == t.b ? t.a : t.b;
+        // far out floats cant tell close siblings apart any more, which looks the same to the sweep
+        bool coincide = (s.px == t.px && s.py == t.py) || (s.px == t.qx && s.py == t.qy) || (s.qx == t.px && s.qy == t.py) || (s.qx == t.qx && s.qy == t.qy);
+        addProblem(check, "edges " + std::to_string(s.a) + "-" + std::to_string(s.b) + " and " + std::to_string(t.a) + "-" + std::to_string(t.b) +
+                              (coincide ? " touch where two nodes coincide" : " cross"));
+    }
+    return check;
+}
+
+LayoutCheck LayoutVerifier::check(const Tree &tree, const TreeLayout &layout, bool exact_shares)
+{
+    bool radial = layout.getStyle() == LayoutStyle::RADIAL;
+    if (!layout.hasQuantizedPositions())
+        return verify(tree, layout.getTargetPositions(), layout.getCenterNodes(), layout.getDelta(), layout.getCollapsed(), exact_shares, radial, &layout);
+    std::vector<Point> positions;
+    layout.decodeTargetPositions(positions);
+    return verify(tree, positions, layout.getCenterNodes(), layout.getDelta(), layout.getCollapsed(), exact_shares, radial, &layout);
+}
+
+LayoutCheck LayoutVerifier::checkPositions(const Tree &tree, const std::vector<Point> &positions, const std::vector<int> &center_nodes, float delta,
+                                           bool exact_shares)
+{
+    return verify(tree, positions, center_nodes, delta, std::vector<char>(), exact_shares, true, nullptr);
+}
+
+LayoutCheck LayoutVerifier::checkPlanar(const Tree &tree, const std::vector<Point> &positions, const std::vector<int> &center_nodes)
+{
+    return verify(tree, positions, center_nodes, 1.0f, std::vector<char>(), false, false, nullptr);
+}
@@ -0,0 +1,213 @@
+#include "include/layoutWorker.h"
+#include <chrono>
+
+// jobs that replace the tree rather than lay out the one on screen
+static bool bringsNewTree(LayoutJobKind kind)
+{
+    return kind == LayoutJobKind::NEW_TREE || kind == LayoutJobKind::STREAM;
+}
+
+LayoutWorker::LayoutWorker() : active_kind(LayoutJobKind::NEW_TREE), stopping(false), pending_id(0), latest_job(0), busy(false), total_work(0)
+{
+    thread = std::thread(&LayoutWorker::run, this);
+}
+
+LayoutWorker::~LayoutWorker()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        if (active_progress)
+            active_progress->cancelled = true;
+    }
+    cv.notify_one();
+    thread.join();
+}
+
+bool LayoutWorker::submit(LayoutJob job)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!bringsNewTree(job.kind) && loadingTree())
+            return false;
+        pending = std::make_unique<LayoutJob>(std::move(job));
+        pending_id = ++latest_job;
+        // a newer request makes the running one pointless
+        if (active_progress)
+            active_progress->cancelled = true;
+        busy = true;
+    }
+    cv.notify_one();
+    return true;
+}
+
+void LayoutWorker::cancelPending()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    // the ui has to see the new tree, whatever made this call was about the old one
+    if (loadingTree())
+        return;
+    pending.reset();
+    ++latest_job;
+    if (active_progress)
+        active_progress->cancelled = true;
+    else
+        busy = false;
+    // anything already finished is stale now too
+    std::atomic_store(&published, std::shared_ptr<LayoutResult>());
+}
+
+std::shared_ptr<LayoutResult> LayoutWorker::takeResult()
+{
+    // cheap check first so idle frames dont pay for the exchange
+    if (!std::atomic_load(&published))
+        return nullptr;
+    return std::atomic_exchange(&published, std::shared_ptr<LayoutResult>());
+}
+
+bool LayoutWorker::isLoadingTree() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return loadingTree();
+}
+
+bool LayoutWorker::loadingTree() const
+{
+    if (pending && bringsNewTree(pending->kind))
+        return true;
+    if (active_progress && bringsNewTree(active_kind))
+        return true;
+    std::shared_ptr<LayoutResult> ready = std::atomic_load(&published);
+    return ready && bringsNewTree(ready->kind);
+}
+
+bool LayoutWorker::hasResult() const { return std::atomic_load(&published) != nullptr; }
+
+void LayoutWorker::setOnPublish(std::function<void()> callback) { on_publish = std::move(callback); }
+
+bool LayoutWorker::isBusy() const { return busy; }
+
+float LayoutWorker::getProgress() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    int total = total_work;
+    if (!active_progress || total <= 0)
+        return 0.0f;
+    float done = static_cast<float>(active_progress->nodes_done.load(std::memory_order_relaxed)) / total;
+    return done < 1.0f ? done : 1.0f;
+}
+
+void LayoutWorker::run()
+{
+    while (true)
+    {
+        std::unique_ptr<LayoutJob> job;
+        std::shared_ptr<LayoutProgress> progress;
+        unsigned job_id;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this]
+                    { return stopping || pending; });
+            if (stopping)
+                return;
+            job = std::move(pending);
+            job_id = pending_id;
+            progress = std::make_shared<LayoutProgress>();
+            active_progress = progress;
+            active_kind = job->kind;
+            total_work = job->tree ? 2 * job->tree->getNumVertices() : 0;
+        }
+
+        std::shared_ptr<LayoutResult> result = execute(*job, *progress);
+
+        bool finished;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            active_progress.reset();
+            // only publish if nobody asked for something newer in the meantime
+            if (result && job_id == latest_job)
+            {
+                std::atomic_store(&published, result);
+            }
+            if (!pending)
+                busy = false;
+            finished = !busy;
+        }
+        // going idle matters to the ui even when nothing was published
+        if (finished && on_publish)
+            on_publish();
+    }
+}
+
+std::shared_ptr<LayoutResult> LayoutWorker::execute(LayoutJob &job, LayoutProgress &progress)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::shared_ptr<Tree> tree = job.tree;
+    if (!tree)
+    {
+        std::string error;
+        tree = std::make_shared<Tree>(job.build(error));
+        // bad input is reported straight back, no layout work is wasted on it
+        if (!error.empty() || tree->getNumVertices() == 0)
+        {
+            auto result = std::make_shared<LayoutResult>();
+            result->kind = job.kind;
+            result->root = job.root;
+            result->node = job.node;
+            result->millis = 0.0;
+            result->error = error.empty() ? "the tree has no nodes" : error;
+            return result;
+        }
+        total_work = 2 * tree->getNumVertices();
+    }
+    if (progress.cancelled)
+        return nullptr;
+
+    std::shared_ptr<TreeLayout> layout;
+    if (job.kind == LayoutJobKind::COLLAPSE)
+    {
+        // the shown layout is shared with the ui, so toggle the node in a copy
+        layout = std::make_shared<TreeLayout>(*job.base);
+        layout->setProgress(&progress);
+        layout->toggleCollapsed(job.node);
+    }
+    else
+    {
+        layout = std::make_shared<TreeLayout>(*tree, job.halfwidth, job.halfheight, job.delta);
+        layout->setCollapsed(std::move(job.collapsed));
+        layout->setTrigMode(job.trig_mode);
+        layout->setShareSubtrees(job.share_subtrees);
+        layout->setCompact(job.compact);
+        layout->setStyle(job.style);
+        layout->setDoublePrecision(job.double_precision);
+        layout->setProgress(&progress);
+        if (job.progressive)
+        {
+            layout->beginProgressiveLayout(job.root);
+        }
+        else if (job.root == -1)
+        {
+            layout->calculateTrueCenterLayout();
+        }
+        else
+        {
+            layout->calculateLayoutFromRoot(job.root);
+        }
+    }
+    layout->setProgress(nullptr);
+    if (layout->wasCancelled())
+        return nullptr;
+
+    auto end = std::chrono::high_resolution_clock::now();
+    double millis = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1e6;
+
+    auto result = std::make_shared<LayoutResult>();
+    result->kind = job.kind;
+    result->root = job.root;
+    result->node = job.node;
+    result->tree = tree;
+    result->layout = layout;
+    result->millis = millis;
+    return result;
+}
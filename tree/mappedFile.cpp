@@ -0,0 +1,69 @@
+#include "include/mappedFile.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+MappedFile::MappedFile() : fd(-1), address(nullptr), bytes(0) {}
+
+MappedFile::~MappedFile() { close(); }
+
+bool MappedFile::create(const std::string &filename, size_t size, bool temporary, std::string *error)
+{
+    close();
+    auto fail = [&](const std::string &what)
+    {
+        if (error)
+            *error = what + " " + filename + ": " + strerror(errno);
+        close();
+        return false;
+    };
+
+    fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return fail("cannot create");
+    if (temporary)
+        unlink(filename.c_str());
+    if (size == 0)
+        return true;
+    // posix_fallocate reports its error as the return value instead of errno
+    int result = posix_fallocate(fd, 0, static_cast<off_t>(size));
+    if (result != 0)
+    {
+        errno = result;
+        return fail("cannot reserve space for");
+    }
+    void *mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED)
+        return fail("cannot map");
+    address = mapping;
+    bytes = size;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (address)
+        munmap(address, bytes);
+    if (fd >= 0)
+        ::close(fd);
+    fd = -1;
+    address = nullptr;
+    bytes = 0;
+}
+
+void MappedFile::adviseSequential()
+{
+    if (address)
+        madvise(address, bytes, MADV_SEQUENTIAL);
+}
+
+void MappedFile::adviseRandom()
+{
+    if (address)
+        madvise(address, bytes, MADV_RANDOM);
+}
+
+void *MappedFile::data() const { return address; }
+size_t MappedFile::size() const { return bytes; }
@@ -0,0 +1,385 @@
+#include "include/outOfCoreLayout.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+// pulls unsigned numbers out of a text file through a fixed buffer, the files this is
+// meant for are far too big to go through a stream one number at a time
+class NumberReader
+{
+public:
+    explicit NumberReader(FILE *f) : file(f), buffer(1 << 20), pos(0), end(0), bad(false) {}
+
+    // false at the end of the file, or when something other than a number shows up
+    bool next(uint64_t &value)
+    {
+        int c = get();
+        while (isSpace(c))
+            c = get();
+        if (c == EOF)
+            return false;
+        if (c < '0' || c > '9')
+        {
+            bad = true;
+            return false;
+        }
+        value = 0;
+        while (c >= '0' && c <= '9')
+        {
+            // anything this big is out of range anyway, this just keeps it from wrapping around
+            if (value < (1ull << 40))
+                value = value * 10 + (c - '0');
+            c = get();
+        }
+        if (c != EOF && !isSpace(c))
+        {
+            bad = true;
+            return false;
+        }
+        return true;
+    }
+
+    bool failed() const { return bad; }
+
+    void restart()
+    {
+        rewind(file);
+        pos = end = 0;
+        bad = false;
+    }
+
+private:
+    static bool isSpace(int c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+
+    int get()
+    {
+        if (pos == end)
+        {
+            end = fread(buffer.data(), 1, buffer.size(), file);
+            pos = 0;
+            if (end == 0)
+                return EOF;
+        }
+        return static_cast<unsigned char>(buffer[pos++]);
+    }
+
+    FILE *file;
+    std::vector<char> buffer;
+    size_t pos, end;
+    bool bad;
+};
+
+OutOfCoreLayout::OutOfCoreLayout(float delta) : DELTA(delta), trig_mode(TrigMode::PRECISE), num_vertices(0), scratch_bytes(0), peak_scratch_bytes(0) {}
+
+void OutOfCoreLayout::setScratchDirectory(const std::string &directory) { scratch_dir = directory; }
+void OutOfCoreLayout::setTrigMode(TrigMode mode) { trig_mode = mode; }
+uint32_t OutOfCoreLayout::getNumVertices() const { return num_vertices; }
+const std::vector<uint32_t> &OutOfCoreLayout::getCenterNodes() const { return center_nodes; }
+uint64_t OutOfCoreLayout::getPeakScratchBytes() const { return peak_scratch_bytes; }
+
+template <typename T>
+bool OutOfCoreLayout::openScratch(MappedArray<T> &array, const char *name, size_t count, std::string &error)
+{
+    if (!array.create(scratch_prefix + "." + name + ".tmp", count, true, &error))
+        return false;
+    scratch_bytes += array.bytes();
+    peak_scratch_bytes = std::max(peak_scratch_bytes, scratch_bytes);
+    return true;
+}
+
+template <typename T>
+void OutOfCoreLayout::closeScratch(MappedArray<T> &array)
+{
+    scratch_bytes -= array.bytes();
+    array.close();
+}
+
+bool OutOfCoreLayout::run(const std::string &tree_file, const std::string &out_file, std::string *error)
+{
+    namespace fs = std::filesystem;
+    num_vertices = 0;
+    center_nodes.clear();
+    scratch_bytes = peak_scratch_bytes = 0;
+    std::string directory = scratch_dir.empty() ? fs::path(out_file).parent_path().string() : scratch_dir;
+    if (directory.empty())
+        directory = ".";
+    scratch_prefix = (fs::path(directory) / fs::path(out_file).filename()).string();
+
+    std::string message;
+    MappedFile output;
+    bool ok = readAdjacency(tree_file, message) && findCenter(message) && renumberBreadthFirst(message) &&
+              computeWidths(message) &&
+              output.create(out_file, 8 + static_cast<size_t>(num_vertices) * sizeof(Point), false, &message);
+    if (ok)
+    {
+        // same header as TreeLayout::writePositions
+        char *header = static_cast<char *>(output.data());
+        memcpy(header, "RGLP", 4);
+        memcpy(header + 4, &num_vertices, sizeof(num_vertices));
+        ok = place(reinterpret_cast<Point *>(header + 8), message);
+    }
+    output.close();
+
+    closeScratch(degree);
+    closeScratch(offsets);
+    closeScratch(adjacency);
+    closeScratch(order);
+    closeScratch(first_child);
+    closeScratch(widths);
+    closeScratch(positions);
+    closeScratch(child_starts);
+    closeScratch(child_spans);
+    if (!ok && error)
+        *error = message;
+    return ok;
+}
+
+// two passes over the file, the first counts degrees so the second can put every neighbor
+// straight into its final slot. neighbor lists keep the file's order, like TreeBuilder
+bool OutOfCoreLayout::readAdjacency(const std::string &tree_file, std::string &error)
+{
+    FILE *file = fopen(tree_file.c_str(), "rb");
+    if (!file)
+    {
+        error = "cannot open " + tree_file;
+        return false;
+    }
+    NumberReader reader(file);
+    auto fail = [&](const std::string &message)
+    {
+        error = message;
+        fclose(file);
+        return false;
+    };
+
+    uint64_t n = 0;
+    if (!reader.next(n) || n < 1)
+        return fail("a tree needs at least one node");
+    // the top id is kept free as the "not numbered yet" marker
+    if (n >= UINT32_MAX)
+        return fail("trees are limited to " + std::to_string(UINT32_MAX - 1) + " nodes");
+    num_vertices = static_cast<uint32_t>(n);
+    if (!openScratch(degree, "degree", n, error))
+        return fail(error);
+
+    uint64_t num_edges = 0, u, v;
+    while (reader.next(u) && reader.next(v))
+    {
+        if (u >= n || v >= n)
+            return fail("edge " + std::to_string(u) + " " + std::to_string(v) + " uses a node id outside 0.." + std::to_string(n - 1));
+        if (u == v)
+            return fail("edge " + std::to_string(u) + " " + std::to_string(v) + " connects a node to itself");
+        if (++num_edges > n - 1)
+            return fail("more than " + std::to_string(n - 1) + " edges, so they close a cycle");
+        degree[u]++;
+        degree[v]++;
+    }
+    if (reader.failed())
+        return fail(tree_file + " has something other than node ids in it");
+    if (num_edges != n - 1)
+        return fail("a tree with " + std::to_string(n) + " nodes needs " + std::to_string(n - 1) + " edges, found " + std::to_string(num_edges));
+
+    if (!openScratch(offsets, "offsets", n + 1, error) || !openScratch(adjacency, "adjacency", 2 * num_edges, error))
+        return fail(error);
+    // degree becomes the fill cursor and counts back up to the real degree
+    offsets[0] = 0;
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        offsets[i + 1] = offsets[i] + degree[i];
+        degree[i] = 0;
+    }
+    reader.restart();
+    reader.next(n);
+    while (reader.next(u) && reader.next(v))
+    {
+        adjacency[offsets[u] + degree[u]++] = static_cast<uint32_t>(v);
+        adjacency[offsets[v] + degree[v]++] = static_cast<uint32_t>(u);
+    }
+    fclose(file);
+    return true;
+}
+
+// the same leaf trimming as TreeLayout::findCenter, with the rounds stored back to back in order
+bool OutOfCoreLayout::findCenter(std::string &error)
+{
+    center_nodes.clear();
+    uint32_t n = num_vertices;
+    if (!openScratch(order, "order", n, error))
+        return false;
+    if (n <= 2)
+    {
+        for (uint32_t i = 0; i < n; ++i)
+            center_nodes.push_back(i);
+        return true;
+    }
+
+    // every node becomes a leaf at most once, so the rounds fit in n slots
+    uint64_t begin = 0, end = 0;
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        if (degree[i] == 1)
+            order[end++] = i;
+    }
+    uint64_t remaining_nodes = n;
+    while (remaining_nodes > 2 && begin < end)
+    {
+        remaining_nodes -= end - begin;
+        uint64_t next_end = end;
+        for (uint64_t k = begin; k < end; ++k)
+        {
+            uint32_t u = order[k];
+            for (uint64_t j = offsets[u]; j < offsets[u + 1]; ++j)
+            {
+                uint32_t v = adjacency[j];
+                if (--degree[v] == 1)
+                    order[next_end++] = v;
+            }
+        }
+        begin = end;
+        end = next_end;
+    }
+    for (uint64_t k = begin; k < end; ++k)
+        center_nodes.push_back(order[k]);
+    return true;
+}
+
+// numbers the nodes breadth first from the centers, children in neighbor order. this is the
+// one pass with random reads, afterwards the original adjacency is thrown away
+bool OutOfCoreLayout::renumberBreadthFirst(std::string &error)
+{
+    uint64_t n = num_vertices;
+    const uint32_t NONE = UINT32_MAX;
+    if (!openScratch(first_child, "children", n + 1, error))
+        return false;
+
+    // degree isnt needed anymore, it becomes the map from original to new ids
+    uint32_t *new_id = degree.data();
+    std::fill(new_id, new_id + n, NONE);
+    adjacency.adviseRandom();
+    // leaf trimming on edges that arent a tree can end with no centers at all, which the
+    // count at the end catches like any other unreachable node
+    uint64_t tail = 0;
+    for (uint32_t c : center_nodes)
+    {
+        new_id[c] = static_cast<uint32_t>(tail);
+        order[tail++] = c;
+    }
+    // with two centers the second one is already numbered, so neither becomes the other's child
+    for (uint64_t i = 0; i < tail; ++i)
+    {
+        first_child[i] = static_cast<uint32_t>(tail);
+        uint32_t u = order[i];
+        for (uint64_t j = offsets[u]; j < offsets[u + 1]; ++j)
+        {
+            uint32_t v = adjacency[j];
+            if (new_id[v] == NONE)
+            {
+                new_id[v] = static_cast<uint32_t>(tail);
+                order[tail++] = v;
+            }
+        }
+    }
+    if (tail != n)
+    {
+        error = "the edges dont connect all " + std::to_string(n) + " nodes";
+        return false;
+    }
+    first_child[n] = static_cast<uint32_t>(n);
+
+    closeScratch(degree);
+    closeScratch(offsets);
+    closeScratch(adjacency);
+    return true;
+}
+
+// children always come after their parent, so one backwards sweep sums them up
+bool OutOfCoreLayout::computeWidths(std::string &error)
+{
+    uint64_t n = num_vertices;
+    if (!openScratch(widths, "widths", n, error))
+        return false;
+    for (uint64_t i = n; i-- > 0;)
+    {
+        uint32_t sum = 0;
+        for (uint32_t c = first_child[i]; c < first_child[i + 1]; ++c)
+            sum += widths[c];
+        // width of a node is how many leaves are in its subtree
+        widths[i] = sum == 0 ? 1 : sum;
+    }
+    return true;
+}
+
+static const uint32_t GROUP_SIZE = 4096;
+
+// one forward sweep: every node hands its children their positions and the part of their
+// wedges their own children split, which land further ahead in the same arrays. out is
+// written by original id
+bool OutOfCoreLayout::place(Point *out, std::string &error)
+{
+    uint64_t n = num_vertices;
+    if (!openScratch(positions, "positions", n, error) || !openScratch(child_starts, "starts", n, error) ||
+        !openScratch(child_spans, "spans", n, error))
+        return false;
+    order.adviseSequential();
+    first_child.adviseSequential();
+    widths.adviseSequential();
+    positions.adviseSequential();
+    child_starts.adviseSequential();
+    child_spans.adviseSequential();
+
+    // the centers start out exactly like calculateTrueCenterLayout places them
+    std::vector<LayoutTask> group;
+    if (center_nodes.size() == 1)
+    {
+        group.push_back({-1, -1, 0.0f, static_cast<float>(2 * M_PI), {0.0f, 0.0f}, 0.0f, 0.0f});
+        TreeLayout::computeSpans(group.data(), 1, DELTA, trig_mode);
+    }
+    else
+    {
+        group.push_back({-1, -1, static_cast<float>(3 * M_PI / 2.0), static_cast<float>(M_PI / 2.0), {0.0f, 0.0f}, 0.0f, 0.0f});
+        group.push_back({-1, -1, static_cast<float>(M_PI / 2.0), static_cast<float>(-M_PI / 2.0), {0.0f, 0.0f}, 0.0f, 0.0f});
+        TreeLayout::placeSiblings({DELTA / 2.0f, 0.0f}, &group[0], 1, DELTA, trig_mode);
+        TreeLayout::placeSiblings(group[0].pos, &group[1], 1, DELTA, trig_mode);
+    }
+    for (size_t k = 0; k < group.size(); ++k)
+    {
+        positions[k] = group[k].pos;
+        child_starts[k] = group[k].start_alpha;
+        child_spans[k] = group[k].span;
+    }
+
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        Point pos = positions[i];
+        out[order[i]] = pos;
+        uint32_t first = first_child[i], last = first_child[i + 1];
+        if (first == last)
+            continue;
+        // split the wedge among the children based on their size. a star can have most of the
+        // tree as children, so they go through in bounded groups
+        double width_before = 0.0;
+        for (uint32_t group_first = first, group_last; group_first < last; group_first = group_last)
+        {
+            group_last = group_first + std::min<uint32_t>(GROUP_SIZE, last - group_first);
+            group.clear();
+            for (uint32_t c = group_first; c < group_last; ++c)
+            {
+                float alpha1 = TreeLayout::shareStart(child_starts[i], child_spans[i], width_before, widths[i]);
+                width_before += widths[c];
+                float alpha2 = TreeLayout::shareStart(child_starts[i], child_spans[i], width_before, widths[i]);
+                group.push_back({-1, -1, alpha1, alpha2, {0.0f, 0.0f}, 0.0f, 0.0f});
+            }
+            TreeLayout::placeSiblings(pos, group.data(), group.size(), DELTA, trig_mode);
+            for (uint32_t c = group_first; c < group_last; ++c)
+            {
+                const LayoutTask &task = group[c - group_first];
+                positions[c] = task.pos;
+                child_starts[c] = task.start_alpha;
+                child_spans[c] = task.span;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,109 @@
+#include "include/radialLayout.h"
+#include "include/treeBuilder.h"
+#include "include/treeLayout.h"
+
+// the layout holds on to the tree, so the tree is rebuilt in place and never moves
+struct RadialLayoutWorkspace::State
+{
+    TreeBuilder builder;
+    Tree tree;
+    TreeLayout layout;
+
+    State() : builder(0), tree(0), layout(tree, 0, 0)
+    {
+        // callers tend to run a workspace per thread already, and threads would allocate
+        builder.setParallel(false);
+        // nobody draws a blueprint or asks for polar positions here
+        layout.setBlueprint(false);
+        layout.setCompact(true);
+    }
+};
+
+RadialLayoutWorkspace::RadialLayoutWorkspace() : state(new State()) {}
+
+RadialLayoutWorkspace::~RadialLayoutWorkspace() = default;
+
+// a negative count would reach the builder as an array size
+static bool checkNodeCount(int num_nodes, std::string *error)
+{
+    if (num_nodes >= 0)
+        return true;
+    if (error)
+        *error = "bad node count " + std::to_string(num_nodes);
+    return false;
+}
+
+bool RadialLayoutWorkspace::layoutEdges(int num_nodes, const int *edges, const RadialLayoutOptions &options, float *xy, std::string *error)
+{
+    if (!checkNodeCount(num_nodes, error))
+        return false;
+    state->builder.reset(num_nodes);
+    if (num_nodes > 1)
+        state->builder.reserve(num_nodes - 1);
+    for (int i = 0; i + 1 < num_nodes; ++i)
+        state->builder.addEdge(edges[2 * i], edges[2 * i + 1]);
+    return run(num_nodes, options, xy, error);
+}
+
+bool RadialLayoutWorkspace::layoutParents(int num_nodes, const int *parents, const RadialLayoutOptions &options, float *xy, std::string *error)
+{
+    if (!checkNodeCount(num_nodes, error))
+        return false;
+    state->builder.reset(num_nodes);
+    if (num_nodes > 1)
+        state->builder.reserve(num_nodes - 1);
+    int roots = 0;
+    for (int u = 0; u < num_nodes; ++u)
+    {
+        if (parents[u] == -1)
+            roots++;
+        else
+            state->builder.addEdge(parents[u], u);
+    }
+    // any other count is a forest or a cycle, which the builder would only call disconnected
+    if (num_nodes > 0 && roots != 1)
+    {
+        if (error)
+            *error = "the parents name " + std::to_string(roots) + " roots, a tree has exactly one";
+        return false;
+    }
+    return run(num_nodes, options, xy, error);
+}
+
+bool RadialLayoutWorkspace::run(int num_nodes, const RadialLayoutOptions &options, float *xy, std::string *error)
+{
+    if (options.root < -1 || options.root >= num_nodes)
+    {
+        if (error)
+            *error = "root " + std::to_string(options.root) + " is not a node of the tree";
+        return false;
+    }
+    if (!state->builder.build(state->tree))
+    {
+        if (error)
+            *error = state->builder.getErrorMessage();
+        return false;
+    }
+
+    // the layout writes straight into xy. nothing is collapsed and the center sits on the
+    // origin, so every node gets its final position there and nothing is copied out after
+    static_assert(sizeof(Point) == 2 * sizeof(float), "xy is filled as points");
+    TreeLayout &layout = state->layout;
+    layout.setOutput(reinterpret_cast<Point *>(xy));
+    layout.setDelta(options.delta);
+    layout.setTrigMode(options.fast_trig ? TrigMode::FAST : TrigMode::PRECISE);
+    if (options.root == -1)
+        layout.calculateTrueCenterLayout();
+    else
+        layout.calculateLayoutFromRoot(options.root);
+    // the caller's buffer is only borrowed for this call
+    layout.setOutput(nullptr);
+    if (error)
+        error->clear();
+    return true;
+}
+
+size_t RadialLayoutWorkspace::memoryUsage() const
+{
+    return state->builder.memoryUsage() + state->tree.memoryUsage() + state->layout.memoryUsage();
+}
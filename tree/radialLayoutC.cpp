@@ -0,0 +1,74 @@
+#include "include/radialLayoutC.h"
+#include "include/radialLayout.h"
+#include <new>
+#include <string>
+
+// the c side keeps the last error next to the workspace so it can hand out a plain pointer.
+// nothing may throw across the c boundary, running out of memory is just another error
+struct rgl_workspace
+{
+    RadialLayoutWorkspace workspace;
+    std::string error;
+};
+
+rgl_options rgl_default_options(void)
+{
+    RadialLayoutOptions defaults;
+    return {defaults.delta, defaults.root, defaults.fast_trig ? 1 : 0};
+}
+
+rgl_workspace *rgl_workspace_create(void)
+{
+    try
+    {
+        return new rgl_workspace();
+    }
+    catch (const std::bad_alloc &)
+    {
+        return nullptr;
+    }
+}
+
+void rgl_workspace_destroy(rgl_workspace *workspace) { delete workspace; }
+
+static RadialLayoutOptions toOptions(const rgl_options *options)
+{
+    RadialLayoutOptions out;
+    if (options)
+    {
+        out.delta = options->delta;
+        out.root = options->root;
+        out.fast_trig = options->fast_trig != 0;
+    }
+    return out;
+}
+
+int rgl_layout_edges(rgl_workspace *workspace, int num_nodes, const int *edges, const rgl_options *options, float *xy)
+{
+    try
+    {
+        return workspace->workspace.layoutEdges(num_nodes, edges, toOptions(options), xy, &workspace->error) ? 0 : 1;
+    }
+    catch (const std::bad_alloc &)
+    {
+        workspace->error = "out of memory";
+        return 1;
+    }
+}
+
+int rgl_layout_parents(rgl_workspace *workspace, int num_nodes, const int *parents, const rgl_options *options, float *xy)
+{
+    try
+    {
+        return workspace->workspace.layoutParents(num_nodes, parents, toOptions(options), xy, &workspace->error) ? 0 : 1;
+    }
+    catch (const std::bad_alloc &)
+    {
+        workspace->error = "out of memory";
+        return 1;
+    }
+}
+
+const char *rgl_last_error(const rgl_workspace *workspace) { return workspace->error.c_str(); }
+
+size_t rgl_workspace_memory(const rgl_workspace *workspace) { return workspace->workspace.memoryUsage(); }
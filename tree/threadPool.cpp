@@ -0,0 +1,65 @@
+#include "include/threadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned num_threads) : running(0), stopping(false)
+{
+    if (num_threads == 0)
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned i = 0; i < num_threads; ++i)
+        threads.emplace_back(&ThreadPool::run, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    task_ready.notify_all();
+    for (auto &thread : threads)
+        thread.join();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    task_ready.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    all_done.wait(lock, [this]
+                  { return tasks.empty() && running == 0; });
+}
+
+unsigned ThreadPool::getNumThreads() const { return static_cast<unsigned>(threads.size()); }
+
+void ThreadPool::run()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            task_ready.wait(lock, [this]
+                            { return stopping || !tasks.empty(); });
+            // finish whatever is queued before shutting down
+            if (tasks.empty())
+                return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+            running++;
+        }
+        task();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running--;
+            if (tasks.empty() && running == 0)
+                all_done.notify_all();
+        }
+    }
+}
@@ -1,66 +1,86 @@
 #include "include/tree.h"
+#include "include/treeBuilder.h"
 #include <iostream>
 #include <fstream>
 #include <vector>
 #include <ctime>
 #include <cstdlib>
 #include <chrono>
+#include <algorithm>
+#include <atomic>
 
-Tree::Tree(int n) : num_vertices(n), adj(n) {}
+Tree::Tree(int n) : id(nextId()), num_vertices(n), adjacency(std::max(n, 0) + 1, 0) {}
 
-void Tree::addEdge(int u, int v)
+int Tree::getNumVertices() const { return num_vertices; }
+
+NeighborRange Tree::getNeighbors(int u) const
 {
-    // undirected graph
-    adj[u].push_back(v);
-    adj[v].push_back(u);
+    const int *offsets = adjacency.data();
+    const int *targets = offsets + num_vertices + 1;
+    return {targets + offsets[u], targets + offsets[u + 1]};
 }
 
-int Tree::getNumVertices() const { return num_vertices; }
-
-const std::vector<std::vector<int>> &Tree::getAdjacencyList() const { return adj; }
+// each edge is stored once, so callers can index rows without building anything
+const std::vector<std::pair<int, int>> &Tree::getEdges() const { return edges; }
 
-const std::vector<int> &Tree::getNeighbors(int u) const { return adj[u]; }
+int Tree::getNumEdges() const { return static_cast<int>(edges.size()); }
+size_t Tree::memoryUsage() const { return edges.capacity() * sizeof(edges[0]) + adjacency.capacity() * sizeof(int); }
+unsigned long long Tree::getId() const { return id; }
 
-std::vector<std::pair<int, int>> Tree::getEdges() const
+// trees are built on the worker and the loader threads too
+unsigned long long Tree::nextId()
 {
-    std::vector<std::pair<int, int>> edges;
-    for (int u = 0; u < num_vertices; u++)
-    {
-        for (int v : adj[u])
-        {
-            // dont add the same edge twice
-            if (u < v)
-            {
-                edges.emplace_back(u, v);
-            }
-        }
-    }
-    return edges;
+    static std::atomic<unsigned long long> last(0);
+    return ++last;
 }
 
 // reads a tree structure from a text file
-Tree Tree::loadFromFile(const std::string &filename)
+Tree Tree::loadFromFile(const std::string &filename, std::string *error, bool allow_forest, bool parallel)
 {
     std::ifstream infile(filename);
     if (!infile)
     {
         std::cerr << "error opening file: " << filename << std::endl;
+        if (error)
+            *error = "cannot open " + filename;
         return Tree(0);
     }
 
     // the file's first line should be the number of nodes
-    int n;
+    int n = 0;
     infile >> n;
-    Tree tree(n);
+    TreeBuilder builder(n);
+    builder.setAllowForest(allow_forest);
+    builder.setParallel(parallel);
+    // the count is only a claim until the edges are read, and an edge takes at least four
+    // bytes ("u v" and a newline), so the file's size bounds what is worth reserving
+    std::streampos edges_start = infile.tellg();
+    infile.seekg(0, std::ios::end);
+    std::streamoff left = infile.tellg() - edges_start;
+    infile.seekg(edges_start);
+    if (n > 0 && left > 0)
+        builder.reserve(static_cast<size_t>(std::min<std::streamoff>(n - 1, left / 4)));
     // then it just reads pairs of nodes to connect
 
     int u, v;
     while (infile >> u >> v)
     {
-        tree.addEdge(u, v);
+        builder.addEdge(u, v);
     }
-
     infile.close();
+
+    Tree tree;
+    if (!builder.build(tree))
+    {
+        std::string message = builder.getErrorMessage();
+        // the viewer and most modes take one tree, only --forest lays out several
+        if (builder.getError() == TreeError::DISCONNECTED && !allow_forest)
+            message += ", if it is a forest --forest lays it out";
+        std::cerr << "invalid tree in " << filename << ": " << message << std::endl;
+        if (error)
+            *error = message;
+        return Tree(0);
+    }
     return tree;
 }
 
@@ -69,9 +89,10 @@ Tree Tree::generateRandom(int n)
     auto start = std::chrono::high_resolution_clock::now();
     // seed the random generator so we dont get the same tree every time
     srand(static_cast<unsigned int>(time(0)));
-    Tree tree(n);
     if (n <= 1)
-        return tree;
+        return Tree(n);
+    TreeBuilder builder(n);
+    builder.reserve(n - 1);
 
     // create a random prufer sequence
     std::vector<int> prufer(n - 2);
@@ -94,7 +115,7 @@ Tree Tree::generateRandom(int n)
         {
             if (degree[leaf] == 1)
             {
-                tree.addEdge(p_node, leaf);
+                builder.addEdge(p_node, leaf);
                 degree[p_node]--;
                 degree[leaf]--;
                 break; // move to the next node in prufer seq
@@ -114,11 +135,13 @@ Tree Tree::generateRandom(int n)
             }
             else
             {
-                tree.addEdge(u, i);
+                builder.addEdge(u, i);
                 break;
             }
         }
     }
+    Tree tree;
+    builder.build(tree);
     auto end = std::chrono::high_resolution_clock::now();
     double millis = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1e6;
     std::cout << "Random tree generation took " << millis << " ms" << std::endl;
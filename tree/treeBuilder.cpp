@@ -0,0 +1,268 @@
+#include "include/treeBuilder.h"
+#include <algorithm>
+#include <thread>
+
+// below this many edges starting threads costs more than it saves
+static const size_t PARALLEL_EDGE_THRESHOLD = 1 << 16;
+
+TreeBuilder::TreeBuilder(int n) : num_vertices(n), parent_capacity(0), parallel(true), allow_forest(false), num_components(0), error(TreeError::NONE) {}
+
+TreeBuilder::TreeBuilder(int n, std::vector<std::pair<int, int>> edge_list)
+    : num_vertices(n), edges(std::move(edge_list)), parent_capacity(0), parallel(true), allow_forest(false), num_components(0), error(TreeError::NONE) {}
+
+void TreeBuilder::reserve(size_t num_edges) { edges.reserve(num_edges); }
+
+void TreeBuilder::addEdge(int u, int v) { edges.emplace_back(u, v); }
+
+void TreeBuilder::reset(int n)
+{
+    num_vertices = n;
+    edges.clear();
+    error = TreeError::NONE;
+    error_message.clear();
+}
+
+void TreeBuilder::setParallel(bool p) { parallel = p; }
+void TreeBuilder::setAllowForest(bool allow) { allow_forest = allow; }
+
+TreeError TreeBuilder::getError() const { return error; }
+const std::string &TreeBuilder::getErrorMessage() const { return error_message; }
+int TreeBuilder::getNumComponents() const { return num_components; }
+
+size_t TreeBuilder::memoryUsage() const
+{
+    return edges.capacity() * sizeof(edges[0]) + (adjacency.capacity() + last_seen.capacity()) * sizeof(int) +
+           parent_capacity * sizeof(std::atomic<int>);
+}
+
+bool TreeBuilder::fail(TreeError e, int u, int v)
+{
+    error = e;
+    std::string edge = std::to_string(u) + " " + std::to_string(v);
+    switch (e)
+    {
+    case TreeError::BAD_NODE_COUNT:
+        error_message = "a tree needs at least one node";
+        break;
+    case TreeError::ID_OUT_OF_RANGE:
+        error_message = "edge " + edge + " uses a node id outside 0.." + std::to_string(num_vertices - 1);
+        break;
+    case TreeError::SELF_LOOP:
+        error_message = "edge " + edge + " connects a node to itself";
+        break;
+    case TreeError::DUPLICATE_EDGE:
+        error_message = "edge " + edge + " appears more than once";
+        break;
+    case TreeError::CYCLE:
+        error_message = "edge " + edge + " closes a cycle";
+        break;
+    case TreeError::DISCONNECTED:
+        error_message = "the edges leave the nodes in " + std::to_string(u) + " separate pieces";
+        break;
+    case TreeError::NONE:
+        error_message.clear();
+        break;
+    }
+    return false;
+}
+
+bool TreeBuilder::build(Tree &out)
+{
+    error = TreeError::NONE;
+    error_message.clear();
+    num_components = 0;
+    if (num_vertices < 1)
+        return fail(TreeError::BAD_NODE_COUNT, 0, 0);
+    if (!checkIds())
+        return false;
+    // too few edges cant make a tree, and a huge node count with hardly any edges shouldnt get
+    // as far as the per node arrays below
+    if (!allow_forest && edges.size() + 1 < static_cast<size_t>(num_vertices))
+    {
+        error = TreeError::DISCONNECTED;
+        error_message = std::to_string(num_vertices) + " nodes need " + std::to_string(num_vertices - 1) + " edges to make a tree, there are only " +
+                        std::to_string(edges.size());
+        return false;
+    }
+
+    buildAdjacency(adjacency);
+    if (!checkDuplicates(adjacency))
+        return false;
+    if (!checkCycles())
+        return false;
+
+    // everything checks out, normalize the edges the way Tree stores them
+    for (auto &edge : edges)
+    {
+        if (edge.first > edge.second)
+            std::swap(edge.first, edge.second);
+    }
+    // the tree may be one built before, but it isnt that tree anymore
+    out.id = Tree::nextId();
+    out.num_vertices = num_vertices;
+    out.edges.swap(edges);
+    out.adjacency.swap(adjacency);
+    edges.clear();
+    return true;
+}
+
+bool TreeBuilder::checkIds()
+{
+    for (const auto &edge : edges)
+    {
+        if (edge.first < 0 || edge.first >= num_vertices || edge.second < 0 || edge.second >= num_vertices)
+            return fail(TreeError::ID_OUT_OF_RANGE, edge.first, edge.second);
+        if (edge.first == edge.second)
+            return fail(TreeError::SELF_LOOP, edge.first, edge.second);
+    }
+    return true;
+}
+
+// counting sort of the edge endpoints into one vector: n + 1 offsets, then the neighbors
+void TreeBuilder::buildAdjacency(std::vector<int> &adjacency) const
+{
+    int n = num_vertices;
+    adjacency.assign(n + 1 + 2 * edges.size(), 0);
+    int *offsets = adjacency.data();
+    int *targets = offsets + n + 1;
+
+    for (const auto &edge : edges)
+    {
+        offsets[edge.first]++;
+        offsets[edge.second]++;
+    }
+    // turn the degrees into end offsets, then fill backwards so each end becomes a start
+    for (int u = 1; u < n; ++u)
+        offsets[u] += offsets[u - 1];
+    offsets[n] = static_cast<int>(2 * edges.size());
+    // walking the edges in reverse keeps every neighbor list in insertion order
+    for (size_t i = edges.size(); i-- > 0;)
+    {
+        int u = edges[i].first, v = edges[i].second;
+        targets[--offsets[u]] = v;
+        targets[--offsets[v]] = u;
+    }
+}
+
+bool TreeBuilder::checkDuplicates(const std::vector<int> &adjacency)
+{
+    int n = num_vertices;
+    const int *offsets = adjacency.data();
+    const int *targets = offsets + n + 1;
+    // last_seen[v] == u means we already saw v in u's list
+    last_seen.assign(n, -1);
+    for (int u = 0; u < n; ++u)
+    {
+        for (int i = offsets[u]; i < offsets[u + 1]; ++i)
+        {
+            int v = targets[i];
+            if (last_seen[v] == u)
+                return fail(TreeError::DUPLICATE_EDGE, std::min(u, v), std::max(u, v));
+            last_seen[v] = u;
+        }
+    }
+    return true;
+}
+
+// roots only ever link under a smaller id and path halving only moves pointers up,
+// so the parent pointers can never form a loop even with several threads at once
+int TreeBuilder::find(int x)
+{
+    while (true)
+    {
+        int p = parent[x].load(std::memory_order_acquire);
+        if (p == x)
+            return x;
+        int gp = parent[p].load(std::memory_order_acquire);
+        if (gp != p)
+            parent[x].compare_exchange_weak(p, gp, std::memory_order_release, std::memory_order_relaxed);
+        x = gp;
+    }
+}
+
+// returns false if a and b were already connected, which means the edge closes a cycle
+bool TreeBuilder::unite(int a, int b)
+{
+    while (true)
+    {
+        a = find(a);
+        b = find(b);
+        if (a == b)
+            return false;
+        if (a < b)
+            std::swap(a, b);
+        int expected = a;
+        if (parent[a].compare_exchange_strong(expected, b, std::memory_order_acq_rel))
+            return true;
+    }
+}
+
+bool TreeBuilder::checkCycles()
+{
+    int n = num_vertices;
+    if (static_cast<size_t>(n) > parent_capacity)
+    {
+        // a one off build shouldnt hold both at once, a reused builder gets to keep both
+        // from its second build on
+        std::vector<int>().swap(last_seen);
+        parent.reset(new std::atomic<int>[n]);
+        parent_capacity = n;
+    }
+    for (int i = 0; i < n; ++i)
+        parent[i].store(i, std::memory_order_relaxed);
+
+    std::atomic<long long> bad_edge(-1);
+    std::atomic<int> merges(0);
+    auto work = [&](size_t begin, size_t end)
+    {
+        int local_merges = 0;
+        for (size_t i = begin; i < end && bad_edge.load(std::memory_order_relaxed) == -1; ++i)
+        {
+            if (unite(edges[i].first, edges[i].second))
+            {
+                local_merges++;
+            }
+            else
+            {
+                long long none = -1;
+                bad_edge.compare_exchange_strong(none, static_cast<long long>(i));
+            }
+        }
+        merges += local_merges;
+    };
+
+    size_t num_threads = 1;
+    if (parallel && edges.size() >= PARALLEL_EDGE_THRESHOLD)
+    {
+        size_t hw = std::max(1u, std::thread::hardware_concurrency());
+        num_threads = std::min(hw, edges.size() / PARALLEL_EDGE_THRESHOLD);
+    }
+    if (num_threads <= 1)
+    {
+        work(0, edges.size());
+    }
+    else
+    {
+        std::vector<std::thread> threads;
+        size_t chunk = (edges.size() + num_threads - 1) / num_threads;
+        for (size_t t = 0; t < num_threads; ++t)
+        {
+            size_t begin = t * chunk;
+            size_t end = std::min(edges.size(), begin + chunk);
+            threads.emplace_back(work, begin, end);
+        }
+        for (auto &thread : threads)
+            thread.join();
+    }
+
+    if (bad_edge != -1)
+    {
+        const auto &edge = edges[bad_edge];
+        return fail(TreeError::CYCLE, edge.first, edge.second);
+    }
+    // every successful union joins two pieces, a tree needs exactly n - 1 of them
+    if (merges != n - 1 && !allow_forest)
+        return fail(TreeError::DISCONNECTED, n - merges, 0);
+    num_components = n - merges;
+    return true;
+}
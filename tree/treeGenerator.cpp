@@ -0,0 +1,205 @@
+#include "include/treeGenerator.h"
+#include "include/treeBuilder.h"
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <vector>
+
+static const char *FAMILY_NAMES[] = {
+    "uniform", "path", "caterpillar", "star", "kary", "recursive", "preferential", "broom", "spider"};
+
+const char *TreeGenerator::familyName(TreeFamily family)
+{
+    return FAMILY_NAMES[static_cast<int>(family)];
+}
+
+bool TreeGenerator::parseFamily(const std::string &name, TreeFamily &family)
+{
+    for (int i = 0; i < static_cast<int>(TreeFamily::COUNT); ++i)
+    {
+        if (name == FAMILY_NAMES[i])
+        {
+            family = static_cast<TreeFamily>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TreeGenerator::forEachEdge(const GeneratorParams &params, const std::function<void(int, int)> &emit)
+{
+    int n = params.num_nodes;
+    if (n <= 1)
+        return;
+    std::mt19937_64 rng(params.seed);
+    // picks a number in [0, bound)
+    auto pick = [&rng](int bound)
+    { return static_cast<int>(rng() % static_cast<unsigned long long>(bound)); };
+
+    switch (params.family)
+    {
+    case TreeFamily::UNIFORM:
+    {
+        // linear time prufer decoding, the pointer only ever moves forward
+        std::vector<int> prufer(n - 2);
+        std::vector<int> degree(n, 1);
+        for (int &node : prufer)
+        {
+            node = pick(n);
+            degree[node]++;
+        }
+        int ptr = 0;
+        while (degree[ptr] != 1)
+            ptr++;
+        int leaf = ptr;
+        for (int v : prufer)
+        {
+            emit(v, leaf);
+            if (--degree[v] == 1 && v < ptr)
+            {
+                leaf = v;
+            }
+            else
+            {
+                ptr++;
+                while (degree[ptr] != 1)
+                    ptr++;
+                leaf = ptr;
+            }
+        }
+        emit(n - 1, leaf);
+        break;
+    }
+    case TreeFamily::PATH:
+        for (int i = 1; i < n; ++i)
+            emit(i - 1, i);
+        break;
+    case TreeFamily::CATERPILLAR:
+    {
+        int spine = params.param > 0 ? std::min(params.param, n) : std::max(1, n / 2);
+        for (int i = 1; i < spine; ++i)
+            emit(i - 1, i);
+        for (int i = spine; i < n; ++i)
+            emit(pick(spine), i);
+        break;
+    }
+    case TreeFamily::STAR:
+        for (int i = 1; i < n; ++i)
+            emit(0, i);
+        break;
+    case TreeFamily::KARY:
+    {
+        int k = params.param > 0 ? params.param : 2;
+        for (int i = 1; i < n; ++i)
+            emit((i - 1) / k, i);
+        break;
+    }
+    case TreeFamily::RANDOM_RECURSIVE:
+        for (int i = 1; i < n; ++i)
+            emit(pick(i), i);
+        break;
+    case TreeFamily::PREFERENTIAL:
+    {
+        // every edge endpoint is a ticket, so a node is picked proportional to its degree
+        std::vector<int> endpoints;
+        endpoints.reserve(2 * static_cast<size_t>(n));
+        emit(0, 1);
+        endpoints.push_back(0);
+        endpoints.push_back(1);
+        for (int i = 2; i < n; ++i)
+        {
+            int parent = endpoints[pick(static_cast<int>(endpoints.size()))];
+            emit(parent, i);
+            endpoints.push_back(parent);
+            endpoints.push_back(i);
+        }
+        break;
+    }
+    case TreeFamily::BROOM:
+    {
+        int handle = params.param > 0 ? std::min(params.param, n) : std::max(1, n / 2);
+        for (int i = 1; i < handle; ++i)
+            emit(i - 1, i);
+        for (int i = handle; i < n; ++i)
+            emit(handle - 1, i);
+        break;
+    }
+    case TreeFamily::SPIDER:
+    {
+        int legs = params.param > 0 ? params.param : std::max(1, static_cast<int>(std::sqrt(n)));
+        // hand out nodes round robin so all legs end up the same length
+        for (int i = 1; i < n; ++i)
+            emit(i <= legs ? 0 : i - legs, i);
+        break;
+    }
+    case TreeFamily::COUNT:
+        break;
+    }
+}
+
+Tree TreeGenerator::generate(const GeneratorParams &params)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    if (params.num_nodes <= 1)
+        return Tree(params.num_nodes);
+    TreeBuilder builder(params.num_nodes);
+    builder.reserve(params.num_nodes - 1);
+    forEachEdge(params, [&builder](int u, int v)
+                { builder.addEdge(u, v); });
+    Tree tree;
+    if (!builder.build(tree))
+    {
+        std::cerr << "generator produced an invalid tree: " << builder.getErrorMessage() << std::endl;
+        return Tree(0);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double millis = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1e6;
+    std::cout << "Generating " << familyName(params.family) << " tree took " << millis << " ms" << std::endl;
+    return tree;
+}
+
+bool TreeGenerator::writeToFile(const GeneratorParams &params, const std::string &filename, std::string *error)
+{
+    FILE *file = fopen(filename.c_str(), "wb");
+    if (!file)
+    {
+        if (error)
+            *error = "cannot open " + filename + " for writing";
+        return false;
+    }
+
+    // format straight into a fixed buffer and flush it whenever it fills up
+    static const size_t BUFFER_SIZE = 1 << 20;
+    std::vector<char> buffer(BUFFER_SIZE);
+    size_t used = 0;
+    auto flush = [&]()
+    {
+        fwrite(buffer.data(), 1, used, file);
+        used = 0;
+    };
+    auto writeInt = [&](int value, char separator)
+    {
+        if (BUFFER_SIZE - used < 16)
+            flush();
+        char *begin = buffer.data() + used;
+        char *end = std::to_chars(begin, begin + 12, value).ptr;
+        *end++ = separator;
+        used += end - begin;
+    };
+
+    writeInt(params.num_nodes, '\n');
+    forEachEdge(params, [&](int u, int v)
+                {
+        writeInt(u, ' ');
+        writeInt(v, '\n'); });
+    flush();
+
+    bool ok = !ferror(file);
+    ok = (fclose(file) == 0) && ok;
+    if (!ok && error)
+        *error = "failed writing " + filename;
+    return ok;
+}
@@ -1,16 +1,31 @@
 #include "include/treeLayout.h"
+#include "include/fastTrig.h"
+#include "include/layoutEngine.h"
 #include <numeric>
 #include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cfloat>
 
-TreeLayout::TreeLayout(const Tree &tree, const int halfwidth, const int halfheight) : tree_ref(tree), DELTA(50.0f), halfwidth(halfwidth), halfheight(halfheight)
+// smaller subtrees are cheaper to place than to look up
+static const int SHARED_MIN_SIZE = 8;
+// how much the spans and radii of siblings with equal widths differ, the float error of
+// their shares and how far the middle one sits out past the others
+static const float SPAN_NOISE = 1e-3f;
+
+TreeLayout::TreeLayout(const Tree &tree, const int halfwidth, const int halfheight, float delta) : tree_ref(tree), DELTA(delta), halfwidth(halfwidth), halfheight(halfheight), trig_mode(TrigMode::PRECISE), share_subtrees(false), compact(false), blueprint(true), style(LayoutStyle::RADIAL), double_precision(false), output_positions(nullptr), root_position({0.0f, 0.0f}), copy_budget(0), progress(nullptr), pending_steps(0), cancelled(false), ring_pos(0), completed_nodes(0), completed_depth(0), complete(true)
 {
     int n = tree.getNumVertices();
     target_positions.resize(n, {static_cast<float>(halfwidth), static_cast<float>(halfheight)});
     widths.resize(n, 0);
-    depths.resize(n, 0);
+    depths.reset(n, false);
     parent_map.resize(n, -1);
+    preorder_index.resize(n, -1);
+    subtree_sizes.resize(n, 0);
+    node_wedges.resize(n, {0.0f, 0.0f});
     max_depth = 0;
 }
 
@@ -18,27 +33,518 @@ TreeLayout::TreeLayout(const Tree &tree, const int halfwidth, const int halfheig
 void TreeLayout::resetLayoutState()
 {
     int n = tree_ref.getNumVertices();
+    // the tree may have been rebuilt in place since the last calculation, so follow its size.
+    // none of this allocates when the size stays the same
+    if (output_positions)
+        std::vector<Point>().swap(target_positions);
+    else
+        target_positions.resize(n, {static_cast<float>(halfwidth), static_cast<float>(halfheight)});
+    std::vector<uint32_t>().swap(edge_directions);
+    widths.resize(n, 0);
+    subtree_sizes.resize(n, 0);
     parent_map.assign(n, -1);
+    preorder_index.assign(n, -1);
+    preorder_nodes.clear();
+    preorder_nodes.reserve(n);
+    depths.reset(n, compact);
+    // a compact layout works the polar positions out when asked and draws no wedges
+    if (compact)
+    {
+        std::vector<AngleRange>().swap(node_wedges);
+        std::vector<PolarPoint>().swap(polar_positions);
+        std::vector<Wedge>().swap(framework_wedges);
+        std::vector<FrameworkRing>().swap(framework_rings);
+    }
+    else
+    {
+        node_wedges.resize(n, {0.0f, 0.0f});
+        polar_positions.resize(n, {0.0f, 0.0f});
+    }
     max_depth = 0;
     framework_circles.clear();
     framework_wedges.clear();
+    framework_rings.clear();
     pruning_generations.clear();
+    shape_keys.clear();
+    shape_starts.assign(1, 0);
+    shape_counts.clear();
+    shared_subtrees.clear();
+    // the engines have no use for the shapes
+    if (share_subtrees && !usesEngine())
+    {
+        shape_ids.assign(n, -1);
+        shape_slots.assign(std::max<size_t>(shape_slots.size(), 1024), -1);
+    }
+    else
+    {
+        std::vector<int>().swap(shape_ids);
+        std::vector<int>().swap(shape_slots);
+        std::vector<int>().swap(shape_sources);
+        std::vector<float>().swap(source_spans);
+    }
+    pending_steps = 0;
+    cancelled = false;
+    // a full calculation replaces any progressive one still running
+    ring.clear();
+    next_ring.clear();
+    ring_pos = 0;
+    placed_nodes.clear();
+    completed_nodes = 0;
+    completed_depth = 0;
+    complete = true;
+}
+
+void TreeLayout::setProgress(LayoutProgress *p) { progress = p; }
+bool TreeLayout::wasCancelled() const { return cancelled; }
+
+size_t TreeLayout::memoryUsage(std::vector<MemoryItem> *report) const
+{
+    auto bytes = [](const auto &v)
+    { return v.capacity() * sizeof(v[0]); };
+    size_t total = 0;
+    auto add = [&](const char *name, size_t part)
+    {
+        total += part;
+        if (report)
+            report->push_back({name, part});
+    };
+    add("positions", bytes(target_positions));
+    add("quantized positions", bytes(edge_directions));
+    add("polar positions", bytes(polar_positions));
+    add("widths", bytes(widths));
+    add("depths", depths.memoryUsage());
+    add("parents", bytes(parent_map));
+    add("pre-order", bytes(preorder_index) + bytes(preorder_nodes) + bytes(subtree_sizes));
+    add("wedges", bytes(node_wedges));
+    add("blueprint", bytes(framework_wedges) + bytes(framework_rings) + bytes(framework_circles));
+    add("centers and collapsed", bytes(center_nodes) + bytes(true_center_nodes) + bytes(collapsed));
+    add("progressive", bytes(ring) + bytes(next_ring) + bytes(placed_nodes));
+    add("scratch", bytes(width_stack) + bytes(child_shapes_stack) + bytes(place_stack));
+    add("shared subtrees", bytes(shape_ids) + bytes(shape_counts) + bytes(shape_keys) + bytes(shape_starts) + bytes(shape_slots) +
+                               bytes(shape_sources) + bytes(source_spans) + bytes(shared_subtrees));
+    size_t pruning = bytes(prune_generation);
+    for (const auto &generation : pruning_generations)
+        pruning += bytes(generation);
+    add("center finding", pruning);
+    return total;
+}
+
+bool TreeLayout::writePositions(const std::string &filename, bool csv, std::string *error) const
+{
+    if (edge_directions.empty())
+        return writePositions(filename, target_positions, csv, error);
+    std::vector<Point> positions;
+    decodeTargetPositions(positions);
+    return writePositions(filename, positions, csv, error);
+}
+
+bool TreeLayout::writePositions(const std::string &filename, const std::vector<Point> &positions, bool csv, std::string *error)
+{
+    FILE *file = fopen(filename.c_str(), "wb");
+    if (!file)
+    {
+        if (error)
+            *error = "cannot open " + filename + " for writing";
+        return false;
+    }
+    if (csv)
+    {
+        // format into a fixed buffer and flush it whenever it fills up
+        static const size_t BUFFER_SIZE = 1 << 20;
+        std::vector<char> buffer(BUFFER_SIZE);
+        size_t used = 0;
+        fputs("node,x,y\n", file);
+        for (size_t i = 0; i < positions.size(); ++i)
+        {
+            if (BUFFER_SIZE - used < 64)
+            {
+                fwrite(buffer.data(), 1, used, file);
+                used = 0;
+            }
+            used += snprintf(buffer.data() + used, BUFFER_SIZE - used, "%d,%.7g,%.7g\n",
+                             static_cast<int>(i), positions[i].x, positions[i].y);
+        }
+        fwrite(buffer.data(), 1, used, file);
+    }
+    else
+    {
+        uint32_t count = static_cast<uint32_t>(positions.size());
+        fwrite("RGLP", 1, 4, file);
+        fwrite(&count, sizeof(count), 1, file);
+        fwrite(positions.data(), sizeof(Point), positions.size(), file);
+    }
+    bool ok = !ferror(file);
+    ok = (fclose(file) == 0) && ok;
+    if (!ok && error)
+        *error = "failed writing " + filename;
+    return ok;
+}
+
+// reports progress every few nodes and tells the caller if it should give up
+bool TreeLayout::checkpoint()
+{
+    if (!progress)
+        return false;
+    if (++pending_steps < 1024)
+        return cancelled;
+    progress->nodes_done.fetch_add(pending_steps, std::memory_order_relaxed);
+    pending_steps = 0;
+    cancelled = progress->cancelled.load(std::memory_order_relaxed);
+    return cancelled;
 }
 
 void TreeLayout::finalizeLayout()
 {
+    sortFrameworkCircles();
+    // hidden nodes were never laid out, so only the visible ones count
     max_depth = 0;
-    for (int d : depths)
+    for (int u : preorder_nodes)
     {
-        if (d > max_depth)
-            max_depth = d;
+        if (depths[u] > max_depth)
+            max_depth = depths[u];
     }
+    storePolar(preorder_nodes.data(), preorder_nodes.size());
     // shifts the whole tree to the center of the screen
-    for (size_t i = 0; i < target_positions.size(); ++i)
+    Point *positions = targets();
+    for (int u : preorder_nodes)
+    {
+        positions[u].x += halfwidth;
+        positions[u].y += halfheight;
+    }
+    // an outside buffer is the caller's and a workspace runs again without allocating, so
+    // only a layout of its own lets go of what it only needed while laying out
+    if (compact && !output_positions)
+    {
+        if (!usesEngine())
+            quantizePositions();
+        std::vector<int>().swap(subtree_sizes);
+        // far fewer distinct rings than nodes, a compact layout gives the room back
+        framework_circles.shrink_to_fit();
+    }
+}
+
+const float *TreeLayout::directionSines()
+{
+    static const std::vector<float> sines = []()
+    {
+        std::vector<float> table(65536);
+        for (int q = 0; q < 65536; ++q)
+            table[q] = static_cast<float>(std::sin(q * (2 * M_PI / 65536)));
+        return table;
+    }();
+    return sines.data();
+}
+
+// every edge of the radial layout is delta long, so the direction from the parent is all a
+// node needs. it is taken from the parent as it will be decoded, which comes first in
+// pre-order, so the rounding of one edge is made up for by the next instead of adding up down
+// a path. 32 bits keep the direction finer than a float angle could, 16 would be coarser than
+// the shares of siblings in a wide fan out and swap them. what is left is the float error of
+// the edge lengths, which adds up to a hundredth of a pixel or so down a long path
+void TreeLayout::quantizePositions()
+{
+    if (preorder_nodes.empty())
+        return;
+    const double steps = 4294967296.0 / (2 * M_PI);
+    edge_directions.assign(tree_ref.getNumVertices(), 0);
+    root_position = target_positions[preorder_nodes[0]];
+    for (size_t i = 1; i < preorder_nodes.size(); ++i)
+    {
+        int u = preorder_nodes[i];
+        Point parent_pos = target_positions[parent_map[u]];
+        double angle = std::atan2(target_positions[u].y - parent_pos.y, target_positions[u].x - parent_pos.x);
+        // the cast wraps a half turn either way around to the same direction
+        edge_directions[u] = static_cast<uint32_t>(std::llround(angle * steps));
+        Point step = edgeStep(u);
+        target_positions[u] = {parent_pos.x + step.x, parent_pos.y + step.y};
+    }
+    std::vector<Point>().swap(target_positions);
+}
+
+bool TreeLayout::hasQuantizedPositions() const { return !edge_directions.empty(); }
+
+Point TreeLayout::getTargetPosition(int u) const
+{
+    if (edge_directions.empty())
+        return targets()[u];
+    std::vector<Point> steps;
+    return quantizedTarget(u, steps);
+}
+
+// floats dont add up the same in another order, and down a long path that comes to a pixel,
+// so the edges are added from the center down just like decodeTargetPositions does
+Point TreeLayout::quantizedTarget(int u, std::vector<Point> &steps) const
+{
+    if (preorder_index[u] < 0)
+        return {static_cast<float>(halfwidth), static_cast<float>(halfheight)};
+    steps.clear();
+    for (int root = preorder_nodes[0]; u != root; u = parent_map[u])
+        steps.push_back(edgeStep(u));
+    Point pos = root_position;
+    for (size_t i = steps.size(); i-- > 0;)
+        pos = {pos.x + steps[i].x, pos.y + steps[i].y};
+    return pos;
+}
+
+void TreeLayout::decodeTargetPositions(std::vector<Point> &out) const
+{
+    if (edge_directions.empty())
+    {
+        out = target_positions;
+        return;
+    }
+    out.assign(tree_ref.getNumVertices(), {static_cast<float>(halfwidth), static_cast<float>(halfheight)});
+    out[preorder_nodes[0]] = root_position;
+    for (size_t i = 1; i < preorder_nodes.size(); ++i)
+    {
+        int u = preorder_nodes[i];
+        Point parent_pos = out[parent_map[u]], step = edgeStep(u);
+        out[u] = {parent_pos.x + step.x, parent_pos.y + step.y};
+    }
+}
+
+int TreeLayout::getSubtreeSize(int u) const
+{
+    if (!subtree_sizes.empty())
+        return subtree_sizes[u];
+    int first = preorder_index[u];
+    if (first < 0)
+        return 0;
+    int depth = depths[u];
+    size_t i = first + 1;
+    while (i < preorder_nodes.size() && depths[preorder_nodes[i]] > depth)
+        ++i;
+    return static_cast<int>(i) - first;
+}
+
+// radius and angle of the nodes about the center, from their still unshifted positions.
+// a few hundred at a time go through the trig together, so fast mode can use its kernel
+void TreeLayout::storePolar(const int *nodes, size_t count)
+{
+    if (polar_positions.empty())
+        return;
+    const Point *positions = targets();
+    const size_t CHUNK = 256;
+    float xs[CHUNK], ys[CHUNK], angles[CHUNK];
+    for (size_t start = 0; start < count; start += CHUNK)
+    {
+        size_t n = std::min(CHUNK, count - start);
+        for (size_t i = 0; i < n; ++i)
+        {
+            xs[i] = positions[nodes[start + i]].x;
+            ys[i] = positions[nodes[start + i]].y;
+        }
+        if (trig_mode == TrigMode::FAST)
+        {
+            fastAtan2(ys, xs, angles, n);
+        }
+        else
+        {
+            for (size_t i = 0; i < n; ++i)
+                angles[i] = std::atan2(ys[i], xs[i]);
+        }
+        for (size_t i = 0; i < n; ++i)
+            polar_positions[nodes[start + i]] = {std::sqrt(xs[i] * xs[i] + ys[i] * ys[i]), angles[i]};
+    }
+}
+
+void TreeLayout::setCollapsed(std::vector<char> collapsed_nodes) { collapsed = std::move(collapsed_nodes); }
+const std::vector<char> &TreeLayout::getCollapsed() const { return collapsed; }
+bool TreeLayout::isCollapsed(int u) const { return !collapsed.empty() && collapsed[u]; }
+
+void TreeLayout::toggleCollapsed(int u)
+{
+    int first = preorder_index[u];
+    // hidden nodes cant be clicked, and the centers always stay open
+    if (first < 0 || std::find(center_nodes.begin(), center_nodes.end(), u) != center_nodes.end())
+        return;
+    if (collapsed.empty())
+        collapsed.assign(tree_ref.getNumVertices(), 0);
+    cancelled = false;
+    if (usesEngine() || node_wedges.empty())
+    {
+        // the other engines push every subtree against its neighbors, so one growing or
+        // shrinking moves the rest too, and a compact layout has no wedges to lay u out in
+        // again. the old layout is gone once the state is reset, so theres nothing to go back
+        // to and this one always runs to the end
+        collapsed[u] = !collapsed[u];
+        LayoutProgress *saved_progress = progress;
+        progress = nullptr;
+        resetLayoutState();
+        layoutCenters();
+        finalizeLayout();
+        progress = saved_progress;
+        return;
+    }
+
+    int p = parent_map[u];
+    int old_size = subtree_sizes[u];
+    int old_width = widths[u];
+    // copies that contain u or sit below it dont match their source anymore, and neither do
+    // copies of a source that does
+    auto touched = [&](int x)
+    {
+        int x_first = preorder_index[x];
+        return x_first < first + old_size && first < x_first + subtree_sizes[x];
+    };
+    // a cancelled expand puts these back, so the layout never holds half a subtree
+    std::vector<SharedSubtree> old_shared;
+    if (collapsed[u])
+        old_shared = shared_subtrees;
+    shared_subtrees.erase(std::remove_if(shared_subtrees.begin(), shared_subtrees.end(), [&](const SharedSubtree &shared)
+                                         { return touched(shared.root) || touched(shared.source); }),
+                          shared_subtrees.end());
+    if (!collapsed[u])
+    {
+        // drop everything below u from the numbering, its positions are just left behind
+        collapsed[u] = 1;
+        for (int i = first + 1; i < first + old_size; ++i)
+            preorder_index[preorder_nodes[i]] = -1;
+        preorder_nodes.erase(preorder_nodes.begin() + first + 1, preorder_nodes.begin() + first + old_size);
+        subtree_sizes[u] = 1;
+        widths[u] = 1;
+        // everything after u moved along in the numbering
+        for (size_t i = first; i < preorder_nodes.size(); ++i)
+            preorder_index[preorder_nodes[i]] = static_cast<int>(i);
+    }
+    else
+    {
+        collapsed[u] = 0;
+        // layoutSubTree works around the origin, so hand it the exact unshifted positions
+        // of the two nodes it reads and shift everything it wrote afterwards
+        std::vector<Point> local = localPositions();
+        Point parent_pos = targets()[p];
+        Point u_pos = targets()[u];
+        targets()[p] = local[preorder_index[p]];
+        targets()[u] = local[first];
+
+        // number u's subtree on its own, then splice it in where u was
+        std::vector<int> outer, revealed;
+        outer.swap(preorder_nodes);
+        // back to how it was before the click, u collapsed again. whatever was written below
+        // u is hidden once more, so only the numbering and u's own counts need undoing
+        auto undo = [&]()
+        {
+            for (int v : revealed)
+                preorder_index[v] = -1;
+            preorder_nodes.swap(outer);
+            for (size_t i = first; i < preorder_nodes.size(); ++i)
+                preorder_index[preorder_nodes[i]] = static_cast<int>(i);
+            collapsed[u] = 1;
+            subtree_sizes[u] = old_size;
+            widths[u] = old_width;
+            targets()[p] = parent_pos;
+            targets()[u] = u_pos;
+            shared_subtrees.swap(old_shared);
+        };
+        computeWidthsAndDepths(u, p, depths[u]);
+        revealed.swap(preorder_nodes);
+        if (cancelled)
+        {
+            undo();
+            return;
+        }
+        preorder_nodes.reserve(outer.size() + revealed.size() - 1);
+        preorder_nodes.insert(preorder_nodes.end(), outer.begin(), outer.begin() + first);
+        preorder_nodes.insert(preorder_nodes.end(), revealed.begin(), revealed.end());
+        preorder_nodes.insert(preorder_nodes.end(), outer.begin() + first + 1, outer.end());
+        // renumber before laying out, copying a subtree finds its nodes by their index
+        for (size_t i = first; i < preorder_nodes.size(); ++i)
+            preorder_index[preorder_nodes[i]] = static_cast<int>(i);
+
+        // the old sources may have moved or been hidden since
+        resetShapeSources();
+        layoutSubTree(u, p, node_wedges[u].alpha1, node_wedges[u].alpha2);
+        if (cancelled)
+        {
+            undo();
+            return;
+        }
+        Point *positions = targets();
+        positions[p] = parent_pos;
+        storePolar(revealed.data(), revealed.size());
+        for (int v : revealed)
+        {
+            positions[v].x += halfwidth;
+            positions[v].y += halfheight;
+        }
+    }
+
+    // the ancestors keep their wedges, only their counts change
+    int size_change = subtree_sizes[u] - old_size;
+    int width_change = widths[u] - old_width;
+    for (int a = p; a != -1; a = parent_map[a])
+    {
+        subtree_sizes[a] += size_change;
+        widths[a] += width_change;
+        // with two centers they are each other's parents, so stop at the first one
+        if (std::find(center_nodes.begin(), center_nodes.end(), a) != center_nodes.end())
+            break;
+    }
+
+    max_depth = 0;
+    for (int v : preorder_nodes)
+    {
+        if (depths[v] > max_depth)
+            max_depth = depths[v];
+    }
+    rebuildFramework();
+}
+
+// positions around the origin by pre-order index. subtracting the screen offset would
+// round differently, so they are replayed from the centers with the same math layoutSubTree uses
+std::vector<Point> TreeLayout::localPositions() const
+{
+    std::vector<Point> local(preorder_nodes.size());
+    if (local.empty())
+        return local;
+    // the first node is a center. with two centers it is placed off the second one's starting
+    // spot, then the second one off it like any other node
+    if (center_nodes.size() == 2)
+        local[0] = positionFromParent({DELTA / 2.0f, 0.0f}, node_wedges[preorder_nodes[0]], DELTA, trig_mode);
+    else
+        local[0] = {0.0f, 0.0f};
+    // parents always come first in pre-order
+    for (size_t i = 1; i < preorder_nodes.size(); ++i)
+    {
+        int u = preorder_nodes[i];
+        local[i] = positionFromParent(local[preorder_index[parent_map[u]]], node_wedges[u], DELTA, trig_mode);
+    }
+    return local;
+}
+
+// recomputes the blueprint from the visible nodes and the wedges they were given
+void TreeLayout::rebuildFramework()
+{
+    framework_circles.clear();
+    framework_wedges.clear();
+    if (!blueprint)
+        return;
+    std::vector<Point> local = localPositions();
+    bool wedges = recording() == FrameworkRecording::ALL;
+    int other_center = center_nodes.size() == 2 ? center_nodes[1] : -1;
+    for (size_t i = 0; i < preorder_nodes.size(); ++i)
     {
-        target_positions[i].x += halfwidth;
-        target_positions[i].y += halfheight;
+        int u = preorder_nodes[i];
+        float layout_radius = sqrt(local[i].x * local[i].x + local[i].y * local[i].y);
+        framework_circles.push_back(layout_radius + DELTA);
+        // the first node is always a center
+        if (!wedges || i == 0 || u == other_center)
+            continue;
+        int p = parent_map[u];
+        Point parent_pos = local[preorder_index[p]];
+        float parent_radius = sqrt(parent_pos.x * parent_pos.x + parent_pos.y * parent_pos.y);
+        framework_wedges.push_back({parent_pos, parent_radius + DELTA, node_wedges[u].alpha1, node_wedges[u].alpha2});
     }
+    sortFrameworkCircles();
+}
+
+// the rings are pushed once per node as it is placed, so they are sorted and the repeats
+// dropped once the layout is done instead of keeping a set node per node
+void TreeLayout::sortFrameworkCircles()
+{
+    std::sort(framework_circles.begin(), framework_circles.end());
+    framework_circles.erase(std::unique(framework_circles.begin(), framework_circles.end()), framework_circles.end());
 }
 
 void TreeLayout::calculateTrueCenterLayout()
@@ -46,29 +552,193 @@ void TreeLayout::calculateTrueCenterLayout()
     resetLayoutState();
     findCenter();
     true_center_nodes = center_nodes;
+    layoutCenters();
+    finalizeLayout();
+}
+
+void TreeLayout::layoutCenters()
+{
+    if (usesEngine())
+    {
+        layoutWithEngine();
+        return;
+    }
     if (center_nodes.size() == 1)
     {
         int root = center_nodes[0];
         computeWidthsAndDepths(root, -1, 0);
-        target_positions[root] = {0.0f, 0.0f};
+        targets()[root] = {0.0f, 0.0f};
+        resetShapeSources();
         layoutSubTree(root, -1, 0.0f, 2 * M_PI);
     }
     else if (center_nodes.size() == 2)
     {
         int u = center_nodes[0];
         int v = center_nodes[1];
-        target_positions[u] = {-DELTA / 2.0f, 0.0f};
-        target_positions[v] = {DELTA / 2.0f, 0.0f};
+        targets()[u] = {-DELTA / 2.0f, 0.0f};
+        targets()[v] = {DELTA / 2.0f, 0.0f};
         parent_map[v] = u;
         parent_map[u] = v;
         computeWidthsAndDepths(u, v, 0);
         computeWidthsAndDepths(v, u, 0);
+        // one center's subtrees can be copied from the other's
+        resetShapeSources();
         layoutSubTree(u, v, 3 * M_PI / 2.0, M_PI / 2.0);
         layoutSubTree(v, u, M_PI / 2.0, -M_PI / 2.0);
     }
-    finalizeLayout();
 }
 
+bool TreeLayout::usesEngine() const { return style != LayoutStyle::RADIAL || double_precision; }
+
+// the same walk as the radial pass numbers and measures the tree, then the engine places
+// every node from the pre-order it left behind
+void TreeLayout::layoutWithEngine()
+{
+    if (center_nodes.empty())
+        return;
+    int u = center_nodes[0];
+    size_t second_center;
+    if (center_nodes.size() == 1)
+    {
+        computeWidthsAndDepths(u, -1, 0);
+        second_center = preorder_nodes.size();
+    }
+    else
+    {
+        int v = center_nodes[1];
+        parent_map[v] = u;
+        parent_map[u] = v;
+        computeWidthsAndDepths(u, v, 0);
+        second_center = preorder_nodes.size();
+        computeWidthsAndDepths(v, u, 0);
+    }
+    if (cancelled)
+        return;
+    LayoutTraversal traversal{preorder_nodes.data(), subtree_sizes.data(), widths.data(), preorder_nodes.size(), second_center, DELTA};
+    EngineOutput output{targets(), &framework_circles, &framework_wedges, &framework_rings};
+    runLayoutEngine(style, double_precision, recording(), traversal, output);
+    // the engine doesnt report as it goes, all of its nodes count once it is done
+    if (progress)
+        progress->nodes_done.fetch_add(static_cast<int>(preorder_nodes.size()), std::memory_order_relaxed);
+}
+
+void TreeLayout::beginProgressiveLayout(int rootID)
+{
+    resetLayoutState();
+    if (rootID == -1)
+    {
+        findCenter();
+    }
+    else
+    {
+        center_nodes.assign(1, rootID);
+    }
+    true_center_nodes = center_nodes;
+    // the engines place everything at once, and a copied subtree is placed whole off its
+    // source, so those are the whole layout done in one go
+    if (usesEngine() || share_subtrees)
+    {
+        layoutCenters();
+        finalizeLayout();
+        return;
+    }
+    complete = false;
+    placed_nodes.reserve(tree_ref.getNumVertices());
+
+    // widths are needed before anything can be placed, then the centers make up ring 0
+    if (center_nodes.size() == 1)
+    {
+        int root = center_nodes[0];
+        computeWidthsAndDepths(root, -1, 0);
+        targets()[root] = {0.0f, 0.0f};
+        placeNode(rootTask(root, -1, 0.0f, static_cast<float>(2 * M_PI), {0.0f, 0.0f}), root, next_ring);
+        placed_nodes.push_back(root);
+    }
+    else if (center_nodes.size() == 2)
+    {
+        int u = center_nodes[0];
+        int v = center_nodes[1];
+        targets()[u] = {-DELTA / 2.0f, 0.0f};
+        targets()[v] = {DELTA / 2.0f, 0.0f};
+        parent_map[v] = u;
+        parent_map[u] = v;
+        computeWidthsAndDepths(u, v, 0);
+        computeWidthsAndDepths(v, u, 0);
+        placeNode(rootTask(u, v, static_cast<float>(3 * M_PI / 2.0), static_cast<float>(M_PI / 2.0), targets()[v]), u, next_ring);
+        placeNode(rootTask(v, u, static_cast<float>(M_PI / 2.0), static_cast<float>(-M_PI / 2.0), targets()[u]), v, next_ring);
+        placed_nodes.push_back(u);
+        placed_nodes.push_back(v);
+    }
+    if (cancelled)
+        return;
+    storePolar(placed_nodes.data(), placed_nodes.size());
+    Point *positions = targets();
+    for (int u : placed_nodes)
+    {
+        positions[u].x += halfwidth;
+        positions[u].y += halfheight;
+    }
+    completed_nodes = placed_nodes.size();
+    // the colors depend on the final depth, which is already known
+    for (int u : preorder_nodes)
+    {
+        if (depths[u] > max_depth)
+            max_depth = depths[u];
+    }
+}
+
+bool TreeLayout::stepProgressiveLayout(double budget_ms)
+{
+    if (complete)
+        return true;
+    auto start = std::chrono::steady_clock::now();
+    int since_check = 0;
+    while (true)
+    {
+        if (ring_pos == ring.size())
+        {
+            // everything placed so far makes up whole rings
+            completed_nodes = placed_nodes.size();
+            if (!placed_nodes.empty())
+                completed_depth = depths[placed_nodes.back()];
+            if (next_ring.empty())
+                break;
+            ring.swap(next_ring);
+            next_ring.clear();
+            ring_pos = 0;
+        }
+        const LayoutTask &task = ring[ring_pos++];
+        placeNode(task, -1, next_ring);
+        // children were placed off the unshifted position, so this one can move to the screen now
+        storePolar(&task.u, 1);
+        targets()[task.u].x += halfwidth;
+        targets()[task.u].y += halfheight;
+        placed_nodes.push_back(task.u);
+
+        // reading the clock every node would cost more than placing it
+        if (++since_check == 256)
+        {
+            since_check = 0;
+            double millis = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() / 1e6;
+            if (millis >= budget_ms)
+                return false;
+        }
+    }
+
+    // done, the breadth first buffers arent needed anymore
+    complete = true;
+    std::vector<LayoutTask>().swap(ring);
+    std::vector<LayoutTask>().swap(next_ring);
+    std::vector<int>().swap(placed_nodes);
+    ring_pos = 0;
+    return true;
+}
+
+bool TreeLayout::isLayoutComplete() const { return complete; }
+int TreeLayout::getCompletedDepth() const { return completed_depth; }
+const std::vector<int> &TreeLayout::getPlacedNodes() const { return placed_nodes; }
+size_t TreeLayout::getNumCompletedNodes() const { return completed_nodes; }
+
 // lays out the tree starting from any node user chooses
 void TreeLayout::calculateLayoutFromRoot(int rootID)
 {
@@ -78,39 +748,153 @@ void TreeLayout::calculateLayoutFromRoot(int rootID)
     center_nodes.clear();
     center_nodes.push_back(rootID);
     true_center_nodes = center_nodes;
-
-    computeWidthsAndDepths(rootID, -1, 0);
-    target_positions[rootID] = {0.0f, 0.0f};
-    layoutSubTree(rootID, -1, 0.0f, 2 * M_PI);
+    layoutCenters();
     finalizeLayout();
 }
 
 float TreeLayout::getDelta() const { return DELTA; }
+void TreeLayout::setTrigMode(TrigMode mode) { trig_mode = mode; }
+TrigMode TreeLayout::getTrigMode() const { return trig_mode; }
+void TreeLayout::setShareSubtrees(bool share) { share_subtrees = share; }
+bool TreeLayout::getShareSubtrees() const { return share_subtrees; }
+void TreeLayout::setCompact(bool c) { compact = c; }
+bool TreeLayout::getCompact() const { return compact; }
+void TreeLayout::setBlueprint(bool keep) { blueprint = keep; }
+bool TreeLayout::getBlueprint() const { return blueprint; }
+void TreeLayout::setStyle(LayoutStyle new_style) { style = new_style; }
+LayoutStyle TreeLayout::getStyle() const { return style; }
+void TreeLayout::setDoublePrecision(bool use_double) { double_precision = use_double; }
+bool TreeLayout::getDoublePrecision() const { return double_precision; }
+
+FrameworkRecording TreeLayout::recording() const
+{
+    if (!blueprint)
+        return FrameworkRecording::NONE;
+    return compact ? FrameworkRecording::CIRCLES : FrameworkRecording::ALL;
+}
 float TreeLayout::getHalfWidth() const { return static_cast<float>(halfwidth); }
 float TreeLayout::getHalfHeight() const { return static_cast<float>(halfheight); }
+void TreeLayout::setOutput(Point *positions) { output_positions = positions; }
 const std::vector<Point> &TreeLayout::getTargetPositions() const { return target_positions; }
+const std::vector<PolarPoint> &TreeLayout::getPolarPositions() const { return polar_positions; }
+
+PolarPoint TreeLayout::getPolarPosition(int u) const
+{
+    if (!polar_positions.empty())
+        return polar_positions[u];
+    Point target = getTargetPosition(u);
+    float x = target.x - halfwidth, y = target.y - halfheight;
+    return {std::sqrt(x * x + y * y), std::atan2(y, x)};
+}
 const std::vector<int> &TreeLayout::getCenterNodes() const { return true_center_nodes; }
-const std::vector<int> &TreeLayout::getDepths() const { return depths; }
+const DepthArray &TreeLayout::getDepths() const { return depths; }
 const std::vector<int> &TreeLayout::getWidths() const { return widths; }
 int TreeLayout::getMaxDepth() const { return max_depth; }
 const std::vector<int> &TreeLayout::getParentMap() const { return parent_map; }
+const std::vector<int> &TreeLayout::getPreorderIndex() const { return preorder_index; }
+const std::vector<int> &TreeLayout::getPreorderNodes() const { return preorder_nodes; }
+const std::vector<int> &TreeLayout::getSubtreeSizes() const { return subtree_sizes; }
 const std::vector<std::vector<int>> &TreeLayout::getPruningGenerations() const { return pruning_generations; }
-const std::set<float> &TreeLayout::getFrameworkCircles() const { return framework_circles; }
+const std::vector<int> &TreeLayout::getPruneGenerations() const { return prune_generation; }
+const std::vector<float> &TreeLayout::getFrameworkCircles() const { return framework_circles; }
 const std::vector<Wedge> &TreeLayout::getFrameworkWedges() const { return framework_wedges; }
+const std::vector<FrameworkRing> &TreeLayout::getFrameworkRings() const { return framework_rings; }
+const std::vector<int> &TreeLayout::getShapeIds() const { return shape_ids; }
+int TreeLayout::getNumShapes() const { return static_cast<int>(shape_counts.size()); }
+const std::vector<SharedSubtree> &TreeLayout::getSharedSubtrees() const { return shared_subtrees; }
 
-void TreeLayout::setDelta(float newDelta)
+static size_t shapeHash(const int *key, size_t length)
 {
-    DELTA = newDelta;
-    if (center_nodes.size() == 1)
+    // fnv-1a over the ids
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < length; ++i)
     {
-        calculateLayoutFromRoot(center_nodes[0]);
+        hash ^= static_cast<uint32_t>(key[i]);
+        hash *= 1099511628211ull;
     }
-    else
+    return static_cast<size_t>(hash);
+}
+
+// the id of the shape with this key, a new one if no node had it yet
+int TreeLayout::numberShape(const int *key, size_t length)
+{
+    // at most half full, so the probes stay short
+    if (2 * (shape_counts.size() + 1) > shape_slots.size())
+    {
+        std::vector<int> slots(2 * shape_slots.size(), -1);
+        size_t mask = slots.size() - 1;
+        for (int id = 0; id < static_cast<int>(shape_counts.size()); ++id)
+        {
+            size_t slot = shapeHash(shape_keys.data() + shape_starts[id], shape_starts[id + 1] - shape_starts[id]) & mask;
+            while (slots[slot] != -1)
+                slot = (slot + 1) & mask;
+            slots[slot] = id;
+        }
+        shape_slots.swap(slots);
+    }
+    size_t mask = shape_slots.size() - 1;
+    for (size_t slot = shapeHash(key, length) & mask;; slot = (slot + 1) & mask)
+    {
+        int id = shape_slots[slot];
+        if (id == -1)
+        {
+            id = static_cast<int>(shape_counts.size());
+            shape_slots[slot] = id;
+            shape_keys.insert(shape_keys.end(), key, key + length);
+            shape_starts.push_back(static_cast<int>(shape_keys.size()));
+            shape_counts.push_back(0);
+            return id;
+        }
+        const int *other = shape_keys.data() + shape_starts[id];
+        if (static_cast<size_t>(shape_starts[id + 1] - shape_starts[id]) == length && std::equal(key, key + length, other))
+            return id;
+    }
+}
+
+void DepthArray::set(size_t u, int depth)
+{
+    if (narrow.empty())
+    {
+        wide[u] = depth;
+        return;
+    }
+    if (depth >= 0 && depth <= UINT16_MAX)
+    {
+        narrow[u] = static_cast<uint16_t>(depth);
+        return;
+    }
+    wide.assign(narrow.begin(), narrow.end());
+    std::vector<uint16_t>().swap(narrow);
+    widened = true;
+    wide[u] = depth;
+}
+
+void DepthArray::reset(size_t n, bool compact)
+{
+    // one that had to widen stays wide while the size stays the same, the next tree of that
+    // size is likely just as deep and narrowing it again would only allocate twice. a full
+    // layout in between ends that, the next compact one starts narrow again
+    if (compact != compact_mode)
+        widened = false;
+    compact_mode = compact;
+    if (compact && narrow.size() != n && !(widened && wide.size() == n))
     {
-        calculateTrueCenterLayout();
+        std::vector<int>().swap(wide);
+        widened = false;
+        narrow.assign(n, 0);
+    }
+    else if (!compact && wide.size() != n)
+    {
+        std::vector<uint16_t>().swap(narrow);
+        widened = false;
+        wide.assign(n, 0);
     }
 }
 
+size_t DepthArray::memoryUsage() const { return narrow.capacity() * sizeof(uint16_t) + wide.capacity() * sizeof(int); }
+
+void TreeLayout::setDelta(float newDelta) { DELTA = newDelta; }
+
 // gets all the steps for the leaf pruning animation
 void TreeLayout::prepareFindCenterAnimation()
 {
@@ -119,6 +903,8 @@ void TreeLayout::prepareFindCenterAnimation()
     std::vector<int> degree(n);
     std::vector<int> q;
     int remaining_nodes = n;
+    // tiny trees have no rounds at all, so their nodes are never pruned
+    prune_generation.assign(n, n);
     if (n <= 2)
         return;
     for (int i = 0; i < n; ++i)
@@ -147,6 +933,15 @@ void TreeLayout::prepareFindCenterAnimation()
         q = next_q;
     }
     pruning_generations.push_back(q);
+
+    // flatten it so the renderer can just compare each node against the current step
+    for (size_t g = 0; g < pruning_generations.size(); ++g)
+    {
+        for (int node_id : pruning_generations[g])
+        {
+            prune_generation[node_id] = static_cast<int>(g);
+        }
+    }
 }
 
 // finds the center of the tree by trimming leaves layer by layer
@@ -154,8 +949,6 @@ void TreeLayout::findCenter()
 {
     center_nodes.clear();
     int n = tree_ref.getNumVertices();
-    std::vector<int> degree(n);
-    std::vector<int> q;
     int remaining_nodes = n;
 
     // if the tree is tiny, all nodes are centers
@@ -165,107 +958,394 @@ void TreeLayout::findCenter()
             center_nodes.push_back(i);
         return;
     }
+    // nothing is numbered or measured yet, so the degrees count down in widths and the
+    // leaves of each round queue up one round after the other in preorder_nodes. every
+    // node becomes a leaf once, so that fits in what was reserved for it
+    std::vector<int> &degree = widths;
+    std::vector<int> &queue = preorder_nodes;
+    queue.clear();
     for (int i = 0; i < n; ++i)
     {
         degree[i] = tree_ref.getNeighbors(i).size();
         if (degree[i] == 1)
-            q.push_back(i);
+            queue.push_back(i);
     }
+    size_t round_start = 0;
     while (remaining_nodes > 2)
     {
-        int q_size = q.size();
-        if (q_size == 0)
+        size_t round_end = queue.size();
+        if (round_end == round_start)
             break;
-        remaining_nodes -= q_size;
-        std::vector<int> next_q;
-        for (int u : q)
+        remaining_nodes -= static_cast<int>(round_end - round_start);
+        for (size_t i = round_start; i < round_end; ++i)
         {
-            for (int v : tree_ref.getNeighbors(u))
+            for (int v : tree_ref.getNeighbors(queue[i]))
             {
                 degree[v]--;
                 if (degree[v] == 1)
-                    next_q.push_back(v);
+                    queue.push_back(v);
             }
         }
-        q = next_q;
+        round_start = round_end;
     }
-    center_nodes = q;
+    center_nodes.assign(queue.begin() + round_start, queue.end());
+    queue.clear();
 }
 
-void TreeLayout::computeWidthsAndDepths(int u, int p, int d)
+// walks the subtree with an explicit stack, so long paths cant overflow the call stack
+void TreeLayout::computeWidthsAndDepths(int root, int root_parent, int root_depth)
 {
-    parent_map[u] = p;
-    depths[u] = d;
-    bool is_leaf = true;
-    int leaf_count = 0;
-    for (int v : tree_ref.getNeighbors(u))
+    std::vector<WidthFrame> &stack = width_stack;
+    std::vector<int> &child_shapes = child_shapes_stack;
+    stack.clear();
+    child_shapes.clear();
+
+    // sets up a node on the way down, widths and sizes are added on the way back up
+    auto enter = [&](int u, int p, int d)
     {
-        if (v != p)
+        parent_map[u] = p;
+        depths.set(u, d);
+        // number the nodes in pre-order as we go down
+        preorder_index[u] = static_cast<int>(preorder_nodes.size());
+        preorder_nodes.push_back(u);
+        widths[u] = 0;
+        subtree_sizes[u] = 1;
+        // a collapsed node starts out of neighbors, so it ends up as a leaf
+        size_t next = (u != root && isCollapsed(u)) ? tree_ref.getNeighbors(u).size() : 0;
+        stack.push_back({u, p, next, child_shapes.size()});
+    };
+    enter(root, root_parent, root_depth);
+
+    while (!stack.empty())
+    {
+        WidthFrame &frame = stack.back();
+        NeighborRange neighbors = tree_ref.getNeighbors(frame.u);
+        if (frame.next < neighbors.size())
+        {
+            int v = neighbors[frame.next++];
+            if (v == frame.p)
+                continue;
+            if (checkpoint())
+                return;
+            enter(v, frame.u, depths[frame.u] + 1);
+        }
+        else
         {
-            is_leaf = false;
-            computeWidthsAndDepths(v, u, d + 1);
-            leaf_count += widths[v];
+            int u = frame.u, p = frame.p;
+            size_t first_shape = frame.first_shape;
+            stack.pop_back();
+            // width of a node is how many leaves are in its subtree
+            if (widths[u] == 0)
+                widths[u] = 1;
+            if (!shape_ids.empty())
+            {
+                // the same children in the same order make the same shape. a collapsed node
+                // is drawn differently from a leaf, so it gets a key no real node can have
+                if (u != root && isCollapsed(u))
+                    child_shapes.push_back(-1);
+                int id = numberShape(child_shapes.data() + first_shape, child_shapes.size() - first_shape);
+                shape_ids[u] = id;
+                shape_counts[id]++;
+                child_shapes.resize(first_shape);
+                child_shapes.push_back(id);
+            }
+            if (!stack.empty())
+            {
+                widths[p] += widths[u];
+                subtree_sizes[p] += subtree_sizes[u];
+            }
         }
     }
-    // width of a node is how many leaves are in its subtree
-    widths[u] = is_leaf ? 1 : leaf_count;
 }
 
-void TreeLayout::layoutSubTree(int u, int p, float alpha1, float alpha2)
+void TreeLayout::resetShapeSources()
 {
-    float current_radius;
-    // radius depends on whether we have one or two centers
-    if (center_nodes.size() == 1)
+    shape_sources.assign(shape_ids.empty() ? 0 : shape_counts.size(), -1);
+    source_spans.resize(shape_sources.size());
+    copy_budget = 0;
+}
+
+void TreeLayout::layoutSubTree(int root, int root_parent, float root_alpha1, float root_alpha2)
+{
+    switch (recording())
     {
-        current_radius = static_cast<float>(depths[u]) * DELTA;
+    case FrameworkRecording::NONE:
+        layoutSubTreeWith<FrameworkRecording::NONE>(root, root_parent, root_alpha1, root_alpha2);
+        break;
+    case FrameworkRecording::CIRCLES:
+        layoutSubTreeWith<FrameworkRecording::CIRCLES>(root, root_parent, root_alpha1, root_alpha2);
+        break;
+    case FrameworkRecording::ALL:
+        layoutSubTreeWith<FrameworkRecording::ALL>(root, root_parent, root_alpha1, root_alpha2);
+        break;
     }
-    else
+}
+
+template <FrameworkRecording Record>
+void TreeLayout::layoutSubTreeWith(int root, int root_parent, float root_alpha1, float root_alpha2)
+{
+    // nodes only depend on their parent, so a plain stack of pending children is enough
+    std::vector<LayoutTask> &stack = place_stack;
+    stack.clear();
+    Point root_parent_pos = (root_parent != -1) ? targets()[root_parent] : Point{0.0f, 0.0f};
+    stack.push_back(rootTask(root, root_parent, root_alpha1, root_alpha2, root_parent_pos));
+
+    while (!stack.empty())
+    {
+        LayoutTask task = stack.back();
+        stack.pop_back();
+        if (checkpoint())
+            return;
+        // the first subtree of a shape is placed node by node and every later one tries to be
+        // a copy of it. the stack is depth first, so a source is finished before any copy
+        if (!shape_ids.empty() && task.u != root && subtree_sizes[task.u] >= SHARED_MIN_SIZE && shape_counts[shape_ids[task.u]] > 1)
+        {
+            int shape = shape_ids[task.u];
+            if (shape_sources[shape] == -1)
+            {
+                shape_sources[shape] = task.u;
+                source_spans[shape] = task.span;
+            }
+            else if (copySubtree<Record>(task, shape_sources[shape], source_spans[shape]))
+            {
+                continue;
+            }
+        }
+        size_t first_child = stack.size();
+        placeNodeWith<Record>(task, root, stack);
+        copy_budget++;
+        // keep visiting children in the same order the recursion did
+        std::reverse(stack.begin() + first_child, stack.end());
+    }
+}
+
+// places task's node where its parent put it and everything below it by turning source's
+// subtree about source and moving it onto the node, no trig per node. the copy keeps every
+// edge delta long but not the rings, so it only goes ahead where it takes no more room than
+// its own layout would have. a subtree is about as wide as the span it gets, and the spans
+// below it narrow the further out it is, so that is a copy with at least source's span and no
+// further out. every subtree also stays inside the cone its span makes from the center, which
+// is checked node by node. returns false without touching anything but positions the caller
+// places anyway. the nodes a failed try looked at come out of copy_budget, which only grows
+// by the nodes placed one by one, so trying never costs more than the layout itself
+template <FrameworkRecording Record>
+bool TreeLayout::copySubtree(const LayoutTask &task, int source, float source_span)
+{
+    int u = task.u;
+    int size = subtree_sizes[u];
+    if (task.span >= M_PI || task.span < source_span * (1.0f - SPAN_NOISE) || size - 1 > copy_budget)
+        return false;
+    Point *positions = targets();
+    Point from = positions[source], to = task.pos;
+    float from_radius = sqrt(from.x * from.x + from.y * from.y), to_radius = sqrt(to.x * to.x + to.y * to.y);
+    if (from_radius == 0.0f || to_radius == 0.0f || to_radius > from_radius * (1.0f + SPAN_NOISE))
+        return false;
+    // the directions of both roots from the center, and the turn between them
+    float from_cos = from.x / from_radius, from_sin = from.y / from_radius;
+    float to_cos = to.x / to_radius, to_sin = to.y / to_radius;
+    float cosine = from_cos * to_cos + from_sin * to_sin;
+    float sine = from_cos * to_sin - from_sin * to_cos;
+    // a few ulps inside, far out floats cant tell a node on the edge of the cone from one past it
+    float slope = tan(task.span / 2.0f) - 16.0f * FLT_EPSILON;
+
+    // the two subtrees have the same shape, so their pre-order ranges match node for node
+    int first = preorder_index[u], source_first = preorder_index[source];
+    for (int i = 1; i < size; ++i)
     {
-        current_radius = (static_cast<float>(depths[u]) + 0.5f) * DELTA;
+        Point q = positions[preorder_nodes[source_first + i]];
+        // how far the node is from source along its direction and across it, which is the
+        // same from u once it is moved
+        float dx = q.x - from.x, dy = q.y - from.y;
+        float along = from_cos * dx + from_sin * dy, across = from_cos * dy - from_sin * dx;
+        float out = to_radius + along;
+        if (!(out > 0.0f && std::fabs(across) <= slope * out))
+        {
+            copy_budget -= i;
+            return false;
+        }
+        positions[preorder_nodes[first + i]] = {to.x + to_cos * along - to_sin * across, to.y + to_sin * along + to_cos * across};
     }
 
-    // places the current node based on its parent position and angle
-    if (p != -1)
+    float angle = atan2(sine, cosine);
+    positions[u] = to;
+    // a compact layout keeps no wedges
+    if (!node_wedges.empty())
+        node_wedges[u] = {task.alpha1, task.alpha2};
+    for (int i = 1; i < size && !node_wedges.empty(); ++i)
     {
-        float angle = (alpha1 + alpha2) / 2.0f;
-        Point parentPos = target_positions[p];
-        target_positions[u].x = parentPos.x + static_cast<float>(DELTA * cosf(angle));
-        target_positions[u].y = parentPos.y + static_cast<float>(DELTA * sinf(angle));
+        int v = preorder_nodes[first + i], w = preorder_nodes[source_first + i];
+        node_wedges[v] = {node_wedges[w].alpha1 + angle, node_wedges[w].alpha2 + angle};
+        // a copy has no rings of its own for the blueprint circles, but the wedges turn with it
+        if (Record != FrameworkRecording::ALL)
+            continue;
+        Point parent_pos = positions[parent_map[v]];
+        float parent_radius = sqrt(parent_pos.x * parent_pos.x + parent_pos.y * parent_pos.y);
+        framework_wedges.push_back({parent_pos, parent_radius + DELTA, node_wedges[v].alpha1, node_wedges[v].alpha2});
     }
+    // the turn about the center that leaves source where the copy is, less the move
+    Point offset = {to.x - (cosine * from.x - sine * from.y), to.y - (sine * from.x + cosine * from.y)};
+    shared_subtrees.push_back({u, source, angle, offset});
+    // progress counts nodes, the copied ones included
+    pending_steps += size - 1;
+    return true;
+}
 
-    // store the circle for drawing the layout framework
-    float layout_radius = sqrt(target_positions[u].x * target_positions[u].x + target_positions[u].y * target_positions[u].y);
-    framework_circles.insert(layout_radius + DELTA);
+LayoutTask TreeLayout::rootTask(int u, int p, float alpha1, float alpha2, Point parent_pos) const
+{
+    LayoutTask task{u, p, alpha1, alpha2, targets()[u], 0.0f, 0.0f};
+    if (p != -1)
+        placeSiblings(parent_pos, &task, 1, DELTA, trig_mode);
+    else
+        computeSpans(&task, 1, DELTA, trig_mode);
+    return task;
+}
 
-    // find the angular wedge this node has for its children
-    float tau_rho = 0.0f;
-    if (layout_radius + DELTA > 0)
+// the progressive steps place one node at a time, so they pick the instantiation per node
+void TreeLayout::placeNode(const LayoutTask &task, int root, std::vector<LayoutTask> &children)
+{
+    switch (recording())
     {
-        float acos_arg = std::min(1.0f, layout_radius / (layout_radius + DELTA));
-        tau_rho = 2.0f * acosf(acos_arg);
+    case FrameworkRecording::NONE:
+        placeNodeWith<FrameworkRecording::NONE>(task, root, children);
+        break;
+    case FrameworkRecording::CIRCLES:
+        placeNodeWith<FrameworkRecording::CIRCLES>(task, root, children);
+        break;
+    case FrameworkRecording::ALL:
+        placeNodeWith<FrameworkRecording::ALL>(task, root, children);
+        break;
     }
-    float total_angle = std::abs(alpha2 - alpha1);
-    float angle_center = atan2(target_positions[u].y, target_positions[u].x);
+}
+
+// places one node where its parent decided, then splits its wedge among its children and
+// queues them, already placed as one group. positions are around the origin, not shifted yet
+template <FrameworkRecording Record>
+void TreeLayout::placeNodeWith(const LayoutTask &task, int root, std::vector<LayoutTask> &children)
+{
+    int u = task.u, p = task.p;
+    if (!node_wedges.empty())
+        node_wedges[u] = {task.alpha1, task.alpha2};
+    targets()[u] = task.pos;
+    Point pos = task.pos;
 
-    float effective_angle = (total_angle < 2 * M_PI && tau_rho < total_angle) ? tau_rho : total_angle;
-    float start_alpha = angle_center - (effective_angle / 2.0f);
+    // store the circle for drawing the layout framework
+    float layout_radius = sqrt(pos.x * pos.x + pos.y * pos.y);
+    if (Record != FrameworkRecording::NONE)
+        framework_circles.push_back(layout_radius + DELTA);
 
-    float current_alpha = start_alpha;
+    // the subtree of a collapsed node is never laid out
+    if (u != root && isCollapsed(u))
+        return;
     // split the parent's wedge among the children based on their size
+    size_t first_child = children.size();
+    double width_before = 0.0;
     for (int v : tree_ref.getNeighbors(u))
     {
         if (v != p)
         {
             if (widths[u] == 0)
                 continue;
-            float wedge_angle = (static_cast<float>(widths[v]) / widths[u]) * effective_angle;
+            float alpha1 = shareStart(task.start_alpha, task.span, width_before, widths[u]);
+            width_before += widths[v];
+            float alpha2 = shareStart(task.start_alpha, task.span, width_before, widths[u]);
 
             // store the wedge for drawing the layout framework
-            Point parent_pos_local = target_positions[u];
-            framework_wedges.push_back({parent_pos_local, layout_radius + DELTA, current_alpha, current_alpha + wedge_angle});
+            if (Record == FrameworkRecording::ALL)
+                framework_wedges.push_back({pos, layout_radius + DELTA, alpha1, alpha2});
 
-            layoutSubTree(v, u, current_alpha, current_alpha + wedge_angle);
-            current_alpha += wedge_angle;
+            children.push_back({v, u, alpha1, alpha2, {0.0f, 0.0f}, 0.0f, 0.0f});
         }
     }
-}
\ No newline at end of file
+    placeSiblings(pos, children.data() + first_child, children.size() - first_child, DELTA, trig_mode);
+}
+
+// sibling groups go through the trig in chunks this big, so the arrays can live on the stack
+static const size_t TRIG_CHUNK = 64;
+
+static void sinCos(const float *angles, float *sines, float *cosines, size_t count, TrigMode mode)
+{
+    if (mode == TrigMode::FAST)
+    {
+        fastSinCos(angles, sines, cosines, count);
+        return;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        sines[i] = sinf(angles[i]);
+        cosines[i] = cosf(angles[i]);
+    }
+}
+
+void TreeLayout::placeSiblings(Point parent_pos, LayoutTask *tasks, size_t count, float delta, TrigMode mode)
+{
+    float angles[TRIG_CHUNK], sines[TRIG_CHUNK], cosines[TRIG_CHUNK];
+    for (size_t first = 0; first < count; first += TRIG_CHUNK)
+    {
+        LayoutTask *chunk = tasks + first;
+        size_t m = std::min(TRIG_CHUNK, count - first);
+        // each node sits at the middle of its wedge, one step further out than its parent
+        for (size_t i = 0; i < m; ++i)
+            angles[i] = (chunk[i].alpha1 + chunk[i].alpha2) / 2.0f;
+        sinCos(angles, sines, cosines, m, mode);
+        for (size_t i = 0; i < m; ++i)
+        {
+            chunk[i].pos.x = parent_pos.x + static_cast<float>(delta * cosines[i]);
+            chunk[i].pos.y = parent_pos.y + static_cast<float>(delta * sines[i]);
+        }
+    }
+    computeSpans(tasks, count, delta, mode);
+}
+
+void TreeLayout::computeSpans(LayoutTask *tasks, size_t count, float delta, TrigMode mode)
+{
+    float xs[TRIG_CHUNK], ys[TRIG_CHUNK], cosines[TRIG_CHUNK], arccosines[TRIG_CHUNK], centers[TRIG_CHUNK];
+    for (size_t first = 0; first < count; first += TRIG_CHUNK)
+    {
+        LayoutTask *chunk = tasks + first;
+        size_t m = std::min(TRIG_CHUNK, count - first);
+        for (size_t i = 0; i < m; ++i)
+        {
+            Point pos = chunk[i].pos;
+            xs[i] = pos.x;
+            ys[i] = pos.y;
+            // a node at radius 0 gets acos(1) = 0 here, the same as having no wedge of its own
+            float layout_radius = sqrt(pos.x * pos.x + pos.y * pos.y);
+            cosines[i] = layout_radius + delta > 0 ? std::min(1.0f, layout_radius / (layout_radius + delta)) : 1.0f;
+        }
+        if (mode == TrigMode::FAST)
+        {
+            fastAcos(cosines, arccosines, m);
+            fastAtan2(ys, xs, centers, m);
+        }
+        else
+        {
+            for (size_t i = 0; i < m; ++i)
+            {
+                arccosines[i] = acosf(cosines[i]);
+                centers[i] = atan2(ys[i], xs[i]);
+            }
+        }
+        // find the angular wedge each node has for its children
+        for (size_t i = 0; i < m; ++i)
+        {
+            float tau_rho = 2.0f * arccosines[i];
+            float total_angle = std::abs(chunk[i].alpha2 - chunk[i].alpha1);
+            // a node's children have to stay between the tangents from the center to its ring,
+            // that cone is what keeps every subtree clear of its neighbours. only a node on the
+            // center has no tangents. a lone child of a root at a leaf also gets a whole circle,
+            // but it sits off the center, and without the cap its children fold back over the root
+            bool capped = total_angle < 2 * M_PI || cosines[i] > 0.0f;
+            float effective_angle = (capped && tau_rho < total_angle) ? tau_rho : total_angle;
+            chunk[i].start_alpha = centers[i] - (effective_angle / 2.0f);
+            chunk[i].span = effective_angle;
+        }
+    }
+}
+
+Point TreeLayout::positionFromParent(Point parent_pos, AngleRange wedge, float delta, TrigMode mode)
+{
+    float angle = (wedge.alpha1 + wedge.alpha2) / 2.0f, sine, cosine;
+    sinCos(&angle, &sine, &cosine, 1, mode);
+    return {parent_pos.x + static_cast<float>(delta * cosine),
+            parent_pos.y + static_cast<float>(delta * sine)};
+}
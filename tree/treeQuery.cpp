@@ -0,0 +1,159 @@
+#include "include/treeQuery.h"
+#include <algorithm>
+
+TreeQuery::TreeQuery(const TreeLayout &layout) : layout_ref(layout), second_center(-1)
+{
+    const auto &order = layout.getPreorderNodes();
+    const auto &index = layout.getPreorderIndex();
+    int m = static_cast<int>(order.size());
+    const auto &centers = layout.getCenterNodes();
+    if (centers.size() == 2)
+        second_center = centers[1];
+    split = second_center != -1 ? index[second_center] : m;
+
+    // depths rooted at the first center, in pre-order so the table build reads them in order
+    const auto &depths = layout.getDepths();
+    pos_depth.resize(m);
+    for (int i = 0; i < m; ++i)
+        pos_depth[i] = depths[order[i]] + (i >= split ? 1 : 0);
+
+    log_table.assign(m + 1, 0);
+    for (int i = 2; i <= m; ++i)
+        log_table[i] = log_table[i / 2] + 1;
+
+    // sparse table for range minimum over depth in pre-order
+    int levels = m > 0 ? log_table[m] + 1 : 0;
+    sparse.resize(static_cast<size_t>(levels) * m);
+    for (int i = 0; i < m; ++i)
+        sparse[i] = i;
+    for (int k = 1; k < levels; ++k)
+    {
+        const int *prev = sparse.data() + static_cast<size_t>(k - 1) * m;
+        int *level = sparse.data() + static_cast<size_t>(k) * m;
+        int half = 1 << (k - 1);
+        for (int i = 0; i + (1 << k) <= m; ++i)
+            level[i] = shallower(prev[i], prev[i + half]);
+    }
+
+    // counting sort of the pre-order positions by depth
+    int max_depth = m > 0 ? *std::max_element(pos_depth.begin(), pos_depth.end()) : 0;
+    depth_start.assign(max_depth + 2, 0);
+    for (int d : pos_depth)
+        depth_start[d + 1]++;
+    for (int d = 1; d < static_cast<int>(depth_start.size()); ++d)
+        depth_start[d] += depth_start[d - 1];
+    by_depth.resize(m);
+    std::vector<int> fill(depth_start.begin(), depth_start.end() - 1);
+    for (int i = 0; i < m; ++i)
+        by_depth[fill[pos_depth[i]]++] = i;
+}
+
+bool TreeQuery::isVisible(int u) const
+{
+    return u >= 0 && u < static_cast<int>(layout_ref.getPreorderIndex().size()) && layout_ref.getPreorderIndex()[u] >= 0;
+}
+
+int TreeQuery::depth(int u) const
+{
+    if (!isVisible(u))
+        return -1;
+    return pos_depth[layout_ref.getPreorderIndex()[u]];
+}
+
+int TreeQuery::parent(int u) const
+{
+    // the two centers are each other's parent in the layout, only the second one really has one
+    const auto &centers = layout_ref.getCenterNodes();
+    if (second_center != -1 && u == centers[0])
+        return -1;
+    return layout_ref.getParentMap()[u];
+}
+
+int TreeQuery::shallower(int a, int b) const
+{
+    return pos_depth[b] < pos_depth[a] ? b : a;
+}
+
+// in pre-order, the shallowest node after u up to v is the child of the lca on the way to v
+int TreeQuery::lca(int u, int v) const
+{
+    if (!isVisible(u) || !isVisible(v))
+        return -1;
+    if (u == v)
+        return u;
+    const auto &index = layout_ref.getPreorderIndex();
+    int a = index[u], b = index[v];
+    if (a > b)
+        std::swap(a, b);
+    int m = static_cast<int>(layout_ref.getPreorderNodes().size());
+    int first = a + 1;
+    int k = log_table[b - a];
+    const int *level = sparse.data() + static_cast<size_t>(k) * m;
+    int child = shallower(level[first], level[b - (1 << k) + 1]);
+    return parent(layout_ref.getPreorderNodes()[child]);
+}
+
+int TreeQuery::distance(int u, int v) const
+{
+    int w = lca(u, v);
+    if (w == -1)
+        return -1;
+    return depth(u) + depth(v) - 2 * depth(w);
+}
+
+// the ancestor at depth d is the last node at that depth that comes before u in pre-order
+int TreeQuery::kthAncestor(int u, int k) const
+{
+    if (!isVisible(u) || k < 0)
+        return -1;
+    int d = depth(u) - k;
+    if (d < 0)
+        return -1;
+    const int *first = by_depth.data() + depth_start[d];
+    const int *last = by_depth.data() + depth_start[d + 1];
+    const int *it = std::upper_bound(first, last, layout_ref.getPreorderIndex()[u]);
+    return layout_ref.getPreorderNodes()[*(it - 1)];
+}
+
+std::vector<int> TreeQuery::path(int u, int v) const
+{
+    std::vector<int> nodes;
+    int w = lca(u, v);
+    if (w == -1)
+        return nodes;
+    // walk up from u to the lca, then up from v and append that part backwards
+    for (int x = u; x != w; x = parent(x))
+        nodes.push_back(x);
+    nodes.push_back(w);
+    size_t up_end = nodes.size();
+    for (int x = v; x != w; x = parent(x))
+        nodes.push_back(x);
+    std::reverse(nodes.begin() + up_end, nodes.end());
+    return nodes;
+}
+
+void TreeQuery::lcaBatch(const std::vector<std::pair<int, int>> &pairs, std::vector<int> &out) const
+{
+    out.resize(pairs.size());
+    for (size_t i = 0; i < pairs.size(); ++i)
+        out[i] = lca(pairs[i].first, pairs[i].second);
+}
+
+void TreeQuery::distanceBatch(const std::vector<std::pair<int, int>> &pairs, std::vector<int> &out) const
+{
+    out.resize(pairs.size());
+    for (size_t i = 0; i < pairs.size(); ++i)
+        out[i] = distance(pairs[i].first, pairs[i].second);
+}
+
+void TreeQuery::kthAncestorBatch(const std::vector<std::pair<int, int>> &queries, std::vector<int> &out) const
+{
+    out.resize(queries.size());
+    for (size_t i = 0; i < queries.size(); ++i)
+        out[i] = kthAncestor(queries[i].first, queries[i].second);
+}
+
+size_t TreeQuery::memoryUsage() const
+{
+    return (sparse.capacity() + pos_depth.capacity() + by_depth.capacity() + depth_start.capacity()) * sizeof(int) + log_table.capacity();
+}
@@ -1,9 +1,14 @@
 #include "include/treeRenderer.h"
-#include <set>
 #include <algorithm>
 
 TreeRenderer::TreeRenderer(const Tree &tree, const TreeLayout &layout)
-    : tree_ref(tree), layout_ref(layout) {}
+    : tree_ref(tree), layout_ref(layout), highlight_ready(false), instances_ready(false) {}
+
+TreeRenderer::~TreeRenderer()
+{
+    for (const auto &mesh : meshes)
+        glDeleteLists(mesh.second, 1);
+}
 
 void TreeRenderer::drawFramework(const std::vector<Point> &positions)
 {
@@ -28,64 +33,262 @@ void TreeRenderer::drawFramework(const std::vector<Point> &positions)
         Drawing::drawLine(center, start);
         Drawing::drawLine(center, end);
     }
+    // the balloon layout has a circle around every node with children instead
+    for (const auto &ring : layout_ref.getFrameworkRings())
+    {
+        glColor3f(0.2f, 0.2f, 0.3f);
+        Drawing::drawCircleOutline({screenCenter.x + ring.center.x, screenCenter.y + ring.center.y}, ring.radius);
+    }
 }
 
-void TreeRenderer::highlightSubtree(int u, const std::vector<Point> &positions)
+// the layout doesnt change once the renderer has it, so this only runs on the first hover
+void TreeRenderer::buildHighlightBuffers()
 {
-    glColor3f(1.0f, 0.5f, 0.0f);
-    Drawing::drawFilledCircle(positions[u], 8);
+    const auto &positions = layout_ref.getTargetPositions();
+    const auto &order = layout_ref.getPreorderNodes();
     const auto &parent_map = layout_ref.getParentMap();
+    highlight_nodes.resize(order.size());
+    highlight_edges.resize(order.size() * 2);
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        int u = order[i];
+        int p = parent_map[u];
+        highlight_nodes[i] = positions[u];
+        // roots get a zero length edge so every node owns exactly two vertices
+        highlight_edges[2 * i] = positions[u];
+        highlight_edges[2 * i + 1] = (p == -1) ? positions[u] : positions[p];
+    }
+    highlight_ready = true;
+}
+
+void TreeRenderer::highlightSubtree(int u)
+{
+    int first = layout_ref.getPreorderIndex()[u];
+    if (first < 0)
+        return;
 
-    for (int v : tree_ref.getNeighbors(u))
+    glColor3f(1.0f, 0.5f, 0.0f);
+    // a compact layout has no room for three more positions per node, so the highlight is
+    // sent vertex by vertex straight from the layout. slower, but it only needs a point per
+    // level of the subtree
+    if (layout_ref.getCompact())
     {
-        //  check to avoid getting stuck in a loop with two center nodes
-        if (parent_map.at(v) == u && parent_map.at(u) != v)
-        {
-            glColor3f(1.0f, 0.5f, 0.0f);
-            Drawing::drawLine(positions[u], positions[v]);
-            highlightSubtree(v, positions);
-        }
+        glBegin(GL_LINES);
+        layout_ref.visitSubtreeTargets(u, level_positions, [u](int v, Point pos, Point parent_pos)
+                                       {
+                                           if (v == u)
+                                               return;
+                                           glVertex2f(pos.x, pos.y);
+                                           glVertex2f(parent_pos.x, parent_pos.y);
+                                       });
+        glEnd();
+        glEnable(GL_POINT_SMOOTH);
+        glPointSize(16.0f);
+        glBegin(GL_POINTS);
+        layout_ref.visitSubtreeTargets(u, level_positions, [](int, Point pos, Point)
+                                       { glVertex2f(pos.x, pos.y); });
+        glEnd();
+        glPointSize(1.0f);
+        glDisable(GL_POINT_SMOOTH);
+        return;
+    }
+    if (!highlight_ready)
+        buildHighlightBuffers();
+    int count = layout_ref.getSubtreeSize(u);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    // skip the edge from u to its own parent, it isnt part of the subtree
+    glVertexPointer(2, GL_FLOAT, 0, highlight_edges.data());
+    glDrawArrays(GL_LINES, 2 * (first + 1), 2 * (count - 1));
+    glVertexPointer(2, GL_FLOAT, 0, highlight_nodes.data());
+    glEnable(GL_POINT_SMOOTH);
+    glPointSize(16.0f);
+    glDrawArrays(GL_POINTS, first, count);
+    glPointSize(1.0f);
+    glDisable(GL_POINT_SMOOTH);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+void TreeRenderer::highlightPath(const std::vector<Point> &positions, const std::vector<int> &path)
+{
+    path_vertices.resize(path.size());
+    for (size_t i = 0; i < path.size(); ++i)
+        path_vertices[i] = positions[path[i]];
+
+    glColor3f(0.2f, 1.0f, 0.4f);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 0, path_vertices.data());
+    glLineWidth(3.0f);
+    glDrawArrays(GL_LINE_STRIP, 0, static_cast<GLsizei>(path_vertices.size()));
+    glLineWidth(1.0f);
+    glEnable(GL_POINT_SMOOTH);
+    glPointSize(12.0f);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(path_vertices.size()));
+    glPointSize(1.0f);
+    glDisable(GL_POINT_SMOOTH);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+void TreeRenderer::drawLabels(LabelRenderer &labels, const std::vector<Point> &positions, const ViewTransform &view, int width, int height)
+{
+    labels.addNodeLabels(positions, visibleNodes(), layout_ref.getDepths(), view, 0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height));
+    labels.flush(0.85f, 0.85f, 0.85f);
+}
+
+size_t TreeRenderer::memoryUsage() const
+{
+    return (highlight_nodes.capacity() + highlight_edges.capacity() + path_vertices.capacity() + level_positions.capacity()) * sizeof(Point) +
+           instance_of.capacity() * sizeof(int) + meshes.size() * (sizeof(std::pair<int, int>) + sizeof(GLuint) + 4 * sizeof(void *));
+}
+
+// the nodes worth drawing, while a progressive layout runs that is just the finished rings
+NeighborRange TreeRenderer::visibleNodes() const
+{
+    const auto &order = layout_ref.isLayoutComplete() ? layout_ref.getPreorderNodes() : layout_ref.getPlacedNodes();
+    size_t count = layout_ref.isLayoutComplete() ? order.size() : layout_ref.getNumCompletedNodes();
+    return {order.data(), order.data() + count};
+}
+
+// edges from every visible node to its parent, collapsed subtrees are never walked.
+// instanced subtrees bring their own edges, only the one up to their parent is drawn here
+void TreeRenderer::drawVisibleEdges(const std::vector<Point> &positions, bool instanced)
+{
+    const auto &index = layout_ref.getPreorderIndex();
+    const auto &parents = layout_ref.getParentMap();
+    NeighborRange visible_nodes = visibleNodes();
+    glColor3f(0.6f, 0.6f, 0.6f);
+    for (size_t i = 0; i < visible_nodes.size(); ++i)
+    {
+        int u = visible_nodes[i];
+        int p = parents[u];
+        // two centers are each other's parent, only draw that edge once
+        if (p != -1 && index[p] < index[u])
+            Drawing::drawLine(positions[p], positions[u]);
+        if (instanced && instance_of[u] != -1)
+            i += layout_ref.getSubtreeSize(u) - 1;
     }
 }
 
-void TreeRenderer::draw(const std::vector<Point> &current_positions, int hoveredNodeID, bool showFramework, DrawState state, int animationStep)
+// a regular node, colored by depth, with a ring if its subtree is hidden
+void TreeRenderer::drawNode(int u, Point pos, int depth_shift) const
+{
+    if (layout_ref.isCollapsed(u))
+    {
+        glColor3f(1.0f, 0.5f, 0.0f);
+        Drawing::drawCircleOutline(pos, 11);
+    }
+    const auto &true_center_nodes = layout_ref.getCenterNodes();
+    if (std::find(true_center_nodes.begin(), true_center_nodes.end(), u) != true_center_nodes.end())
+    {
+        // highlight the true center nodes in white
+        glColor3f(1.0f, 1.0f, 1.0f);
+        Drawing::drawFilledCircle(pos, 9);
+        return;
+    }
+    // we color the nodes based on their depth, making a nice gradient
+    const auto &depths = layout_ref.getDepths();
+    int max_depth = layout_ref.getMaxDepth();
+    int depth = depths[u] + depth_shift;
+    float t = (max_depth > 1) ? static_cast<float>(std::max(0, depth - 1)) / (max_depth - 1) : (depth > 0 ? 1.0f : 0.0f);
+    Color start_color = {1.0f, 1.0f, 0.0f}, end_color = {0.1f, 0.4f, 1.0f};
+    Color node_color;
+    node_color.r = start_color.r * (1.0f - t) + end_color.r * t;
+    node_color.g = start_color.g * (1.0f - t) + end_color.g * t;
+    node_color.b = start_color.b * (1.0f - t) + end_color.b * t;
+    glColor3f(node_color.r, node_color.g, node_color.b);
+    Drawing::drawFilledCircle(pos, 7);
+}
+
+// every copy the layout made is drawn as an instance of its source
+void TreeRenderer::buildInstances()
+{
+    const auto &shared = layout_ref.getSharedSubtrees();
+    instance_of.assign(tree_ref.getNumVertices(), -1);
+    for (size_t i = 0; i < shared.size(); ++i)
+        instance_of[shared[i].root] = static_cast<int>(i);
+    instances_ready = true;
+}
+
+// the source subtree goes into a display list around the layout center, colored for a copy
+// whose root is at depth, then every such copy is that list moved into place. the edges are
+// gl lines instead of bresenham pixels, which would break up once turned
+GLuint TreeRenderer::buildMesh(int source, int depth)
+{
+    auto it = meshes.find({source, depth});
+    if (it != meshes.end())
+        return it->second;
+    int depth_shift = depth - layout_ref.getDepths()[source];
+    float cx = layout_ref.getHalfWidth(), cy = layout_ref.getHalfHeight();
+
+    GLuint list = glGenLists(1);
+    glNewList(list, GL_COMPILE);
+    glColor3f(0.6f, 0.6f, 0.6f);
+    glBegin(GL_LINES);
+    layout_ref.visitSubtreeTargets(source, level_positions, [&](int v, Point pos, Point parent_pos)
+                                   {
+                                       if (v == source)
+                                           return;
+                                       glVertex2f(parent_pos.x - cx, parent_pos.y - cy);
+                                       glVertex2f(pos.x - cx, pos.y - cy);
+                                   });
+    glEnd();
+    layout_ref.visitSubtreeTargets(source, level_positions, [&](int v, Point pos, Point)
+                                   { drawNode(v, {pos.x - cx, pos.y - cy}, depth_shift); });
+    glEndList();
+    meshes.emplace(std::make_pair(source, depth), list);
+    return list;
+}
+
+void TreeRenderer::drawInstance(const SharedSubtree &shared)
+{
+    float cx = layout_ref.getHalfWidth(), cy = layout_ref.getHalfHeight();
+    GLuint list = buildMesh(shared.source, layout_ref.getDepths()[shared.root]);
+    glPushMatrix();
+    glTranslatef(cx + shared.offset.x, cy + shared.offset.y, 0.0f);
+    glRotatef(shared.angle * 180.0f / static_cast<float>(M_PI), 0.0f, 0.0f, 1.0f);
+    glCallList(list);
+    glPopMatrix();
+}
+
+// everything the first hover or the first frame at rest would otherwise build on the spot.
+// a layout still being placed gets it later, once it is complete
+void TreeRenderer::prepare()
+{
+    if (!layout_ref.isLayoutComplete())
+        return;
+    if (!highlight_ready && !layout_ref.getCompact())
+        buildHighlightBuffers();
+    const auto &shared = layout_ref.getSharedSubtrees();
+    if (shared.empty() || instances_ready)
+        return;
+    buildInstances();
+    for (const auto &copy : shared)
+        buildMesh(copy.source, layout_ref.getDepths()[copy.root]);
+}
+
+void TreeRenderer::draw(const std::vector<Point> &current_positions, int hoveredNodeID, bool showFramework, DrawState state, float animationStep, bool atRest)
 {
     if (showFramework)
     {
         drawFramework(current_positions);
     }
+    NeighborRange visible_nodes = visibleNodes();
 
     if (state == DrawState::ANIMATING_FIND_CENTER)
     {
         const auto &pruning_generations = layout_ref.getPruningGenerations();
-        std::set<int> pruned_nodes;
-        // figure out which nodes have been pruned so far based
-        for (int i = 0; i < animationStep && i < pruning_generations.size(); ++i)
-        {
-            for (int node_id : pruning_generations[i])
-            {
-                pruned_nodes.insert(node_id);
-            }
-        }
+        const auto &prune_generation = layout_ref.getPruneGenerations();
+        // how much of a step it takes a pruned node to fade to gray
+        const float fade_steps = 0.5f;
 
         // draw all the edges first
-        for (const auto &edge : tree_ref.getEdges())
-        {
-            glColor3f(0.6f, 0.6f, 0.6f);
-            Drawing::drawLine(current_positions[edge.first], current_positions[edge.second]);
-        }
+        drawVisibleEdges(current_positions, false);
 
-        // draw the nodes, graying out the pruned ones
-        for (int i = 0; i < tree_ref.getNumVertices(); ++i)
+        // draw the nodes, a node from generation g fades to gray at the start of step g + 1
+        for (int i : visible_nodes)
         {
-            if (pruned_nodes.count(i))
-            {
-                glColor4f(0.5f, 0.5f, 0.5f, 0.2f);
-            }
-            else
-            {
-                glColor3f(1.0f, 1.0f, 0.0f);
-            }
+            float t = (animationStep - prune_generation[i] - 1.0f) / fade_steps;
+            t = std::min(1.0f, std::max(0.0f, t));
+            glColor4f(1.0f - 0.5f * t, 1.0f - 0.5f * t, 0.5f * t, 1.0f - 0.8f * t);
             Drawing::drawFilledCircle(current_positions[i], 6);
         }
         // highlight the final center nodes
@@ -93,6 +296,8 @@ void TreeRenderer::draw(const std::vector<Point> &current_positions, int hovered
         {
             for (int center_id : pruning_generations.back())
             {
+                if (layout_ref.getPreorderIndex()[center_id] < 0)
+                    continue;
                 glColor3f(1.0f, 1.0f, 1.0f);
                 Drawing::drawFilledCircle(current_positions[center_id], 9);
             }
@@ -100,50 +305,27 @@ void TreeRenderer::draw(const std::vector<Point> &current_positions, int hovered
     }
     else
     {
-        for (const auto &edge : tree_ref.getEdges())
-        {
-            glColor3f(0.6f, 0.6f, 0.6f);
-            Drawing::drawLine(current_positions[edge.first], current_positions[edge.second]);
-        }
+        // copies only line up with their source once everything has arrived
+        bool instanced = atRest && layout_ref.isLayoutComplete() && !layout_ref.getSharedSubtrees().empty();
+        if (instanced && !instances_ready)
+            buildInstances();
+        drawVisibleEdges(current_positions, instanced);
 
-        const auto &depths = layout_ref.getDepths();
-        const auto &true_center_nodes = layout_ref.getCenterNodes();
-        int max_depth = layout_ref.getMaxDepth();
-
-        for (int i = 0; i < tree_ref.getNumVertices(); ++i)
+        for (size_t k = 0; k < visible_nodes.size(); ++k)
         {
-            bool isTrueCentralNode = false;
-            for (int central_id : true_center_nodes)
-            {
-                if (i == central_id)
-                {
-                    isTrueCentralNode = true;
-                    break;
-                }
-            }
-            if (isTrueCentralNode)
-            {
-                // highlight the true center nodes in white
-                glColor3f(1.0f, 1.0f, 1.0f);
-                Drawing::drawFilledCircle(current_positions[i], 9);
-            }
-            else
+            int i = visible_nodes[k];
+            if (instanced && instance_of[i] != -1)
             {
-                // we color the nodes based on their depth, making a nice gradient
-                float t = (max_depth > 1) ? static_cast<float>(std::max(0, depths[i] - 1)) / (max_depth - 1) : (depths[i] > 0 ? 1.0f : 0.0f);
-                Color start_color = {1.0f, 1.0f, 0.0f}, end_color = {0.1f, 0.4f, 1.0f};
-                Color node_color;
-                node_color.r = start_color.r * (1.0f - t) + end_color.r * t;
-                node_color.g = start_color.g * (1.0f - t) + end_color.g * t;
-                node_color.b = start_color.b * (1.0f - t) + end_color.b * t;
-                glColor3f(node_color.r, node_color.g, node_color.b);
-                Drawing::drawFilledCircle(current_positions[i], 7);
+                drawInstance(layout_ref.getSharedSubtrees()[instance_of[i]]);
+                k += layout_ref.getSubtreeSize(i) - 1;
+                continue;
             }
+            drawNode(i, current_positions[i]);
         }
         // highlight hovered node's subtree
         if (hoveredNodeID != -1)
         {
-            highlightSubtree(hoveredNodeID, current_positions);
+            highlightSubtree(hoveredNodeID);
         }
     }
 }
\ No newline at end of file
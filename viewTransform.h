@@ -0,0 +1,63 @@
+#pragma once
+
+#include "graphics.h"
+#include <cmath>
+
+// how the layout gets onto the screen: turned and scaled about the layout center, which then
+// lands on the anchor. the layout itself never changes for any of this, so spinning, zooming
+// out, panning and resizing the window only touch these few numbers
+class ViewTransform
+{
+public:
+    ViewTransform() : center({0.0f, 0.0f}), anchor({0.0f, 0.0f}), angle(0.0f), scale(1.0f), cos_a(1.0f), sin_a(0.0f) {}
+
+    // the layout's center in its own coordinates and where on screen it should go
+    void setCenter(Point c) { center = c; }
+    void setAnchor(Point a) { anchor = a; }
+    void setAngle(float radians)
+    {
+        // keep it in -pi..pi so spinning around for a while doesnt lose precision
+        angle = std::remainder(radians, 2.0f * PI);
+        cos_a = std::cos(angle);
+        sin_a = std::sin(angle);
+    }
+    void setScale(float s) { scale = s; }
+    Point getAnchor() const { return anchor; }
+    float getAngle() const { return angle; }
+    float getScale() const { return scale; }
+
+    // puts the whole transform on the current gl matrix, the gpu applies it to every vertex
+    void apply() const
+    {
+        glTranslatef(anchor.x, anchor.y, 0.0f);
+        glRotatef(angle * 180.0f / PI, 0.0f, 0.0f, 1.0f);
+        glScalef(scale, scale, 1.0f);
+        glTranslatef(-center.x, -center.y, 0.0f);
+    }
+
+    Point toScreen(Point p) const
+    {
+        float x = (p.x - center.x) * scale, y = (p.y - center.y) * scale;
+        return {anchor.x + cos_a * x - sin_a * y, anchor.y + sin_a * x + cos_a * y};
+    }
+
+    // the other way round, for finding what is under the mouse
+    Point toLayout(Point p) const
+    {
+        float x = p.x - anchor.x, y = p.y - anchor.y;
+        return {center.x + (cos_a * x + sin_a * y) / scale, center.y + (cos_a * y - sin_a * x) / scale};
+    }
+
+    bool operator==(const ViewTransform &other) const
+    {
+        return center.x == other.center.x && center.y == other.center.y && anchor.x == other.anchor.x &&
+               anchor.y == other.anchor.y && angle == other.angle && scale == other.scale;
+    }
+
+private:
+    static constexpr float PI = 3.14159265358979f;
+
+    Point center, anchor;
+    float angle, scale;
+    float cos_a, sin_a;
+};